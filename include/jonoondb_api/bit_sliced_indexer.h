@@ -0,0 +1,386 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "sort_utils.h"
+#include "null_helpers.h"
+
+namespace jonoondb_api {
+// Bit-sliced index for integer and floating point columns. Each value is
+// mapped to an order preserving 64 bit key and bit b of the key for every
+// document is stored in slice b. A comparison against a constant walks the
+// slices from the most significant bit down, so any range predicate costs
+// at most 64 word operations per 64 documents regardless of how many
+// distinct values fall in the range.
+class BitSlicedIndexer final: public Indexer {
+ public:
+  BitSlicedIndexer(const IndexInfoImpl& indexInfo,
+                   const FieldType& fieldType) : m_documentCount(0) {
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (indexInfo.GetColumnName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty column name.";
+    } else if (indexInfo.GetType() != IndexType::BIT_SLICED) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType BIT_SLICED for BitSlicedIndexer.";
+    } else if (!IsValidFieldType(fieldType)) {
+      std::ostringstream ss;
+      ss << "Argument fieldType " << GetFieldString(fieldType)
+          << " is not valid for BitSlicedIndexer.";
+      errorMsg = ss.str();
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_fieldNameTokens = StringUtils::Split(indexInfo.GetColumnName(), ".");
+    m_indexStat = IndexStat(indexInfo, fieldType);
+    m_isDouble = (fieldType == FieldType::BASE_TYPE_FLOAT32 ||
+        fieldType == FieldType::BASE_TYPE_DOUBLE);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_INT8
+        || fieldType == FieldType::BASE_TYPE_INT16
+        || fieldType == FieldType::BASE_TYPE_INT32
+        || fieldType == FieldType::BASE_TYPE_INT64
+        || fieldType == FieldType::BASE_TYPE_FLOAT32
+        || fieldType == FieldType::BASE_TYPE_DOUBLE);
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    assert(m_documentCount == documentID);
+    std::uint64_t key;
+    bool isNull;
+    if (m_isDouble) {
+      auto val =
+          DocumentUtils::GetFloatValue(document, m_subDoc, m_fieldNameTokens);
+      isNull = NullHelpers::IsNull(val);
+      if (isNull) {
+        m_indexStat.GetStatistics().AddNull();
+      } else {
+        m_indexStat.GetStatistics().AddValue(val);
+      }
+      key = SortUtils::ToSortableKey(val);
+    } else {
+      auto val = DocumentUtils::GetIntegerValue(document, m_subDoc,
+                                                m_fieldNameTokens);
+      isNull = NullHelpers::IsNull(val);
+      if (isNull) {
+        m_indexStat.GetStatistics().AddNull();
+      } else {
+        m_indexStat.GetStatistics().AddValue(val);
+      }
+      key = SortUtils::ToSortableKey(val);
+    }
+
+    auto block = documentID / 64;
+    if (block * SLICE_COUNT == m_slices.size()) {
+      m_slices.resize(m_slices.size() + SLICE_COUNT, 0);
+      m_nulls.push_back(0);
+    }
+
+    std::uint64_t* slices = &m_slices[block * SLICE_COUNT];
+    std::uint64_t mask = std::uint64_t(1) << (documentID % 64);
+    if (isNull) {
+      m_nulls[block] |= mask;
+    }
+    for (int bit = 0; bit < SLICE_COUNT; bit++) {
+      if ((key >> bit) & 1) {
+        slices[bit] |= mask;
+      }
+    }
+    m_documentCount++;
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    switch (constraint.op) {
+      case jonoondb_api::IndexConstraintOperator::EQUAL:
+      case jonoondb_api::IndexConstraintOperator::LESS_THAN:
+      case jonoondb_api::IndexConstraintOperator::LESS_THAN_EQUAL:
+      case jonoondb_api::IndexConstraintOperator::GREATER_THAN:
+      case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL: {
+        std::uint64_t lowerKey = 0;
+        std::uint64_t upperKey = std::numeric_limits<std::uint64_t>::max();
+        if (!ApplyConstraint(constraint, lowerKey, upperKey)) {
+          return std::make_shared<MamaJenniesBitmap>();
+        }
+        return GetBitmapBetween(lowerKey, upperKey);
+      }
+      default:
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator type "
+            << static_cast<std::int32_t>(constraint.op) << " is not valid.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    std::uint64_t lowerKey = 0;
+    std::uint64_t upperKey = std::numeric_limits<std::uint64_t>::max();
+    if (!ApplyConstraint(lowerConstraint, lowerKey, upperKey) ||
+        !ApplyConstraint(upperConstraint, lowerKey, upperKey)) {
+      return std::make_shared<MamaJenniesBitmap>();
+    }
+
+    return GetBitmapBetween(lowerKey, upperKey);
+  }
+
+ private:
+  static const int SLICE_COUNT = 64;
+
+  // Narrows the inclusive key range [lowerKey, upperKey] with the
+  // constraint. Returns false if no key can satisfy the constraint.
+  bool ApplyConstraint(const Constraint& constraint, std::uint64_t& lowerKey,
+                       std::uint64_t& upperKey) {
+    std::uint64_t lower = 0;
+    std::uint64_t upper = std::numeric_limits<std::uint64_t>::max();
+    bool valid = m_isDouble ?
+        GetDoubleKeyRange(constraint, lower, upper) :
+        GetIntegerKeyRange(constraint, lower, upper);
+    if (!valid) {
+      return false;
+    }
+
+    lowerKey = std::max(lowerKey, lower);
+    upperKey = std::min(upperKey, upper);
+    return lowerKey <= upperKey;
+  }
+
+  static bool GetDoubleKeyRange(const Constraint& constraint,
+                                std::uint64_t& lowerKey,
+                                std::uint64_t& upperKey) {
+    double val;
+    if (constraint.operandType == OperandType::INTEGER) {
+      val = static_cast<double>(constraint.operand.int64Val);
+    } else if (constraint.operandType == OperandType::DOUBLE) {
+      val = constraint.operand.doubleVal;
+    } else {
+      return false;
+    }
+
+    if (std::isnan(val)) {
+      return false;
+    }
+
+    // Keys are consecutive for adjacent doubles so a strict bound is the
+    // key of the operand +/- 1.
+    auto key = SortUtils::ToSortableKey(val);
+    switch (constraint.op) {
+      case IndexConstraintOperator::EQUAL:
+        lowerKey = upperKey = key;
+        return true;
+      case IndexConstraintOperator::LESS_THAN:
+        if (key == 0) {
+          return false;
+        }
+        upperKey = key - 1;
+        return true;
+      case IndexConstraintOperator::LESS_THAN_EQUAL:
+        upperKey = key;
+        return true;
+      case IndexConstraintOperator::GREATER_THAN:
+        if (key == std::numeric_limits<std::uint64_t>::max()) {
+          return false;
+        }
+        lowerKey = key + 1;
+        return true;
+      case IndexConstraintOperator::GREATER_THAN_EQUAL:
+        lowerKey = key;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  static bool GetIntegerKeyRange(const Constraint& constraint,
+                                 std::uint64_t& lowerKey,
+                                 std::uint64_t& upperKey) {
+    const std::int64_t minVal = std::numeric_limits<std::int64_t>::min();
+    const std::int64_t maxVal = std::numeric_limits<std::int64_t>::max();
+    // 2^63 and -2^63 are exactly representable as double
+    const double maxValPlusOne = 9223372036854775808.0;
+    const double minValDouble = -9223372036854775808.0;
+    std::int64_t lower = minVal, upper = maxVal;
+
+    if (constraint.operandType == OperandType::INTEGER) {
+      auto val = constraint.operand.int64Val;
+      switch (constraint.op) {
+        case IndexConstraintOperator::EQUAL:
+          lower = upper = val;
+          break;
+        case IndexConstraintOperator::LESS_THAN:
+          if (val == minVal) {
+            return false;
+          }
+          upper = val - 1;
+          break;
+        case IndexConstraintOperator::LESS_THAN_EQUAL:
+          upper = val;
+          break;
+        case IndexConstraintOperator::GREATER_THAN:
+          if (val == maxVal) {
+            return false;
+          }
+          lower = val + 1;
+          break;
+        case IndexConstraintOperator::GREATER_THAN_EQUAL:
+          lower = val;
+          break;
+        default:
+          return false;
+      }
+    } else if (constraint.operandType == OperandType::DOUBLE) {
+      auto val = constraint.operand.doubleVal;
+      if (std::isnan(val)) {
+        return false;
+      }
+
+      switch (constraint.op) {
+        case IndexConstraintOperator::EQUAL:
+          if (val != std::floor(val) || val < minValDouble ||
+              val >= maxValPlusOne) {
+            return false;
+          }
+          lower = upper = static_cast<std::int64_t>(val);
+          break;
+        case IndexConstraintOperator::LESS_THAN: {
+          auto ceiling = std::ceil(val);
+          if (ceiling <= minValDouble) {
+            return false;
+          }
+          if (ceiling < maxValPlusOne) {
+            upper = static_cast<std::int64_t>(ceiling) - 1;
+          }
+          break;
+        }
+        case IndexConstraintOperator::LESS_THAN_EQUAL: {
+          auto floor = std::floor(val);
+          if (floor < minValDouble) {
+            return false;
+          }
+          if (floor < maxValPlusOne) {
+            upper = static_cast<std::int64_t>(floor);
+          }
+          break;
+        }
+        case IndexConstraintOperator::GREATER_THAN: {
+          auto floor = std::floor(val);
+          if (floor >= maxValPlusOne) {
+            return false;
+          }
+          if (floor >= minValDouble) {
+            auto intVal = static_cast<std::int64_t>(floor);
+            if (intVal == maxVal) {
+              return false;
+            }
+            lower = intVal + 1;
+          }
+          break;
+        }
+        case IndexConstraintOperator::GREATER_THAN_EQUAL: {
+          auto ceiling = std::ceil(val);
+          if (ceiling >= maxValPlusOne) {
+            return false;
+          }
+          if (ceiling > minValDouble) {
+            lower = static_cast<std::int64_t>(ceiling);
+          }
+          break;
+        }
+        default:
+          return false;
+      }
+    } else {
+      return false;
+    }
+
+    lowerKey = SortUtils::ToSortableKey(lower);
+    upperKey = SortUtils::ToSortableKey(upper);
+    return true;
+  }
+
+  // Returns the documents whose key is in the inclusive range
+  // [lowerKey, upperKey].
+  std::shared_ptr<MamaJenniesBitmap> GetBitmapBetween(std::uint64_t lowerKey,
+                                                      std::uint64_t upperKey) {
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    bool checkLower = lowerKey != 0;
+    bool checkUpper = upperKey != std::numeric_limits<std::uint64_t>::max();
+    std::size_t blockCount = m_slices.size() / SLICE_COUNT;
+
+    for (std::size_t block = 0; block < blockCount; block++) {
+      const std::uint64_t* slices = &m_slices[block * SLICE_COUNT];
+      std::uint64_t existing = std::numeric_limits<std::uint64_t>::max();
+      if (block == blockCount - 1 && m_documentCount % 64 != 0) {
+        existing = (std::uint64_t(1) << (m_documentCount % 64)) - 1;
+      }
+      // Nulls never satisfy a comparison
+      existing &= ~m_nulls[block];
+
+      // eq* tracks the documents whose key matches the bound in all the bits
+      // seen so far. Once a document differs from the bound it is either
+      // below the lower bound or above the upper bound, or decided inside.
+      std::uint64_t ltLower = 0, eqLower = checkLower ? existing : 0;
+      std::uint64_t gtUpper = 0, eqUpper = checkUpper ? existing : 0;
+      for (int bit = SLICE_COUNT - 1; bit >= 0 && (eqLower | eqUpper); bit--) {
+        std::uint64_t slice = slices[bit];
+        if ((lowerKey >> bit) & 1) {
+          ltLower |= eqLower & ~slice;
+          eqLower &= slice;
+        } else {
+          eqLower &= ~slice;
+        }
+
+        if ((upperKey >> bit) & 1) {
+          eqUpper &= slice;
+        } else {
+          gtUpper |= eqUpper & slice;
+          eqUpper &= ~slice;
+        }
+      }
+
+      bitmap->AddWord(existing & ~ltLower & ~gtUpper);
+    }
+
+    return bitmap;
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_fieldNameTokens;
+  std::unique_ptr<Document> m_subDoc;
+  bool m_isDouble;
+  // SLICE_COUNT words for every 64 documents. Word b of a block holds bit b
+  // of the keys of those documents.
+  std::vector<std::uint64_t> m_slices;
+  // One word for every 64 documents with the bits of the null documents set
+  std::vector<std::uint64_t> m_nulls;
+  std::uint64_t m_documentCount;
+};
+}  // namespace jonoondb_api
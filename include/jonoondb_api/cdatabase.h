@@ -203,6 +203,33 @@ JONOONDB_API_EXPORT void jonoondb_database_multi_insert
     (database_ptr db, const char* collectionName, uint64_t collectionNameLength,
      const jonoondb_buffer_ptr* documentArr, uint64_t documentArrLength,
      const write_options_ptr wo, status_ptr* sts);
+JONOONDB_API_EXPORT void jonoondb_database_createindex(database_ptr db,
+                                                       const char* collectionName,
+                                                       const indexinfo_ptr indexInfo,
+                                                       status_ptr* sts);
+JONOONDB_API_EXPORT void jonoondb_database_dropindex(database_ptr db,
+                                                     const char* collectionName,
+                                                     const char* indexName,
+                                                     status_ptr* sts);
+JONOONDB_API_EXPORT void jonoondb_database_begin_bulk_load(database_ptr db,
+                                                           const char* collectionName,
+                                                           status_ptr* sts);
+JONOONDB_API_EXPORT void jonoondb_database_end_bulk_load(database_ptr db,
+                                                         const char* collectionName,
+                                                         status_ptr* sts);
+JONOONDB_API_EXPORT int32_t jonoondb_database_try_get_by_key_integer(database_ptr db,
+                                                                   const char* collectionName,
+                                                                   const char* columnName,
+                                                                   int64_t key,
+                                                                   jonoondb_buffer_ptr document,
+                                                                   status_ptr* sts);
+JONOONDB_API_EXPORT int32_t jonoondb_database_try_get_by_key_string(database_ptr db,
+                                                                  const char* collectionName,
+                                                                  const char* columnName,
+                                                                  const char* key,
+                                                                  uint64_t keyLength,
+                                                                  jonoondb_buffer_ptr document,
+                                                                  status_ptr* sts);
 JONOONDB_API_EXPORT resultset_ptr jonoondb_database_executeselect(database_ptr db,
                                                                   const char* selectStmt,
                                                                   uint64_t selectStmtLength,
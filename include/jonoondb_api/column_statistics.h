@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <random>
+
+namespace jonoondb_api {
+// Forward declarations
+struct Constraint;
+enum class IndexConstraintOperator: std::int8_t;
+
+// Statistics of the values of an indexed column. The number of distinct
+// values is estimated with a HyperLogLog sketch and the distribution of the
+// values with a fixed size reservoir sample, so the memory used does not
+// grow with the collection. The null sentinels of every type and NaN are
+// counted as nulls.
+class ColumnStatistics {
+ public:
+  ColumnStatistics();
+
+  void AddValue(std::int64_t val);
+  void AddValue(double val);
+  void AddValue(const std::string& val);
+  void AddNull();
+
+  std::uint64_t GetDocumentCount() const {
+    return m_valueCount + m_nullCount;
+  }
+
+  std::uint64_t GetNullCount() const {
+    return m_nullCount;
+  }
+
+  // Estimated number of distinct non null values
+  std::uint64_t GetDistinctCount() const;
+
+  // Estimated fraction of the documents that satisfy the constraint
+  double EstimateSelectivity(const Constraint& constraint) const;
+  // Estimated fraction of the documents that satisfy both the constraints
+  double EstimateSelectivity(const Constraint& constraint1,
+                             const Constraint& constraint2) const;
+  // Estimated fraction of the documents that satisfy a constraint with the
+  // operator when the operand is not known yet
+  double EstimateSelectivity(IndexConstraintOperator op) const;
+
+ private:
+  void AddHash(std::uint64_t hash);
+  bool TryGetSampleSlot(std::size_t& slot);
+  template<typename T>
+  void AddSample(const T& val, std::vector<T>& samples);
+  double GetValueFraction() const;
+  double EstimateSampleSelectivity(const Constraint& constraint1,
+                                   const Constraint& constraint2) const;
+
+  // 2^REGISTER_BITS HyperLogLog registers
+  static const int REGISTER_BITS = 10;
+  static const std::size_t SAMPLE_SIZE = 256;
+
+  std::uint64_t m_valueCount;
+  std::uint64_t m_nullCount;
+  std::vector<std::uint8_t> m_registers;
+  // Reservoir samples, only one of them is used for a column
+  std::vector<double> m_numericSamples;
+  std::vector<std::string> m_stringSamples;
+  std::minstd_rand m_random;
+};
+}  // namespace jonoondb_api
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <unordered_map>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "null_helpers.h"
+
+namespace jonoondb_api {
+// Index over several fields. The column name of the index lists the fields
+// separated by commas e.g. "user.id,timestamp". The values of a document
+// are encoded into one key whose byte order is the order of the tuple, so
+// that equality constraints on the leading fields plus a range on the next
+// field are answered with one lookup.
+// With IndexType SORTED the keys are kept in sorted segments like in
+// SortedIndexer. With IndexType HASH the keys are hashed and only equality
+// constraints on all the fields can be answered.
+class CompositeIndexer final: public Indexer {
+ public:
+  CompositeIndexer(const IndexInfoImpl& indexInfo,
+                   const std::vector<FieldType>& fieldTypes) {
+    auto columnNames = GetColumnNames(indexInfo.GetColumnName());
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (columnNames.size() < 2) {
+      errorMsg = "Argument indexInfo must have at least 2 column names.";
+    } else if (indexInfo.GetType() != IndexType::SORTED &&
+        indexInfo.GetType() != IndexType::HASH) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType SORTED or HASH for CompositeIndexer.";
+    } else if (fieldTypes.size() != columnNames.size()) {
+      errorMsg = "Argument fieldTypes must have a field type for each column.";
+    } else {
+      for (auto fieldType : fieldTypes) {
+        if (!IsValidFieldType(fieldType)) {
+          std::ostringstream ss;
+          ss << "Argument fieldType " << GetFieldString(fieldType)
+              << " is not valid for CompositeIndexer.";
+          errorMsg = ss.str();
+          break;
+        }
+      }
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_isSorted = indexInfo.GetType() == IndexType::SORTED;
+    m_columnNames = columnNames;
+    for (std::size_t i = 0; i < columnNames.size(); i++) {
+      m_columns.push_back(
+          Column{StringUtils::Split(columnNames[i], "."), fieldTypes[i]});
+    }
+    m_indexStat = IndexStat(indexInfo, fieldTypes[0]);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_INT8
+        || fieldType == FieldType::BASE_TYPE_INT16
+        || fieldType == FieldType::BASE_TYPE_INT32
+        || fieldType == FieldType::BASE_TYPE_INT64
+        || fieldType == FieldType::BASE_TYPE_FLOAT32
+        || fieldType == FieldType::BASE_TYPE_DOUBLE
+        || fieldType == FieldType::BASE_TYPE_STRING);
+  }
+
+  // Returns true if the column name of the index lists several fields
+  static bool IsComposite(const IndexInfoImpl& indexInfo) {
+    return indexInfo.GetColumnName().find(',') != std::string::npos;
+  }
+
+  static std::vector<std::string> GetColumnNames(
+      const std::string& columnName) {
+    return StringUtils::Split(columnName, ", ");
+  }
+
+  const std::vector<std::string>& GetColumnNames() const {
+    return m_columnNames;
+  }
+
+  // Number of leading fields that must have an equality constraint
+  std::size_t GetMinEqualityCount() const {
+    return m_isSorted ? 0 : m_columns.size();
+  }
+
+  // True if the field after the equality constraints can have a range
+  bool SupportsRange() const {
+    return m_isSorted;
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    std::string key;
+    bool hasNull = false;
+    for (auto& column : m_columns) {
+      hasNull |= !AppendValue(document, column, key);
+    }
+
+    // A key with a null field never satisfies an equality on all the fields
+    if (hasNull) {
+      m_indexStat.GetStatistics().AddNull();
+    } else {
+      m_indexStat.GetStatistics().AddValue(key);
+    }
+
+    if (m_isSorted) {
+      // Nulls are kept because the document still matches constraints on
+      // the other fields
+      m_buffer.emplace_back(std::move(key), documentID);
+      if (m_buffer.size() >= BUFFER_SIZE) {
+        FlushBuffer();
+      }
+    } else if (!hasNull) {
+      auto& bitmap = m_hashMap[key];
+      if (bitmap == nullptr) {
+        bitmap = std::make_shared<MamaJenniesBitmap>();
+      }
+      bitmap->Add(documentID);
+    }
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    throw JonoonDBException(
+        "Filter is not supported by CompositeIndexer, use FilterComposite.",
+        __FILE__, __func__, __LINE__);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    throw JonoonDBException(
+        "FilterRange is not supported by CompositeIndexer, use FilterComposite.",
+        __FILE__, __func__, __LINE__);
+  }
+
+  // Returns the documents whose leading fields are equal to the operands of
+  // equalConstraints and whose next field satisfies lowerConstraint and
+  // upperConstraint. The range constraints can be null.
+  std::shared_ptr<MamaJenniesBitmap> FilterComposite(
+      const std::vector<const Constraint*>& equalConstraints,
+      const Constraint* lowerConstraint, const Constraint* upperConstraint) {
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    assert(equalConstraints.size() <= m_columns.size());
+    std::string prefix;
+    for (std::size_t i = 0; i < equalConstraints.size(); i++) {
+      Bound bound;
+      if (!TryGetBound(m_columns[i], *equalConstraints[i], bound) ||
+          bound.op != IndexConstraintOperator::EQUAL) {
+        return bitmap;
+      }
+      prefix.append(bound.key);
+    }
+
+    if (!m_isSorted) {
+      assert(equalConstraints.size() == m_columns.size());
+      std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+      auto iter = m_hashMap.find(prefix);
+      if (iter != m_hashMap.end()) {
+        bitmaps.push_back(iter->second);
+      }
+      return MamaJenniesBitmap::LogicalOR(bitmaps);
+    }
+
+    // The keys in [begin, end) satisfy the constraints. An empty end means
+    // there is no upper limit.
+    std::string begin = prefix;
+    std::string end = GetSuccessor(prefix);
+    if (lowerConstraint != nullptr || upperConstraint != nullptr) {
+      assert(equalConstraints.size() < m_columns.size());
+      auto& column = m_columns[equalConstraints.size()];
+      // Nulls never satisfy a range
+      begin.push_back(char(VALUE_MARKER));
+      for (auto constraint : {lowerConstraint, upperConstraint}) {
+        if (constraint == nullptr) {
+          continue;
+        }
+
+        Bound bound;
+        if (!TryGetBound(column, *constraint, bound)) {
+          return bitmap;
+        }
+        if (bound.isUnbounded) {
+          continue;
+        }
+
+        auto key = prefix + bound.key;
+        switch (bound.op) {
+          case IndexConstraintOperator::GREATER_THAN:
+            begin = std::max(begin, GetSuccessor(key));
+            break;
+          case IndexConstraintOperator::GREATER_THAN_EQUAL:
+            begin = std::max(begin, key);
+            break;
+          case IndexConstraintOperator::LESS_THAN:
+            end = end.empty() ? key : std::min(end, key);
+            break;
+          default: {
+            assert(bound.op == IndexConstraintOperator::LESS_THAN_EQUAL);
+            auto successor = GetSuccessor(key);
+            end = end.empty() ? successor : std::min(end, successor);
+            break;
+          }
+        }
+      }
+    }
+
+    if (!end.empty() && begin >= end) {
+      return bitmap;
+    }
+
+    auto inRange = [&begin, &end](const Entry& entry) {
+      return entry.first >= begin && (end.empty() || entry.first < end);
+    };
+    std::vector<std::uint64_t> documentIDs;
+    for (auto& segment : m_segments) {
+      auto first = std::lower_bound(segment.begin(), segment.end(),
+                                    Entry(begin, 0));
+      auto last = end.empty() ? segment.end() :
+          std::lower_bound(first, segment.end(), Entry(end, 0));
+      for (; first < last; ++first) {
+        documentIDs.push_back(first->second);
+      }
+    }
+
+    for (auto& entry : m_buffer) {
+      if (inRange(entry)) {
+        documentIDs.push_back(entry.second);
+      }
+    }
+
+    // Bitmaps have to be built in increasing documentID order
+    std::sort(documentIDs.begin(), documentIDs.end());
+    for (auto documentID : documentIDs) {
+      bitmap->Add(documentID);
+    }
+
+    return bitmap;
+  }
+
+ private:
+  typedef std::pair<std::string, std::uint64_t> Entry;
+  static const std::size_t BUFFER_SIZE = 1024;
+  // Every encoded field starts with a marker so that nulls sort first
+  static const char NULL_MARKER = '\x00';
+  static const char VALUE_MARKER = '\x01';
+
+  struct Column {
+    std::vector<std::string> fieldNameTokens;
+    FieldType fieldType;
+  };
+
+  // The encoded operand of a constraint on one field. Comparisons of
+  // integer fields with doubles are turned into comparisons with integers.
+  struct Bound {
+    std::string key;
+    IndexConstraintOperator op;
+    // The constraint is satisfied by every non null value
+    bool isUnbounded = false;
+  };
+
+  static bool IsInteger(FieldType fieldType) {
+    return fieldType != FieldType::BASE_TYPE_FLOAT32 &&
+        fieldType != FieldType::BASE_TYPE_DOUBLE &&
+        fieldType != FieldType::BASE_TYPE_STRING;
+  }
+
+  static void AppendInteger(std::int64_t val, std::string& key) {
+    // Flipping the sign bit makes the big endian bytes sort like the values
+    auto bits = static_cast<std::uint64_t>(val) ^ (1ULL << 63);
+    key.push_back(char(VALUE_MARKER));
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>((bits >> shift) & 0xFF));
+    }
+  }
+
+  static void AppendDouble(double val, std::string& key) {
+    // 0.0 and -0.0 are the same value
+    double normalized = val == 0 ? 0.0 : val;
+    std::uint64_t bits;
+    std::memcpy(&bits, &normalized, sizeof(bits));
+    // Negative numbers sort in the reverse order of their bits
+    bits = (bits & (1ULL << 63)) ? ~bits : bits ^ (1ULL << 63);
+    key.push_back(char(VALUE_MARKER));
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>((bits >> shift) & 0xFF));
+    }
+  }
+
+  static void AppendString(const std::string& val, std::string& key) {
+    // NUL bytes are escaped so that the terminator sorts before any
+    // continuation of the string
+    key.push_back(char(VALUE_MARKER));
+    for (auto c : val) {
+      key.push_back(c);
+      if (c == '\x00') {
+        key.push_back('\xFF');
+      }
+    }
+    key.push_back('\x00');
+    key.push_back('\x00');
+  }
+
+  // Returns false if the value is null
+  bool AppendValue(const Document& document, const Column& column,
+                   std::string& key) {
+    if (column.fieldType == FieldType::BASE_TYPE_STRING) {
+      auto val = DocumentUtils::GetStringValue(document, m_subDoc,
+                                               column.fieldNameTokens);
+      if (NullHelpers::IsNull(val)) {
+        key.push_back(char(NULL_MARKER));
+        return false;
+      }
+      AppendString(val, key);
+    } else if (IsInteger(column.fieldType)) {
+      AppendInteger(DocumentUtils::GetIntegerValue(document, m_subDoc,
+                                                   column.fieldNameTokens),
+                    key);
+    } else {
+      auto val = DocumentUtils::GetFloatValue(document, m_subDoc,
+                                              column.fieldNameTokens);
+      if (std::isnan(val)) {
+        key.push_back(char(NULL_MARKER));
+        return false;
+      }
+      AppendDouble(val, key);
+    }
+
+    return true;
+  }
+
+  // Returns the smallest key greater than every key starting with prefix
+  // or an empty string if there is none
+  static std::string GetSuccessor(std::string prefix) {
+    while (!prefix.empty() && prefix.back() == '\xFF') {
+      prefix.pop_back();
+    }
+    if (!prefix.empty()) {
+      prefix.back() = static_cast<char>(
+          static_cast<unsigned char>(prefix.back()) + 1);
+    }
+    return prefix;
+  }
+
+  // Returns false if no value of the field can satisfy the constraint
+  static bool TryGetBound(const Column& column, const Constraint& constraint,
+                          Bound& bound) {
+    bound.op = constraint.op;
+    if (column.fieldType == FieldType::BASE_TYPE_STRING) {
+      if (constraint.operandType != OperandType::STRING) {
+        return false;
+      }
+      AppendString(constraint.strVal, bound.key);
+      return true;
+    }
+
+    if (constraint.operandType == OperandType::INTEGER) {
+      if (IsInteger(column.fieldType)) {
+        AppendInteger(constraint.operand.int64Val, bound.key);
+      } else {
+        AppendDouble(static_cast<double>(constraint.operand.int64Val),
+                     bound.key);
+      }
+      return true;
+    }
+
+    if (constraint.operandType != OperandType::DOUBLE ||
+        std::isnan(constraint.operand.doubleVal)) {
+      return false;
+    }
+
+    auto operand = constraint.operand.doubleVal;
+    if (!IsInteger(column.fieldType)) {
+      AppendDouble(operand, bound.key);
+      return true;
+    }
+
+    // x > 2.5 is x >= 3 and x < 2.5 is x <= 2 for integers
+    bool isLower = constraint.op == IndexConstraintOperator::GREATER_THAN ||
+        constraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL;
+    bool isUpper = constraint.op == IndexConstraintOperator::LESS_THAN ||
+        constraint.op == IndexConstraintOperator::LESS_THAN_EQUAL;
+    auto rounded = isLower ? std::ceil(operand) : std::floor(operand);
+    if (rounded != operand) {
+      if (!isLower && !isUpper) {
+        return false;
+      }
+      bound.op = isLower ? IndexConstraintOperator::GREATER_THAN_EQUAL :
+          IndexConstraintOperator::LESS_THAN_EQUAL;
+    }
+
+    // 2^63 and -2^63 are exactly representable as double
+    if (rounded >= 9223372036854775808.0) {
+      bound.isUnbounded = isUpper;
+      return isUpper;
+    }
+    if (rounded < -9223372036854775808.0) {
+      bound.isUnbounded = isLower;
+      return isLower;
+    }
+
+    AppendInteger(static_cast<std::int64_t>(rounded), bound.key);
+    return true;
+  }
+
+  void FlushBuffer() {
+    std::sort(m_buffer.begin(), m_buffer.end());
+    m_segments.push_back(std::move(m_buffer));
+    m_buffer = std::vector<Entry>();
+    m_buffer.reserve(BUFFER_SIZE);
+
+    while (m_segments.size() > 1 &&
+        m_segments[m_segments.size() - 2].size() <= m_segments.back().size()) {
+      auto& first = m_segments[m_segments.size() - 2];
+      auto& second = m_segments.back();
+      std::vector<Entry> merged;
+      merged.reserve(first.size() + second.size());
+      std::merge(std::make_move_iterator(first.begin()),
+                 std::make_move_iterator(first.end()),
+                 std::make_move_iterator(second.begin()),
+                 std::make_move_iterator(second.end()),
+                 std::back_inserter(merged));
+      m_segments.pop_back();
+      m_segments.back() = std::move(merged);
+    }
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_columnNames;
+  std::vector<Column> m_columns;
+  bool m_isSorted;
+  std::unique_ptr<Document> m_subDoc;
+  // Sorted segments, oldest and biggest first. Only used by SORTED indexes.
+  std::vector<std::vector<Entry>> m_segments;
+  std::vector<Entry> m_buffer;
+  // Documents of every key without nulls. Only used by HASH indexes.
+  std::unordered_map<std::string, std::shared_ptr<MamaJenniesBitmap>>
+      m_hashMap;
+};
+}  // namespace jonoondb_api
@@ -82,6 +82,11 @@ class ConcurrentLRUCache {
     }
   }
 
+  void Clear() {
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+    m_map.clear();
+  }
+
   void PerformEviction() {
     std::list<EvictionEntry<T1, T2>> keysToEvict;
 
@@ -689,6 +689,58 @@ class Database {
                                    ThrowOnError{});
   }
 
+  // Looks up a document by the value of an indexed field. The lookup is
+  // fastest when the field has a HASH or UNIQUE_HASH index. Returns false if
+  // no document has the key.
+  bool TryGetByKey(const std::string& collectionName,
+                   const std::string& columnName, std::int64_t key,
+                   Buffer& document) {
+    return jonoondb_database_try_get_by_key_integer(
+        m_opaque, collectionName.c_str(), columnName.c_str(), key,
+        document.GetOpaqueType(), ThrowOnError{}) != 0;
+  }
+
+  bool TryGetByKey(const std::string& collectionName,
+                   const std::string& columnName, const std::string& key,
+                   Buffer& document) {
+    return jonoondb_database_try_get_by_key_string(
+        m_opaque, collectionName.c_str(), columnName.c_str(), key.data(),
+        key.size(), document.GetOpaqueType(), ThrowOnError{}) != 0;
+  }
+
+  // Adds an index to an existing collection. The index is built in the
+  // background and queries start using it once it has caught up with the
+  // documents inserted in the meantime. If the build fails the index is
+  // not used and creating it again throws with the error until it is
+  // dropped. UNIQUE_HASH indexes can only be created with the collection.
+  void CreateIndex(const std::string& collectionName,
+                   const IndexInfo& indexInfo) {
+    jonoondb_database_createindex(m_opaque, collectionName.c_str(),
+                                  indexInfo.GetOpaqueType(), ThrowOnError{});
+  }
+
+  void DropIndex(const std::string& collectionName,
+                 const std::string& indexName) {
+    jonoondb_database_dropindex(m_opaque, collectionName.c_str(),
+                                indexName.c_str(), ThrowOnError{});
+  }
+
+  // Documents inserted between BeginBulkLoad and EndBulkLoad are indexed
+  // together when EndBulkLoad is called. Queries do not return them until
+  // EndBulkLoad has finished, documents inserted before BeginBulkLoad stay
+  // visible. If EndBulkLoad fails reading the documents it can be called
+  // again. If it fails indexing them the collection throws on every call
+  // until the database is reopened.
+  void BeginBulkLoad(const std::string& collectionName) {
+    jonoondb_database_begin_bulk_load(m_opaque, collectionName.c_str(),
+                                      ThrowOnError{});
+  }
+
+  void EndBulkLoad(const std::string& collectionName) {
+    jonoondb_database_end_bulk_load(m_opaque, collectionName.c_str(),
+                                    ThrowOnError{});
+  }
+
   ResultSet ExecuteSelect(const std::string& selectStatement) {
     auto rs = jonoondb_database_executeselect(m_opaque,
                                               selectStatement.c_str(),
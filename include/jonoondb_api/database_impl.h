@@ -39,6 +39,14 @@ class DatabaseImpl final {
   void MultiInsert(const boost::string_ref& collectionName,
                    gsl::span<const BufferImpl*>& documents,
                    const WriteOptionsImpl& wo);
+  void CreateIndex(const char* collectionName, const IndexInfoImpl& indexInfo);
+  void DropIndex(const char* collectionName, const char* indexName);
+  void BeginBulkLoad(const char* collectionName);
+  void EndBulkLoad(const char* collectionName);
+  bool TryGetByKey(const char* collectionName, const char* columnName,
+                   std::int64_t key, BufferImpl& document);
+  bool TryGetByKey(const char* collectionName, const char* columnName,
+                   const boost::string_ref& key, BufferImpl& document);
   ResultSetImpl ExecuteSelect(const std::string& selectStatement);
 
  private:
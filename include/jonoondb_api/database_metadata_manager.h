@@ -40,12 +40,14 @@ class DatabaseMetadataManager final {
   const std::string& GetDBPath() const;
   const std::string& GetDBName() const;
   void GetExistingCollections(std::vector<CollectionMetadata>& collections);
+  void CreateIndex(const std::string& collectionName,
+                   const IndexInfoImpl& indexInfo);
+  void RemoveIndex(const std::string& collectionName,
+                   const std::string& indexName);
 
  private:
   void CreateTables();
   void PrepareStatements();
-  void CreateIndex
-      (const std::string& collectionName, const IndexInfoImpl& indexInfo);
   void FinalizeStatements();
 
   std::string m_dbName;
@@ -54,5 +56,6 @@ class DatabaseMetadataManager final {
   std::unique_ptr<sqlite3, void (*)(sqlite3*)> m_metadataDBConnection;
   sqlite3_stmt* m_insertCollectionSchemaStmt;
   sqlite3_stmt* m_insertCollectionIndexStmt;
+  sqlite3_stmt* m_deleteCollectionIndexStmt;
 };
 }
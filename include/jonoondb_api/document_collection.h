@@ -4,6 +4,10 @@
 #include <unordered_map>
 #include <string>
 #include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include "gsl/span.h"
 #include "index_manager.h"
 #include "document_id_generator.h"
@@ -27,6 +31,8 @@ class MamaJenniesBitmap;
 class BlobManager;
 struct FileInfo;
 class WriteOptionsImpl;
+class Document;
+class Indexer;
 
 class DocumentCollection final {
  public:
@@ -37,19 +43,44 @@ class DocumentCollection final {
                      const std::vector<IndexInfoImpl*>& indexes,
                      std::unique_ptr<BlobManager> blobManager,
                      const std::vector<FileInfo>& dataFilesToLoad);
+  ~DocumentCollection();
 
   void Insert(const BufferImpl& documentData, const WriteOptionsImpl& wo);
   void MultiInsert(gsl::span<const BufferImpl*>& documents,
                    const WriteOptionsImpl& wo);
+  // While a bulk load is in progress inserted documents are persisted but
+  // not indexed. EndBulkLoad indexes all of them in one sort based pass.
+  // Queries do not see the documents of a bulk load before EndBulkLoad.
+  void BeginBulkLoad();
+  void EndBulkLoad();
+  // Builds the index in a background thread over the existing documents.
+  // Queries start using the index once it has caught up with the documents
+  // inserted in the meantime. If the build fails the index is never used
+  // and creating it again throws with the error until it is dropped.
+  void CreateIndex(const IndexInfoImpl& indexInfo);
+  // Drops the index, an index that is still being built is abandoned
+  void DropIndex(const std::string& indexName);
   const std::string& GetName();
   const std::shared_ptr<DocumentSchema>& GetDocumentSchema();
+  std::uint64_t GetDocumentCount() const;
   bool
       TryGetBestIndex(const std::string& columnName, IndexConstraintOperator op,
                       IndexStat& indexStat);
+  bool TryGetBestCompositeIndex(const std::vector<Constraint>& constraints,
+                                IndexStat& indexStat,
+                                std::vector<std::size_t>& coveredConstraints,
+                                double& selectivity);
   std::shared_ptr<MamaJenniesBitmap>
       Filter(const std::vector<Constraint>& constraints);
+  bool TryGetValueBitmaps(const std::string& columnName,
+                          std::vector<ValueBitmap>& valueBitmaps);
+  bool TryGetOrderedIndex(const std::string& columnName, IndexStat& indexStat);
+  bool TryGetOrderedBitmaps(
+      const std::string& columnName,
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps);
 
   //Document Access Functions
+  bool TryGetDocumentByKey(const Constraint& key, BufferImpl& buffer) const;
   void GetDocumentAndBuffer(std::uint64_t docID,
                             std::unique_ptr<Document>& document,
                             BufferImpl & buffer) const;
@@ -76,6 +107,24 @@ class DocumentCollection final {
   void UnmapLRUDataFiles();
 
  private:
+  struct IndexBuild {
+    std::string indexName;
+    std::atomic<bool> isCancelled{false};
+    std::atomic<bool> isDone{false};
+    // Set before isDone when the build failed
+    std::string error;
+    std::thread thread;
+  };
+
+  void BuildIndex(IndexBuild* build, std::unique_ptr<Indexer> indexer);
+  void ReadDocuments(const std::vector<BlobMetadata>& blobMetadataVec,
+                     std::vector<BufferImpl>& blobs,
+                     std::vector<std::unique_ptr<Document>>& documents);
+  // Joins the threads of the builds that are done
+  void RemoveFinishedIndexBuilds();
+  template<typename Function>
+  void IndexBulkLoadedDocuments(Function function);
+  void ThrowIfIndexesAreInvalid();
   void PopulateColumnTypes(
       const std::vector<IndexInfoImpl*>& indexes,
       const DocumentSchema& documentSchema,
@@ -87,6 +136,17 @@ class DocumentCollection final {
   std::vector<BlobMetadata> m_documentIDMap;
   std::string m_name;
   std::unique_ptr<BlobManager> m_blobManager;
+  std::atomic<bool> m_bulkLoadInProgress;
+  // Bulk loaded documents before this id are staged in the indexers
+  std::uint64_t m_bulkLoadStartID;
+  // Set if indexing failed in EndBulkLoad, the collection is unusable
+  std::atomic<bool> m_indexesAreInvalid;
+  // Documents with smaller ids are indexed and visible to queries
+  std::atomic<std::uint64_t> m_indexedDocumentCount;
+  // Guards m_documentIDMap against the index build threads, the other
+  // readers run on the thread that inserts
+  std::mutex m_documentIDMapMutex;
+  std::vector<std::unique_ptr<IndexBuild>> m_indexBuilds;
 };
 }  // namespace jonoondb_api
 
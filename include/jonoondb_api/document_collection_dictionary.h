@@ -34,6 +34,9 @@ class DocumentCollectionDictionary {
   DocumentCollectionDictionary(DocumentCollectionDictionary&&) = delete;
 
   static DocumentCollectionDictionary* Instance();
+  // Key of a collection, it is passed to jonoondb_vtable as an argument
+  static std::string GetKey(const std::string& dbName,
+                            const std::string& collectionName);
   void Insert(const std::string& key,
               const std::shared_ptr<DocumentCollectionInfo>& collection);
   bool TryGet(const std::string& key,
@@ -13,6 +13,7 @@ class DocumentIDGenerator {
   DocumentIDGenerator(DocumentIDGenerator&&) = delete;
   DocumentIDGenerator& operator=(const DocumentIDGenerator&) = delete;
   std::uint64_t ReserveID(std::uint32_t numOfIDsToReserve);
+  std::uint64_t GetReservedIDCount() const;
  private:
   std::atomic<std::uint64_t> m_currentID;
 };
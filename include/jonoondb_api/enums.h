@@ -16,6 +16,12 @@ enum class IndexType
     : std::int32_t {
   EWAH_COMPRESSED_BITMAP = 1,
   VECTOR = 2,
+  BIT_SLICED = 3,
+  SORTED = 4,
+  HASH = 5,
+  UNIQUE_HASH = 6,
+  TRIGRAM = 7,
+  FULL_TEXT = 8,
 };
 JONOONDB_API_EXPORT extern IndexType ToIndexType(std::int32_t type);
 
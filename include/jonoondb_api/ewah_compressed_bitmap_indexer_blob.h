@@ -69,6 +69,7 @@ class EWAHCompressedBitmapIndexerBlob final: public Indexer {
                                            m_subDoc,
                                            m_fieldNameTokens,
                                            size);
+    m_indexStat.GetStatistics().AddValue(std::string(val, size));
 
     BufferImpl buffer(const_cast<char*>(val), size, size, nullptr);
     auto compressedBitmap = m_compressedBitmaps.find(buffer);
@@ -99,8 +100,13 @@ class EWAHCompressedBitmapIndexerBlob final: public Indexer {
         return GetBitmapGT(constraint, false);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
         return GetBitmapGT(constraint, true);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
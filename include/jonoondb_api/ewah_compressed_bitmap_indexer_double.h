@@ -16,6 +16,8 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "sort_utils.h"
+#include "null_helpers.h"
 
 namespace jonoondb_api {
 
@@ -62,6 +64,7 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     auto val = DocumentUtils::GetFloatValue(document,
                                             m_subDoc,
                                             m_fieldNameTokens);
+    m_indexStat.GetStatistics().AddValue(val);
     auto compressedBitmap = m_compressedBitmaps.find(val);
     if (compressedBitmap == m_compressedBitmaps.end()) {
       auto bm = shared_ptr<MamaJenniesBitmap>(new MamaJenniesBitmap());
@@ -72,6 +75,43 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     }
   }
 
+  void BulkInsert(
+      std::uint64_t startID,
+      const std::vector<std::unique_ptr<Document>>& documents) override {
+    m_bulkEntries.reserve(m_bulkEntries.size() + documents.size());
+    for (std::size_t i = 0; i < documents.size(); i++) {
+      auto val = DocumentUtils::GetFloatValue(*documents[i],
+                                              m_subDoc,
+                                              m_fieldNameTokens);
+      m_indexStat.GetStatistics().AddValue(val);
+      m_bulkEntries.emplace_back(SortUtils::ToSortableKey(val), startID + i);
+    }
+  }
+
+  void FinalizeBulkInsert() override {
+    // After sorting, the documentIDs for each value are in increasing order
+    // so they can be appended to the bitmaps sequentially.
+    SortUtils::RadixSort(m_bulkEntries);
+    std::size_t i = 0;
+    while (i < m_bulkEntries.size()) {
+      auto key = m_bulkEntries[i].first;
+      auto val = SortUtils::ToDouble(key);
+      auto iter = m_compressedBitmaps.lower_bound(val);
+      if (iter == m_compressedBitmaps.end() || iter->first != val) {
+        iter = m_compressedBitmaps.emplace_hint(
+            iter, val, std::make_shared<MamaJenniesBitmap>());
+      }
+
+      for (; i < m_bulkEntries.size() && m_bulkEntries[i].first == key; i++) {
+        iter->second->Add(m_bulkEntries[i].second);
+      }
+      // Sparse and clustered bitmaps are smaller in Roaring
+      iter->second->Optimize();
+    }
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>>().swap(m_bulkEntries);
+  }
+
   const IndexStat& GetIndexStats() override {
     return m_indexStat;
   }
@@ -88,8 +128,13 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
         return GetBitmapGT(constraint);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
         return GetBitmapGTE(constraint);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -114,6 +159,11 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     }
 
     while (startIter != m_compressedBitmaps.end()) {
+      if (NullHelpers::IsNull(startIter->first)) {
+        startIter++;
+        continue;
+      }
+
       if (startIter->first < upperVal) {
         bitmaps.push_back(startIter->second);
       } else if (upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL
@@ -129,6 +179,40 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     return MamaJenniesBitmap::LogicalOR(bitmaps);
   }
 
+  bool TryGetValueBitmaps(std::vector<ValueBitmap>& valueBitmaps) override {
+    valueBitmaps.clear();
+    for (auto& item : m_compressedBitmaps) {
+      if (!NullHelpers::IsNull(item.first)) {
+        valueBitmaps.emplace_back();
+        valueBitmaps.back().valueType = OperandType::DOUBLE;
+        valueBitmaps.back().value.doubleVal = item.first;
+        valueBitmaps.back().bitmap = item.second;
+      }
+    }
+
+    return true;
+  }
+
+  bool TryGetOrderedBitmaps(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) override {
+    // The null value is a small positive number in the map, SQLite sorts
+    // nulls before every value
+    bitmaps.clear();
+    bitmaps.reserve(m_compressedBitmaps.size());
+    auto nullIter = m_compressedBitmaps.find(JONOONDB_NULL_DOUBLE);
+    if (nullIter != m_compressedBitmaps.end()) {
+      bitmaps.push_back(nullIter->second);
+    }
+
+    for (auto& item : m_compressedBitmaps) {
+      if (!NullHelpers::IsNull(item.first)) {
+        bitmaps.push_back(item.second);
+      }
+    }
+
+    return true;
+  }
+
  private:
   EWAHCompressedBitmapIndexerDouble(const IndexStat& indexStat,
                                     std::vector<std::string>& fieldNameTokens)
@@ -141,12 +225,14 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     if (constraint.operandType == OperandType::INTEGER) {
       auto iter =
           m_compressedBitmaps.find(static_cast<double>(constraint.operand.int64Val));
-      if (iter != m_compressedBitmaps.end()) {
+      if (iter != m_compressedBitmaps.end() &&
+          !NullHelpers::IsNull(iter->first)) {
         bitmaps.push_back(iter->second);
       }
     } else if (constraint.operandType == OperandType::DOUBLE) {
       auto iter = m_compressedBitmaps.find(constraint.operand.doubleVal);
-      if (iter != m_compressedBitmaps.end()) {
+      if (iter != m_compressedBitmaps.end() &&
+          !NullHelpers::IsNull(iter->first)) {
         bitmaps.push_back(iter->second);
       }
     }
@@ -163,6 +249,10 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
     if (constraint.operandType == OperandType::INTEGER) {
       double dVal = static_cast<double>(constraint.operand.int64Val);
       for (auto& item : m_compressedBitmaps) {
+        if (NullHelpers::IsNull(item.first)) {
+          continue;
+        }
+
         if (item.first < dVal) {
           bitmaps.push_back(item.second);
         } else {
@@ -174,6 +264,10 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
       }
     } else if (constraint.operandType == OperandType::DOUBLE) {
       for (auto& item : m_compressedBitmaps) {
+        if (NullHelpers::IsNull(item.first)) {
+          continue;
+        }
+
         if (item.first < constraint.operand.doubleVal) {
           bitmaps.push_back(item.second);
         } else {
@@ -201,7 +295,9 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
 
     auto iter = m_compressedBitmaps.upper_bound(operandVal);
     while (iter != m_compressedBitmaps.end()) {
-      bitmaps.push_back(iter->second);
+      if (!NullHelpers::IsNull(iter->first)) {
+        bitmaps.push_back(iter->second);
+      }
       iter++;
     }
 
@@ -219,7 +315,9 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
 
     auto iter = m_compressedBitmaps.lower_bound(operandVal);
     while (iter != m_compressedBitmaps.end()) {
-      bitmaps.push_back(iter->second);
+      if (!NullHelpers::IsNull(iter->first)) {
+        bitmaps.push_back(iter->second);
+      }
       iter++;
     }
 
@@ -244,5 +342,7 @@ class EWAHCompressedBitmapIndexerDouble final: public Indexer {
   // but that is not gauranteed. Change the code to handle this properly
   std::map<double, std::shared_ptr<MamaJenniesBitmap>> m_compressedBitmaps;
   std::unique_ptr<Document> m_subDoc;
+  // (sortable key, documentID) pairs staged by BulkInsert
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> m_bulkEntries;
 };
 }  // namespace jonoondb_api
@@ -16,6 +16,8 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "sort_utils.h"
+#include "null_helpers.h"
 
 namespace jonoondb_api {
 
@@ -65,6 +67,7 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
     auto val = DocumentUtils::GetIntegerValue(document,
                                               m_subDoc,
                                               m_fieldNameTokens);
+    m_indexStat.GetStatistics().AddValue(val);
     auto compressedBitmap = m_compressedBitmaps.find(val);
     if (compressedBitmap == m_compressedBitmaps.end()) {
       auto bm = shared_ptr<MamaJenniesBitmap>(new MamaJenniesBitmap());
@@ -75,6 +78,43 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
     }
   }
 
+  void BulkInsert(
+      std::uint64_t startID,
+      const std::vector<std::unique_ptr<Document>>& documents) override {
+    m_bulkEntries.reserve(m_bulkEntries.size() + documents.size());
+    for (std::size_t i = 0; i < documents.size(); i++) {
+      auto val = DocumentUtils::GetIntegerValue(*documents[i],
+                                                m_subDoc,
+                                                m_fieldNameTokens);
+      m_indexStat.GetStatistics().AddValue(val);
+      m_bulkEntries.emplace_back(SortUtils::ToSortableKey(val), startID + i);
+    }
+  }
+
+  void FinalizeBulkInsert() override {
+    // After sorting, the documentIDs for each value are in increasing order
+    // so they can be appended to the bitmaps sequentially.
+    SortUtils::RadixSort(m_bulkEntries);
+    std::size_t i = 0;
+    while (i < m_bulkEntries.size()) {
+      auto key = m_bulkEntries[i].first;
+      auto val = SortUtils::ToInt64(key);
+      auto iter = m_compressedBitmaps.lower_bound(val);
+      if (iter == m_compressedBitmaps.end() || iter->first != val) {
+        iter = m_compressedBitmaps.emplace_hint(
+            iter, val, std::make_shared<MamaJenniesBitmap>());
+      }
+
+      for (; i < m_bulkEntries.size() && m_bulkEntries[i].first == key; i++) {
+        iter->second->Add(m_bulkEntries[i].second);
+      }
+      // Sparse and clustered bitmaps are smaller in Roaring
+      iter->second->Optimize();
+    }
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>>().swap(m_bulkEntries);
+  }
+
   const IndexStat& GetIndexStats() override {
     return m_indexStat;
   }
@@ -91,8 +131,13 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
         return GetBitmapGT(constraint);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
         return GetBitmapGTE(constraint);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -135,6 +180,11 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
     }
 
     while (startIter != m_compressedBitmaps.end()) {
+      if (NullHelpers::IsNull(startIter->first)) {
+        startIter++;
+        continue;
+      }
+
       if (startIter->first < upperVal) {
         bitmaps.push_back(startIter->second);
       } else if (upperConstraint.op
@@ -157,6 +207,32 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
     return MamaJenniesBitmap::LogicalOR(bitmaps);
   }
 
+  bool TryGetValueBitmaps(std::vector<ValueBitmap>& valueBitmaps) override {
+    valueBitmaps.clear();
+    for (auto& item : m_compressedBitmaps) {
+      if (!NullHelpers::IsNull(item.first)) {
+        valueBitmaps.emplace_back();
+        valueBitmaps.back().valueType = OperandType::INTEGER;
+        valueBitmaps.back().value.int64Val = item.first;
+        valueBitmaps.back().bitmap = item.second;
+      }
+    }
+
+    return true;
+  }
+
+  bool TryGetOrderedBitmaps(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) override {
+    // The null value is the smallest key so the map order is the SQLite order
+    bitmaps.clear();
+    bitmaps.reserve(m_compressedBitmaps.size());
+    for (auto& item : m_compressedBitmaps) {
+      bitmaps.push_back(item.second);
+    }
+
+    return true;
+  }
+
  private:
   EWAHCompressedBitmapIndexerInteger(const IndexStat& indexStat,
                                      std::vector<std::string>& fieldNameTokens)
@@ -168,7 +244,8 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
     std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
     if (constraint.operandType == OperandType::INTEGER) {
       auto iter = m_compressedBitmaps.find(constraint.operand.int64Val);
-      if (iter != m_compressedBitmaps.end()) {
+      if (iter != m_compressedBitmaps.end() &&
+          !NullHelpers::IsNull(iter->first)) {
         bitmaps.push_back(iter->second);
       }
     } else if (constraint.operandType == OperandType::DOUBLE) {
@@ -177,7 +254,8 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
           intVal = static_cast<std::int64_t>(constraint.operand.doubleVal);
       if (constraint.operand.doubleVal == intVal) {
         auto iter = m_compressedBitmaps.find(intVal);
-        if (iter != m_compressedBitmaps.end()) {
+        if (iter != m_compressedBitmaps.end() &&
+            !NullHelpers::IsNull(iter->first)) {
           bitmaps.push_back(iter->second);
         }
       }
@@ -198,6 +276,10 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
 
     if (constraint.operandType == OperandType::INTEGER) {
       for (auto& item : m_compressedBitmaps) {
+        if (NullHelpers::IsNull(item.first)) {
+          continue;
+        }
+
         if (item.first < constraint.operand.int64Val) {
           bitmaps.push_back(item.second);
         } else {
@@ -209,6 +291,10 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
       }
     } else if (constraint.operandType == OperandType::DOUBLE) {
       for (auto& item : m_compressedBitmaps) {
+        if (NullHelpers::IsNull(item.first)) {
+          continue;
+        }
+
         if (item.first < ceiling) {
           bitmaps.push_back(item.second);
         } else {
@@ -235,7 +321,9 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
 
     auto iter = m_compressedBitmaps.upper_bound(operandVal);
     while (iter != m_compressedBitmaps.end()) {
-      bitmaps.push_back(iter->second);
+      if (!NullHelpers::IsNull(iter->first)) {
+        bitmaps.push_back(iter->second);
+      }
       iter++;
     }
 
@@ -254,7 +342,9 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
 
     auto iter = m_compressedBitmaps.lower_bound(operandVal);
     while (iter != m_compressedBitmaps.end()) {
-      bitmaps.push_back(iter->second);
+      if (!NullHelpers::IsNull(iter->first)) {
+        bitmaps.push_back(iter->second);
+      }
       iter++;
     }
 
@@ -266,5 +356,7 @@ class EWAHCompressedBitmapIndexerInteger final: public Indexer {
   std::map<std::int64_t, std::shared_ptr<MamaJenniesBitmap>>
       m_compressedBitmaps;
   std::unique_ptr<Document> m_subDoc;
+  // (sortable key, documentID) pairs staged by BulkInsert
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> m_bulkEntries;
 };
 }  // namespace jonoondb_api
@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <utility>
 #include "indexer.h"
 #include "index_info_impl.h"
 #include "status_impl.h"
@@ -17,6 +19,7 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "string_pattern.h"
 #include "jonoondb_api/null_helpers.h"
 
 namespace jonoondb_api {
@@ -63,7 +66,8 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
   void Insert(std::uint64_t documentID, const Document& document) override {
     auto val = DocumentUtils::GetStringValue(document,
                                              m_subDoc,
-                                             m_fieldNameTokens);    
+                                             m_fieldNameTokens);
+    m_indexStat.GetStatistics().AddValue(val);
     auto compressedBitmap = m_compressedBitmaps.find(val);
     if (compressedBitmap == m_compressedBitmaps.end()) {
       auto bm = shared_ptr<MamaJenniesBitmap>(new MamaJenniesBitmap());
@@ -74,12 +78,54 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
     }
   }
 
+  void BulkInsert(
+      std::uint64_t startID,
+      const std::vector<std::unique_ptr<Document>>& documents) override {
+    m_bulkEntries.reserve(m_bulkEntries.size() + documents.size());
+    for (std::size_t i = 0; i < documents.size(); i++) {
+      m_bulkEntries.emplace_back(
+          DocumentUtils::GetStringValue(*documents[i], m_subDoc,
+                                        m_fieldNameTokens),
+          startID + i);
+      m_indexStat.GetStatistics().AddValue(m_bulkEntries.back().first);
+    }
+  }
+
+  void FinalizeBulkInsert() override {
+    // stable_sort keeps the documentIDs of each value in increasing order
+    std::stable_sort(m_bulkEntries.begin(), m_bulkEntries.end(),
+                     [](const std::pair<std::string, std::uint64_t>& a,
+                        const std::pair<std::string, std::uint64_t>& b) {
+                       return a.first < b.first;
+                     });
+    std::size_t i = 0;
+    while (i < m_bulkEntries.size()) {
+      const std::string& val = m_bulkEntries[i].first;
+      auto iter = m_compressedBitmaps.lower_bound(val);
+      if (iter == m_compressedBitmaps.end() || iter->first != val) {
+        iter = m_compressedBitmaps.emplace_hint(
+            iter, val, std::make_shared<MamaJenniesBitmap>());
+      }
+
+      for (; i < m_bulkEntries.size() && m_bulkEntries[i].first == iter->first;
+           i++) {
+        iter->second->Add(m_bulkEntries[i].second);
+      }
+      // Sparse and clustered bitmaps are smaller in Roaring
+      iter->second->Optimize();
+    }
+
+    std::vector<std::pair<std::string, std::uint64_t>>().swap(m_bulkEntries);
+  }
+
   const IndexStat& GetIndexStats() override {
     return m_indexStat;
   }
 
   std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
-    assert(constraint.operandType == OperandType::STRING);
+    assert(constraint.operandType == OperandType::STRING ||
+        constraint.op == IndexConstraintOperator::LIKE ||
+        constraint.op == IndexConstraintOperator::GLOB);
     switch (constraint.op) {
       case jonoondb_api::IndexConstraintOperator::EQUAL:
         return GetBitmapEQ(constraint);
@@ -91,8 +137,16 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
         return GetBitmapGT(constraint, false);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
         return GetBitmapGT(constraint, true);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+      case jonoondb_api::IndexConstraintOperator::LIKE:
+      case jonoondb_api::IndexConstraintOperator::GLOB:
+        return GetBitmapPattern(StringPattern(constraint));
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -120,6 +174,7 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
       while (startIter != m_compressedBitmaps.end()) {
         if (nullChkRequired) {
           if (NullHelpers::IsNull(startIter->first)) {
+            startIter++;
             continue;
           }
 
@@ -146,6 +201,40 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
     return MamaJenniesBitmap::LogicalOR(bitmaps);
   }
 
+  bool TryGetValueBitmaps(std::vector<ValueBitmap>& valueBitmaps) override {
+    valueBitmaps.clear();
+    for (auto& item : m_compressedBitmaps) {
+      if (!NullHelpers::IsNull(item.first)) {
+        valueBitmaps.emplace_back();
+        valueBitmaps.back().valueType = OperandType::STRING;
+        valueBitmaps.back().strVal = item.first;
+        valueBitmaps.back().bitmap = item.second;
+      }
+    }
+
+    return true;
+  }
+
+  bool TryGetOrderedBitmaps(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) override {
+    // The null value sorts after the empty string in the map, SQLite sorts
+    // nulls before every value
+    bitmaps.clear();
+    bitmaps.reserve(m_compressedBitmaps.size());
+    auto nullIter = m_compressedBitmaps.find(JONOONDB_NULL_STR);
+    if (nullIter != m_compressedBitmaps.end()) {
+      bitmaps.push_back(nullIter->second);
+    }
+
+    for (auto& item : m_compressedBitmaps) {
+      if (!NullHelpers::IsNull(item.first)) {
+        bitmaps.push_back(item.second);
+      }
+    }
+
+    return true;
+  }
+
  private:
   EWAHCompressedBitmapIndexerString(const IndexStat& indexStat,
                                     std::vector<std::string>& fieldNameTokens)
@@ -213,6 +302,7 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
       while (iter != m_compressedBitmaps.end()) {
         if (nullChkRequired) {
           if (NullHelpers::IsNull(iter->first)) {
+            iter++;
             continue;
           }
 
@@ -230,9 +320,34 @@ class EWAHCompressedBitmapIndexerString final: public Indexer {
     return MamaJenniesBitmap::LogicalOR(bitmaps);
   }
 
+  // Only the keys inside the range of the pattern prefix are visited and
+  // they are matched against the pattern only if the range is not exact.
+  std::shared_ptr<MamaJenniesBitmap> GetBitmapPattern(
+      const StringPattern& pattern) {
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    for (auto iter = m_compressedBitmaps.lower_bound(pattern.GetLowerBound());
+         iter != m_compressedBitmaps.end(); iter++) {
+      if (pattern.HasUpperBound() && iter->first >= pattern.GetUpperBound()) {
+        break;
+      }
+
+      if (NullHelpers::IsNull(iter->first)) {
+        continue;
+      }
+
+      if (pattern.IsExact() || pattern.Matches(iter->first)) {
+        bitmaps.push_back(iter->second);
+      }
+    }
+
+    return MamaJenniesBitmap::LogicalOR(bitmaps);
+  }
+
   IndexStat m_indexStat;
   std::vector<std::string> m_fieldNameTokens;
   std::map<std::string, std::shared_ptr<MamaJenniesBitmap>> m_compressedBitmaps;
   std::unique_ptr<Document> m_subDoc;
+  // (value, documentID) pairs staged by BulkInsert
+  std::vector<std::pair<std::string, std::uint64_t>> m_bulkEntries;
 };
 }  // namespace jonoondb_api
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "null_helpers.h"
+
+namespace jonoondb_api {
+// Inverted index for MATCH. Values are split into terms at every ASCII
+// character that is not a letter or a digit and the terms are lower cased.
+// Every term has a compressed posting list of the documents containing it
+// and the term ids of every document are kept in order to verify phrases.
+// Query syntax:
+//   term1 term2         documents containing both terms, same as AND
+//   term1 OR term2      documents containing either term
+//   "term1 term2"       documents containing the terms next to each other
+//   ( ... )             grouping, AND binds tighter than OR
+class FullTextIndexer final: public Indexer {
+ public:
+  FullTextIndexer(const IndexInfoImpl& indexInfo,
+                  const FieldType& fieldType) {
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (indexInfo.GetColumnName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty column name.";
+    } else if (indexInfo.GetType() != IndexType::FULL_TEXT) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType FULL_TEXT for FullTextIndexer.";
+    } else if (!IsValidFieldType(fieldType)) {
+      std::ostringstream ss;
+      ss << "Argument fieldType " << GetFieldString(fieldType)
+          << " is not valid for FullTextIndexer.";
+      errorMsg = ss.str();
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_fieldNameTokens = StringUtils::Split(indexInfo.GetColumnName(), ".");
+    m_indexStat = IndexStat(indexInfo, fieldType);
+    m_tokenOffsets.push_back(0);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_STRING);
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    auto val = DocumentUtils::GetStringValue(document, m_subDoc,
+                                             m_fieldNameTokens);
+    m_indexStat.GetStatistics().AddValue(val);
+    assert(m_tokenOffsets.size() == documentID + 1);
+    if (!NullHelpers::IsNull(val)) {
+      Tokenize(val, m_terms);
+      m_termIDs.clear();
+      for (auto& term : m_terms) {
+        auto termID = GetTermID(term);
+        m_tokens.push_back(termID);
+        m_termIDs.push_back(termID);
+      }
+
+      std::sort(m_termIDs.begin(), m_termIDs.end());
+      m_termIDs.erase(std::unique(m_termIDs.begin(), m_termIDs.end()),
+                      m_termIDs.end());
+      for (auto termID : m_termIDs) {
+        m_postings[termID]->Add(documentID);
+      }
+    }
+
+    m_tokenOffsets.push_back(m_tokens.size());
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    switch (constraint.op) {
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        if (constraint.operandType != OperandType::STRING) {
+          return std::make_shared<MamaJenniesBitmap>();
+        }
+
+        auto queryTokens = ParseQuery(constraint.strVal);
+        if (queryTokens.empty()) {
+          return std::make_shared<MamaJenniesBitmap>();
+        }
+
+        std::size_t pos = 0;
+        auto bitmap = EvaluateOr(queryTokens, pos);
+        if (pos != queryTokens.size()) {
+          ThrowInvalidQuery(constraint.strVal);
+        }
+        return bitmap;
+      }
+      default:
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator type "
+            << static_cast<std::int32_t>(constraint.op) << " is not valid.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    throw JonoonDBException("FilterRange is not supported by FullTextIndexer.",
+                            __FILE__, __func__, __LINE__);
+  }
+
+ private:
+  enum class QueryTokenType {
+    TERMS,
+    OR,
+    AND,
+    OPEN_PARENTHESIS,
+    CLOSE_PARENTHESIS
+  };
+
+  // A single term, a bare word that splits into several terms or a quoted
+  // phrase. Several terms have to appear next to each other.
+  struct QueryToken {
+    QueryTokenType type;
+    std::vector<std::string> terms;
+  };
+
+  static bool IsTermChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || static_cast<unsigned char>(c) >= 0x80;
+  }
+
+  static void Tokenize(const std::string& str,
+                       std::vector<std::string>& terms) {
+    terms.clear();
+    std::string term;
+    for (auto c : str) {
+      if (IsTermChar(c)) {
+        term.push_back((c >= 'A' && c <= 'Z') ?
+                       static_cast<char>(c + ('a' - 'A')) : c);
+      } else if (!term.empty()) {
+        terms.push_back(std::move(term));
+        term.clear();
+      }
+    }
+
+    if (!term.empty()) {
+      terms.push_back(std::move(term));
+    }
+  }
+
+  static void ThrowInvalidQuery(const std::string& query) {
+    std::ostringstream ss;
+    ss << "Full-text query '" << query << "' is not valid.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  static std::vector<QueryToken> ParseQuery(const std::string& query) {
+    std::vector<QueryToken> queryTokens;
+    std::size_t pos = 0;
+    while (pos < query.size()) {
+      auto c = query[pos];
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        pos++;
+      } else if (c == '(' || c == ')') {
+        queryTokens.push_back(QueryToken{
+            c == '(' ? QueryTokenType::OPEN_PARENTHESIS :
+                QueryTokenType::CLOSE_PARENTHESIS, {}});
+        pos++;
+      } else if (c == '"') {
+        auto end = query.find('"', pos + 1);
+        if (end == std::string::npos) {
+          ThrowInvalidQuery(query);
+        }
+        QueryToken queryToken{QueryTokenType::TERMS, {}};
+        Tokenize(query.substr(pos + 1, end - pos - 1), queryToken.terms);
+        if (!queryToken.terms.empty()) {
+          queryTokens.push_back(std::move(queryToken));
+        }
+        pos = end + 1;
+      } else {
+        auto end = std::min(query.find_first_of(" \t\n\r()\"", pos),
+                            query.size());
+        auto word = query.substr(pos, end - pos);
+        if (word == "OR" || word == "AND") {
+          queryTokens.push_back(QueryToken{
+              word == "OR" ? QueryTokenType::OR : QueryTokenType::AND, {}});
+        } else {
+          QueryToken queryToken{QueryTokenType::TERMS, {}};
+          Tokenize(word, queryToken.terms);
+          if (!queryToken.terms.empty()) {
+            queryTokens.push_back(std::move(queryToken));
+          }
+        }
+        pos = end;
+      }
+    }
+
+    return queryTokens;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> EvaluateOr(
+      const std::vector<QueryToken>& queryTokens, std::size_t& pos) {
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    bitmaps.push_back(EvaluateAnd(queryTokens, pos));
+    while (pos < queryTokens.size() &&
+        queryTokens[pos].type == QueryTokenType::OR) {
+      pos++;
+      bitmaps.push_back(EvaluateAnd(queryTokens, pos));
+    }
+
+    return MamaJenniesBitmap::LogicalOR(bitmaps);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> EvaluateAnd(
+      const std::vector<QueryToken>& queryTokens, std::size_t& pos) {
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    bitmaps.push_back(EvaluatePrimary(queryTokens, pos));
+    while (pos < queryTokens.size() &&
+        queryTokens[pos].type != QueryTokenType::OR &&
+        queryTokens[pos].type != QueryTokenType::CLOSE_PARENTHESIS) {
+      if (queryTokens[pos].type == QueryTokenType::AND) {
+        pos++;
+      }
+      bitmaps.push_back(EvaluatePrimary(queryTokens, pos));
+    }
+
+    return MamaJenniesBitmap::LogicalAND(bitmaps);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> EvaluatePrimary(
+      const std::vector<QueryToken>& queryTokens, std::size_t& pos) {
+    if (pos == queryTokens.size()) {
+      throw JonoonDBException("Full-text query ends unexpectedly.",
+                              __FILE__, __func__, __LINE__);
+    }
+
+    auto& queryToken = queryTokens[pos++];
+    if (queryToken.type == QueryTokenType::TERMS) {
+      return GetTermsBitmap(queryToken.terms);
+    }
+
+    if (queryToken.type == QueryTokenType::OPEN_PARENTHESIS) {
+      auto bitmap = EvaluateOr(queryTokens, pos);
+      if (pos == queryTokens.size() ||
+          queryTokens[pos].type != QueryTokenType::CLOSE_PARENTHESIS) {
+        throw JonoonDBException("Full-text query has an unclosed parenthesis.",
+                                __FILE__, __func__, __LINE__);
+      }
+      pos++;
+      return bitmap;
+    }
+
+    throw JonoonDBException("Full-text query has an unexpected operator.",
+                            __FILE__, __func__, __LINE__);
+  }
+
+  // Returns the documents containing the terms next to each other
+  std::shared_ptr<MamaJenniesBitmap> GetTermsBitmap(
+      const std::vector<std::string>& terms) {
+    std::vector<std::uint32_t> termIDs;
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    for (auto& term : terms) {
+      auto iter = m_termIDMap.find(term);
+      if (iter == m_termIDMap.end()) {
+        return std::make_shared<MamaJenniesBitmap>();
+      }
+      termIDs.push_back(iter->second);
+      bitmaps.push_back(m_postings[iter->second]);
+    }
+
+    auto candidates = MamaJenniesBitmap::LogicalAND(bitmaps);
+    if (termIDs.size() == 1) {
+      return candidates;
+    }
+
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    for (auto iter = candidates->begin(); iter != candidates->end(); ++iter) {
+      auto documentID = *iter;
+      auto begin = m_tokens.begin() + m_tokenOffsets[documentID];
+      auto end = m_tokens.begin() + m_tokenOffsets[documentID + 1];
+      if (std::search(begin, end, termIDs.begin(), termIDs.end()) != end) {
+        bitmap->Add(documentID);
+      }
+    }
+
+    return bitmap;
+  }
+
+  std::uint32_t GetTermID(const std::string& term) {
+    auto iter = m_termIDMap.find(term);
+    if (iter != m_termIDMap.end()) {
+      return iter->second;
+    }
+
+    if (m_postings.size() >= std::numeric_limits<std::uint32_t>::max()) {
+      throw JonoonDBException(
+          "FullTextIndexer cannot hold more distinct terms.",
+          __FILE__, __func__, __LINE__);
+    }
+
+    auto termID = static_cast<std::uint32_t>(m_postings.size());
+    m_termIDMap.emplace(term, termID);
+    m_postings.push_back(std::make_shared<MamaJenniesBitmap>());
+    return termID;
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_fieldNameTokens;
+  std::unordered_map<std::string, std::uint32_t> m_termIDMap;
+  // Posting list of every term id
+  std::vector<std::shared_ptr<MamaJenniesBitmap>> m_postings;
+  // Term ids of all documents in order, the terms of document i are
+  // [m_tokenOffsets[i], m_tokenOffsets[i + 1])
+  std::vector<std::uint32_t> m_tokens;
+  std::vector<std::size_t> m_tokenOffsets;
+  // Reused by Insert
+  std::vector<std::string> m_terms;
+  std::vector<std::uint32_t> m_termIDs;
+  std::unique_ptr<Document> m_subDoc;
+};
+}  // namespace jonoondb_api
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "null_helpers.h"
+#include "sort_utils.h"
+
+namespace jonoondb_api {
+// Hash index for equality lookups. Distinct keys are stored in m_entries and
+// found through an open addressing table whose buckets are one cache line
+// each: 8 slots holding a 32 bit tag taken from the hash and the position of
+// the key in m_entries. Buckets are probed linearly.
+// With IndexType UNIQUE_HASH, ValidateForIndexing rejects documents whose
+// key already exists in the index or appears twice in the batch.
+// T can be std::int64_t, double or std::string.
+template<typename T>
+class HashIndexer final: public Indexer {
+ public:
+  HashIndexer(const IndexInfoImpl& indexInfo,
+              const FieldType& fieldType)
+      : m_bucketMask(0), m_buckets(nullptr) {
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (indexInfo.GetColumnName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty column name.";
+    } else if (indexInfo.GetType() != IndexType::HASH &&
+        indexInfo.GetType() != IndexType::UNIQUE_HASH) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType HASH or UNIQUE_HASH for HashIndexer.";
+    } else if (!IsValidFieldType(fieldType)) {
+      std::ostringstream ss;
+      ss << "Argument fieldType " << GetFieldString(fieldType)
+          << " is not valid for HashIndexer.";
+      errorMsg = ss.str();
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_fieldNameTokens = StringUtils::Split(indexInfo.GetColumnName(), ".");
+    m_indexStat = IndexStat(indexInfo, fieldType);
+    m_isUnique = indexInfo.GetType() == IndexType::UNIQUE_HASH;
+    Rehash(INITIAL_BUCKET_COUNT);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_INT8
+        || fieldType == FieldType::BASE_TYPE_INT16
+        || fieldType == FieldType::BASE_TYPE_INT32
+        || fieldType == FieldType::BASE_TYPE_INT64
+        || fieldType == FieldType::BASE_TYPE_FLOAT32
+        || fieldType == FieldType::BASE_TYPE_DOUBLE
+        || fieldType == FieldType::BASE_TYPE_STRING);
+  }
+
+  void ValidateForIndexing(
+      const std::vector<std::unique_ptr<Document>>& documents) override {
+    if (!m_isUnique) {
+      return;
+    }
+
+    std::vector<T> keys;
+    keys.reserve(documents.size());
+    for (auto& document : documents) {
+      T key;
+      if (!TryGetValue(*document, key)) {
+        continue;
+      }
+
+      if (Find(key, Hash(key)) != EMPTY_SLOT) {
+        ThrowDuplicateKey(key);
+      }
+      keys.push_back(std::move(key));
+    }
+
+    std::sort(keys.begin(), keys.end());
+    auto iter = std::adjacent_find(keys.begin(), keys.end());
+    if (iter != keys.end()) {
+      ThrowDuplicateKey(*iter);
+    }
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    T key;
+    if (!TryGetValue(document, key)) {
+      // Null values never satisfy a comparison so they are not indexed
+      m_indexStat.GetStatistics().AddNull();
+      return;
+    }
+
+    m_indexStat.GetStatistics().AddValue(key);
+    auto hash = Hash(key);
+    auto entryIndex = Find(key, hash);
+    if (entryIndex != EMPTY_SLOT) {
+      m_moreDocumentIDs[entryIndex].push_back(documentID);
+      return;
+    }
+
+    if ((m_entries.size() + 1) * 4 > (m_bucketMask + 1) * SLOT_COUNT * 3) {
+      Rehash((m_bucketMask + 1) * 2);
+    }
+
+    m_entries.push_back(Entry{std::move(key), hash, documentID});
+    AddToTable(hash, static_cast<std::uint32_t>(m_entries.size() - 1));
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    if (constraint.op != IndexConstraintOperator::EQUAL) {
+      std::ostringstream ss;
+      ss << "IndexConstraintOperator type "
+          << static_cast<std::int32_t>(constraint.op) << " is not valid.";
+      throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    T key;
+    if (!TryGetKey(constraint, key)) {
+      return bitmap;
+    }
+
+    auto entryIndex = Find(key, Hash(key));
+    if (entryIndex != EMPTY_SLOT) {
+      // Documents are inserted in increasing documentID order
+      bitmap->Add(m_entries[entryIndex].documentID);
+      auto iter = m_moreDocumentIDs.find(entryIndex);
+      if (iter != m_moreDocumentIDs.end()) {
+        for (auto documentID : iter->second) {
+          bitmap->Add(documentID);
+        }
+      }
+    }
+
+    return bitmap;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    throw JonoonDBException("HashIndexer does not support range filters.",
+                            __FILE__, __func__, __LINE__);
+  }
+
+  bool TryGetDocumentID(const Constraint& constraint,
+                        std::uint64_t& documentID) override {
+    T key;
+    if (constraint.op != IndexConstraintOperator::EQUAL ||
+        !TryGetKey(constraint, key)) {
+      return false;
+    }
+
+    auto entryIndex = Find(key, Hash(key));
+    if (entryIndex == EMPTY_SLOT) {
+      return false;
+    }
+
+    documentID = m_entries[entryIndex].documentID;
+    return true;
+  }
+
+ private:
+  static const std::uint32_t SLOT_COUNT = 8;
+  static const std::uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+  static const std::size_t INITIAL_BUCKET_COUNT = 16;
+  static const std::size_t CACHE_LINE_SIZE = 64;
+
+  // Slots of a bucket are filled in order, so the first empty slot ends
+  // a probe.
+  struct Bucket {
+    std::uint32_t tags[SLOT_COUNT];
+    std::uint32_t entryIndexes[SLOT_COUNT];
+  };
+  static_assert(sizeof(Bucket) == CACHE_LINE_SIZE,
+                "Bucket should occupy exactly one cache line.");
+
+  struct Entry {
+    T key;
+    std::uint64_t hash;
+    std::uint64_t documentID;
+  };
+
+  static std::uint64_t Mix(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  static std::uint64_t Hash(std::int64_t key) {
+    return Mix(static_cast<std::uint64_t>(key));
+  }
+
+  static std::uint64_t Hash(double key) {
+    // Sortable key maps -0.0 and 0.0 to the same value
+    return Mix(SortUtils::ToSortableKey(key));
+  }
+
+  static std::uint64_t Hash(const std::string& key) {
+    return Mix(std::hash<std::string>()(key));
+  }
+
+  bool TryGetValue(const Document& document, std::int64_t& val) {
+    val = DocumentUtils::GetIntegerValue(document, m_subDoc,
+                                         m_fieldNameTokens);
+    return !NullHelpers::IsNull(val);
+  }
+
+  bool TryGetValue(const Document& document, double& val) {
+    val = DocumentUtils::GetFloatValue(document, m_subDoc, m_fieldNameTokens);
+    return !std::isnan(val) && !NullHelpers::IsNull(val);
+  }
+
+  bool TryGetValue(const Document& document, std::string& val) {
+    val = DocumentUtils::GetStringValue(document, m_subDoc, m_fieldNameTokens);
+    return !NullHelpers::IsNull(val);
+  }
+
+  // Converts the operand of the constraint to a key. Returns false if no
+  // key of this index can be equal to the operand.
+  static bool TryGetKey(const Constraint& constraint, std::int64_t& key) {
+    if (constraint.operandType == OperandType::INTEGER) {
+      key = constraint.operand.int64Val;
+      return true;
+    } else if (constraint.operandType == OperandType::DOUBLE) {
+      auto val = constraint.operand.doubleVal;
+      // 2^63 and -2^63 are exactly representable as double
+      if (val != std::floor(val) || val < -9223372036854775808.0 ||
+          val >= 9223372036854775808.0) {
+        return false;
+      }
+      key = static_cast<std::int64_t>(val);
+      return true;
+    }
+
+    return false;
+  }
+
+  static bool TryGetKey(const Constraint& constraint, double& key) {
+    if (constraint.operandType == OperandType::INTEGER) {
+      key = static_cast<double>(constraint.operand.int64Val);
+      return true;
+    } else if (constraint.operandType == OperandType::DOUBLE) {
+      key = constraint.operand.doubleVal;
+      return !std::isnan(key);
+    }
+
+    return false;
+  }
+
+  static bool TryGetKey(const Constraint& constraint, std::string& key) {
+    if (constraint.operandType == OperandType::STRING) {
+      key = constraint.strVal;
+      return true;
+    }
+
+    return false;
+  }
+
+  // Returns the position of the key in m_entries or EMPTY_SLOT
+  std::uint32_t Find(const T& key, std::uint64_t hash) const {
+    auto tag = static_cast<std::uint32_t>(hash >> 32);
+    auto bucketIndex = hash & m_bucketMask;
+    while (true) {
+      const Bucket& bucket = m_buckets[bucketIndex];
+      for (std::uint32_t i = 0; i < SLOT_COUNT; i++) {
+        auto entryIndex = bucket.entryIndexes[i];
+        if (entryIndex == EMPTY_SLOT) {
+          return EMPTY_SLOT;
+        }
+
+        if (bucket.tags[i] == tag && m_entries[entryIndex].key == key) {
+          return entryIndex;
+        }
+      }
+      bucketIndex = (bucketIndex + 1) & m_bucketMask;
+    }
+  }
+
+  void AddToTable(std::uint64_t hash, std::uint32_t entryIndex) {
+    auto bucketIndex = hash & m_bucketMask;
+    while (true) {
+      Bucket& bucket = m_buckets[bucketIndex];
+      for (std::uint32_t i = 0; i < SLOT_COUNT; i++) {
+        if (bucket.entryIndexes[i] == EMPTY_SLOT) {
+          bucket.tags[i] = static_cast<std::uint32_t>(hash >> 32);
+          bucket.entryIndexes[i] = entryIndex;
+          return;
+        }
+      }
+      bucketIndex = (bucketIndex + 1) & m_bucketMask;
+    }
+  }
+
+  // bucketCount should be a power of 2
+  void Rehash(std::size_t bucketCount) {
+    // Over allocate so that the buckets can start at a cache line boundary
+    std::unique_ptr<char[]> storage(
+        new char[bucketCount * sizeof(Bucket) + CACHE_LINE_SIZE]);
+    void* ptr = storage.get();
+    std::size_t space = bucketCount * sizeof(Bucket) + CACHE_LINE_SIZE;
+    std::align(CACHE_LINE_SIZE, bucketCount * sizeof(Bucket), ptr, space);
+    auto buckets = static_cast<Bucket*>(ptr);
+    std::memset(buckets, 0xFF, bucketCount * sizeof(Bucket));
+
+    m_bucketStorage = std::move(storage);
+    m_buckets = buckets;
+    m_bucketMask = bucketCount - 1;
+    for (std::size_t i = 0; i < m_entries.size(); i++) {
+      AddToTable(m_entries[i].hash, static_cast<std::uint32_t>(i));
+    }
+  }
+
+  void ThrowDuplicateKey(const T& key) {
+    std::ostringstream ss;
+    ss << "Duplicate key '" << key << "' for unique index "
+        << m_indexStat.GetIndexInfo().GetIndexName() << ".";
+    throw DuplicateKeyException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_fieldNameTokens;
+  std::unique_ptr<Document> m_subDoc;
+  bool m_isUnique;
+  std::vector<Entry> m_entries;
+  // Documents after the first one for keys that are not unique
+  std::unordered_map<std::uint32_t, std::vector<std::uint64_t>>
+      m_moreDocumentIDs;
+  std::size_t m_bucketMask;
+  std::unique_ptr<char[]> m_bucketStorage;
+  Bucket* m_buckets;
+};
+}  // namespace jonoondb_api
@@ -10,12 +10,23 @@ namespace jonoondb_api {
 class IDSequence final {
  public:
   IDSequence(std::shared_ptr<MamaJenniesBitmap> bitmap, int vecSize);
+  // Returns the ids of filter grouped by orderedBitmaps, in the order of the
+  // bitmaps or the reverse order if descending. Each group is intersected
+  // with the filter only when it is reached, so stopping early skips the
+  // remaining groups.
+  IDSequence(std::shared_ptr<MamaJenniesBitmap> filter,
+             std::vector<std::shared_ptr<MamaJenniesBitmap>> orderedBitmaps,
+             bool descending, int vecSize);
   const gsl::span<std::uint64_t>& Current();
   bool Next();
  private:
   std::shared_ptr<MamaJenniesBitmap> m_bitmap;
-  std::unique_ptr<MamaJenniesBitmap::const_iterator> m_iter;
-  std::unique_ptr<MamaJenniesBitmap::const_iterator> m_end;
+  MamaJenniesBitmapDecoder m_decoder;
+  std::shared_ptr<MamaJenniesBitmap> m_filter;
+  std::vector<std::shared_ptr<MamaJenniesBitmap>> m_orderedBitmaps;
+  bool m_descending = false;
+  // Number of ordered bitmaps that were intersected with the filter
+  std::size_t m_groupCount = 0;
   std::vector<std::uint64_t> m_currentVector;
   gsl::span<std::uint64_t> m_currentSpan;
 };
@@ -5,8 +5,11 @@
 #include <unordered_map>
 #include <string>
 #include <cstdint>
-#include <mutex>
+#include <atomic>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/lock_types.hpp>
 #include "indexer.h"
+#include "concurrent_lru_cache.h"
 
 namespace jonoondb_api {
 // Forward declarations
@@ -20,6 +23,7 @@ enum class IndexConstraintOperator
 struct Constraint;
 class DocumentIDGenerator;
 class BufferImpl;
+class CompositeIndexer;
 
 class IndexManager {
  public:
@@ -31,13 +35,41 @@ class IndexManager {
   void CreateIndex(const IndexInfoImpl& indexInfo,
                    const std::unordered_map<std::string,
                                             FieldType>& columnTypes);
+  // Creates an indexer that is not used until it is added with
+  // TryAddBuiltIndexer. This lets indexes be built in the background.
+  std::unique_ptr<Indexer> CreateIndexer(
+      const IndexInfoImpl& indexInfo,
+      const std::unordered_map<std::string, FieldType>& columnTypes);
+  // Adds an indexer that has indexed the first documentCount documents if
+  // no other document has an id yet. New documents are indexed by it from
+  // then on and queries see it from their next call into IndexManager.
+  bool TryAddBuiltIndexer(std::unique_ptr<Indexer>& indexer,
+                          std::uint64_t documentCount,
+                          const DocumentIDGenerator& documentIDGenerator);
+  bool HasIndex(const std::string& indexName);
+  bool TryDropIndex(const std::string& indexName);
   std::uint64_t IndexDocuments(DocumentIDGenerator& documentIDGenerator,
                                const std::vector<std::unique_ptr<Document>>& documents);
+  void BulkIndexDocuments(std::uint64_t startID,
+                          const std::vector<std::unique_ptr<Document>>& documents);
+  void FinalizeBulkIndexing();
   bool
       TryGetBestIndex(const std::string& columnName, IndexConstraintOperator op,
                       IndexStat& indexStat);
+  // Finds the composite index that answers the most constraints with one
+  // lookup. The positions of the constraints it answers are returned in
+  // coveredConstraints. Only the operators of the constraints are used.
+  bool TryGetBestCompositeIndex(const std::vector<Constraint>& constraints,
+                                IndexStat& indexStat,
+                                std::vector<std::size_t>& coveredConstraints,
+                                double& selectivity);
+  // Results are cached by constraint set. A cached result is brought up to
+  // date by filtering only the documents indexed since it was computed.
   std::shared_ptr<MamaJenniesBitmap>
       Filter(const std::vector<Constraint>& constraints);
+  bool TryGetDocumentID(const Constraint& constraint,
+                        std::uint64_t& documentID);
+  bool HasUniqueIndex();
   bool TryGetIntegerValue(std::uint64_t documentID,
                           const std::string& columnName,
                           std::int64_t& val);
@@ -57,10 +89,72 @@ class IndexManager {
   bool TryGetDoubleVector(const gsl::span<std::uint64_t>& documentIDs,
                           const std::string& columnName,
                           std::vector<double>& values);
+  // Gets the distinct values of the column with their documents from an
+  // index that keeps a bitmap per value
+  bool TryGetValueBitmaps(const std::string& columnName,
+                          std::vector<ValueBitmap>& valueBitmaps);
+  // Finds an index that can return the documents in the order of the values
+  // of the column
+  bool TryGetOrderedIndex(const std::string& columnName, IndexStat& indexStat);
+  // Gets the bitmaps of the distinct values of the column in ascending
+  // order, see Indexer::TryGetOrderedBitmaps
+  bool TryGetOrderedBitmaps(
+      const std::string& columnName,
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps);
 
  private:
+  struct FilterCacheEntry {
+    std::shared_ptr<MamaJenniesBitmap> bitmap;
+    // Number of documents indexed when bitmap was computed
+    std::uint64_t documentCount;
+  };
+  static const std::size_t FILTER_CACHE_SIZE = 64;
+
+  // Constraints answered by a composite index: equality constraints on its
+  // leading columns and optionally a range on the next column
+  struct CompositeMatch {
+    std::vector<std::size_t> equalConstraints;
+    std::size_t lowerConstraint = NO_CONSTRAINT;
+    std::size_t upperConstraint = NO_CONSTRAINT;
+    std::vector<std::size_t> GetCoveredConstraints() const;
+  };
+  static const std::size_t NO_CONSTRAINT = static_cast<std::size_t>(-1);
+
+  void AddIndexer(std::unique_ptr<Indexer> indexer);
+  // Filters the documents from startID on, see Indexer::FilterFrom
+  std::shared_ptr<MamaJenniesBitmap> FilterFrom(
+      const std::vector<Constraint>& constraints, std::uint64_t startID);
+  // The same constraints in any order give the same key
+  static std::string GetFilterCacheKey(
+      const std::vector<Constraint>& constraints);
+  // Indexers added by TryAddBuiltIndexer are moved into m_columnIndexerMap
+  // by the next call that uses the indexers, before it takes the shared lock
+  void AddBuiltIndexers();
+  void AddBuiltIndexersUnlocked();
+  // The choice only depends on the columns and operators of the
+  // constraints, so jonoondb_bestindex and Filter make the same choice
+  CompositeIndexer* GetBestCompositeIndexer(
+      const std::vector<Constraint>& constraints, CompositeMatch& match);
+  bool HasIndexer(const std::string& columnName, IndexConstraintOperator op);
+  // Picks the indexer with the lowest estimated cost. The constraints are
+  // used to estimate the selectivity when their operands are known.
+  Indexer* GetBestIndexer(const std::vector<std::unique_ptr<Indexer>>& indexers,
+                          IndexConstraintOperator op,
+                          const Constraint* constraint = nullptr,
+                          const Constraint* upperConstraint = nullptr);
   std::unique_ptr<ColumnIndexderMap> m_columnIndexerMap;
-  std::mutex m_mutex;
+  // Composite indexers in creation order, they are owned by
+  // m_columnIndexerMap under their comma separated column names
+  std::vector<CompositeIndexer*> m_compositeIndexers;
+  std::vector<std::unique_ptr<Indexer>> m_builtIndexers;
+  std::atomic<bool> m_hasBuiltIndexers;
+  // Held exclusively while the indexers or m_columnIndexerMap change and
+  // shared while they are read, so a dropped indexer is never in use
+  boost::shared_mutex m_mutex;
+  // Documents that are queryable in every index
+  std::atomic<std::uint64_t> m_documentCount;
+  std::uint64_t m_bulkDocumentCount = 0;
+  ConcurrentLRUCache<std::string, FilterCacheEntry> m_filterCache;
 };
 }
 // namespace jonoondb_api
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory>
 #include "index_info_impl.h"
+#include "column_statistics.h"
 #include "enums.h"
 
 namespace jonoondb_api {
@@ -10,9 +12,20 @@ class IndexStat {
   IndexStat(const IndexInfoImpl& indexInfo, FieldType fieldType);
   const IndexInfoImpl& GetIndexInfo() const;
   FieldType GetFieldType() const;
+
+  // Statistics of the indexed values, kept up to date by the indexer.
+  // Copies of an IndexStat share the statistics of the index.
+  ColumnStatistics& GetStatistics();
+  const ColumnStatistics& GetStatistics() const;
+
+  // Estimated cost of answering a constraint with the operator and the
+  // given selectivity with this index. The unit is roughly the cost of
+  // evaluating the constraint on one value, so the cost of a full scan is
+  // the number of documents.
+  double EstimateCost(IndexConstraintOperator op, double selectivity) const;
  private:
   IndexInfoImpl m_indexInfo;
   FieldType m_fieldType;
-  // In future add selectivity, avgEntrySizeInBytes etc.
+  std::shared_ptr<ColumnStatistics> m_statistics;
 };
-} // jonoondb_api
\ No newline at end of file
+} // jonoondb_api
@@ -1,22 +1,54 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <gsl/span.h>
+#include "mama_jennies_bitmap.h"
+#include "constraint.h"
 
 namespace jonoondb_api {
 // Forward declarations
 class IndexInfoImpl;
 class Document;
 class IndexStat;
-struct Constraint;
-class MamaJenniesBitmap;
 class BufferImpl;
 
+// A distinct value of a column and the documents that have it
+struct ValueBitmap {
+  OperandType valueType;
+  Operand value;
+  std::string strVal;
+  std::shared_ptr<MamaJenniesBitmap> bitmap;
+};
+
 class Indexer {
  public:
   virtual ~Indexer() {
   }
+
+  // Called before the documents are inserted. Indexers that enforce
+  // constraints e.g. uniqueness throw here, Insert should not fail after
+  // the documents have been validated.
+  virtual void ValidateForIndexing(
+      const std::vector<std::unique_ptr<Document>>& documents) {
+  }
+
   virtual void Insert(std::uint64_t documentID, const Document& document) = 0;
+
+  // Indexes documents with consecutive ids starting at startID. Indexers
+  // can stage the entries and build their structures in FinalizeBulkInsert.
+  // The index is only guaranteed to be queryable after FinalizeBulkInsert.
+  virtual void BulkInsert(
+      std::uint64_t startID,
+      const std::vector<std::unique_ptr<Document>>& documents) {
+    for (std::size_t i = 0; i < documents.size(); i++) {
+      Insert(startID + i, *documents[i]);
+    }
+  }
+
+  virtual void FinalizeBulkInsert() {
+  }
+
   virtual const IndexStat& GetIndexStats() = 0;
   virtual std::shared_ptr<MamaJenniesBitmap>
       Filter(const Constraint& constraint) = 0;
@@ -24,6 +56,35 @@ class Indexer {
       const Constraint& lowerConstraint,
       const Constraint& upperConstraint) = 0;
 
+  // Same as Filter and FilterRange but only the documents with an id of at
+  // least startID have to be complete in the result, older documents may be
+  // left out but are never wrongly included. Indexers that can skip the
+  // older documents override these so that refreshing a cached filter
+  // result only costs the new documents.
+  virtual std::shared_ptr<MamaJenniesBitmap> FilterFrom(
+      const Constraint& constraint, std::uint64_t startID) {
+    return Filter(constraint);
+  }
+
+  virtual std::shared_ptr<MamaJenniesBitmap> FilterRangeFrom(
+      const Constraint& lowerConstraint, const Constraint& upperConstraint,
+      std::uint64_t startID) {
+    return FilterRange(lowerConstraint, upperConstraint);
+  }
+
+  // Finds a document that satisfies the EQUAL constraint.
+  virtual bool TryGetDocumentID(const Constraint& constraint,
+                                std::uint64_t& documentID) {
+    auto bitmap = Filter(constraint);
+    auto iter = bitmap->begin();
+    if (iter == bitmap->end()) {
+      return false;
+    }
+
+    documentID = *iter;
+    return true;
+  }
+
   virtual bool TryGetIntegerValue(std::uint64_t documentID, std::int64_t& val) {
     return false;
   }
@@ -51,5 +112,18 @@ class Indexer {
       std::vector<double>& values) {
     return false;
   }
+
+  // Returns the distinct non null values in increasing order with their
+  // documents. Only indexers that keep a bitmap per value support this.
+  virtual bool TryGetValueBitmaps(std::vector<ValueBitmap>& valueBitmaps) {
+    return false;
+  }
+
+  // Returns the bitmaps of the distinct values in the order SQLite sorts the
+  // values ascending, i.e. the bitmap of the nulls first.
+  virtual bool TryGetOrderedBitmaps(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) {
+    return false;
+  }
 };
 } // namespace jonoondb_api
@@ -3,11 +3,13 @@
 #include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace jonoondb_api {
 // Forward declarations
 class IndexInfoImpl;
 class Indexer;
+class CompositeIndexer;
 enum class FieldType
     : std::int8_t;
 
@@ -16,6 +18,9 @@ class IndexerFactory {
   static Indexer* CreateIndexer(
       const IndexInfoImpl& indexInfo,
       const FieldType& fieldType);
+  static CompositeIndexer* CreateCompositeIndexer(
+      const IndexInfoImpl& indexInfo,
+      const std::vector<FieldType>& fieldTypes);
  private:
   IndexerFactory() = delete;
   IndexerFactory(const IndexerFactory&) = delete;
@@ -0,0 +1,4 @@
+// the configured options and settings
+#define MAJOR "0"
+#define MINOR "1"
+#define PATCH "0"
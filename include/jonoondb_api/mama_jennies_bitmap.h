@@ -2,7 +2,9 @@
 
 #include <memory>
 #include <cstdint>
+#include <cstddef>
 #include "ewah_boolarray/ewah.h"
+#include "roaring_bitmap.h"
 
 namespace jonoondb_api {
 
@@ -10,6 +12,8 @@ class MamaJenniesBitmapConstIterator {
  public:
   MamaJenniesBitmapConstIterator
       (EWAHBoolArray<std::uint64_t>::const_iterator& iter);
+  MamaJenniesBitmapConstIterator(const RoaringBitmap::ConstIterator& iter);
+  MamaJenniesBitmapConstIterator(const MamaJenniesBitmapConstIterator& other);
   std::size_t operator*() const;
   MamaJenniesBitmapConstIterator& operator++();
   bool operator==(const MamaJenniesBitmapConstIterator& other);
@@ -19,9 +23,45 @@ class MamaJenniesBitmapConstIterator {
   bool operator>(const MamaJenniesBitmapConstIterator& other);
   bool operator>=(const MamaJenniesBitmapConstIterator& other);
  private:
-  EWAHBoolArray<std::uint64_t>::const_iterator m_iter;
+  // Only one of the iterators is used, the one of the bitmap's backend
+  std::unique_ptr<EWAHBoolArray<std::uint64_t>::const_iterator> m_iter;
+  RoaringBitmap::ConstIterator m_roaringIter;
 };
 
+class MamaJenniesBitmap;
+
+// Expands a bitmap into positions a batch at a time. Literal words are
+// decoded with a count trailing zeros loop, runs of ones are written as
+// consecutive positions and runs of zeros are skipped without looking at
+// the bits. The bitmap has to outlive the decoder and stay unchanged.
+class MamaJenniesBitmapDecoder {
+ public:
+  explicit MamaJenniesBitmapDecoder(const MamaJenniesBitmap& bitmap);
+  // Writes the next positions in increasing order, at most capacity of
+  // them. Returns how many were written, 0 once the bitmap is exhausted.
+  std::size_t Decode(std::uint64_t* positions, std::size_t capacity);
+
+ private:
+  std::unique_ptr<EWAHBoolArrayRawIterator<std::uint64_t>> m_rawIter;
+  RoaringBitmap::ConstIterator m_roaringIter;
+  // Position of the first bit of the next EWAH word
+  std::uint64_t m_nextWordPosition = 0;
+  // Positions [m_runNext, m_runEnd) of the current run of ones
+  std::uint64_t m_runNext = 0;
+  std::uint64_t m_runEnd = 0;
+  // Literal words of the current marker word that are not decoded yet
+  const std::uint64_t* m_literals = nullptr;
+  std::size_t m_literalCount = 0;
+  // Bits of the current literal word that are not decoded yet
+  std::uint64_t m_word = 0;
+  std::uint64_t m_wordPosition = 0;
+};
+
+// The bits are kept either EWAH compressed, which suits bitmaps built in
+// increasing order with long clean runs, or in a RoaringBitmap, which suits
+// sparse and clustered bitmaps and accepts bits in any order. A bitmap
+// starts as EWAH and moves to Roaring when a bit is added out of order or
+// when Optimize finds Roaring smaller.
 class MamaJenniesBitmap {
  public:
   MamaJenniesBitmap();
@@ -30,10 +70,27 @@ class MamaJenniesBitmap {
   MamaJenniesBitmap& operator=(const MamaJenniesBitmap& other);
   MamaJenniesBitmap& operator=(MamaJenniesBitmap&& other);
   void Add(std::uint64_t x);
+  // Appends the next 64 bits of the bitmap. Only use this on bitmaps that
+  // are built entirely with AddWord so that every word stays aligned.
+  void AddWord(std::uint64_t word);
+  // Appends count words. Runs of clean words are added as a single
+  // running length word and runs of dirty words are copied in one go.
+  void AddWords(const std::uint64_t* words, std::size_t count);
+  // Appends count words of zeros
+  void AddEmptyWords(std::size_t count);
+  // Keeps the bits in whichever backend needs fewer bytes. Meant to be
+  // called once a bitmap is completely built.
+  void Optimize();
+  bool IsRoaring() const {
+    return m_roaringBitmap != nullptr;
+  }
   void LogicalAND(const MamaJenniesBitmap& other, MamaJenniesBitmap& output);
   void LogicalOR(const MamaJenniesBitmap& other, MamaJenniesBitmap& output);
 
 
+  // Returns a bitmap with the bits [0, count) set. It is a single run of
+  // ones, so it takes O(1) space and time to build, decode and combine.
+  static std::shared_ptr<MamaJenniesBitmap> CreateRange(std::uint64_t count);
   static std::shared_ptr<MamaJenniesBitmap>
       LogicalAND(std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps);
   static std::shared_ptr<MamaJenniesBitmap>
@@ -44,12 +101,31 @@ class MamaJenniesBitmap {
   const_iterator end();
   std::unique_ptr<const_iterator> begin_pointer();
   std::unique_ptr<const_iterator> end_pointer();
+  // Number of set bits. It is kept up to date by Add and the logical
+  // operations, so this and IsEmpty are O(1).
+  std::uint64_t GetCount();
+  bool IsEmpty();
 
  private:
-  bool IsEmpty();
+  friend class MamaJenniesBitmapDecoder;
   std::uint64_t GetSizeInBits();
+  std::size_t GetSizeInBytes();
+  // ORs the bits into a dense buffer of count words
+  void OrInto(std::uint64_t* words, std::size_t count);
+  static std::shared_ptr<MamaJenniesBitmap> DenseLogicalOR(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps,
+      std::size_t wordCount);
+  static std::shared_ptr<MamaJenniesBitmap> MergeLogicalOR(
+      std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps);
   MamaJenniesBitmap
       (std::unique_ptr<EWAHBoolArray<std::uint64_t>> ewahBoolArray);
+  void ConvertToRoaring();
+  static void ToRoaring(const EWAHBoolArray<std::uint64_t>& ewahBoolArray,
+                        RoaringBitmap& roaringBitmap);
+  // Exactly one of the two is set
   std::unique_ptr<EWAHBoolArray<std::uint64_t>> m_ewahBoolArray;
+  std::unique_ptr<RoaringBitmap> m_roaringBitmap;
+  // Number of set bits of m_ewahBoolArray, RoaringBitmap keeps its own
+  std::uint64_t m_ewahCount = 0;
 };
 } // namesapce jonoondb_api
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "scan_kernels.h"
+
+namespace jonoondb_api {
+// Append only column of integers stored in blocks of ScanKernels::BLOCK_SIZE
+// values. A full block is frame of reference encoded when that at least
+// halves its size: every value is stored as its difference from the block
+// minimum using just enough bits. Blocks that do not compress that well are
+// kept as plain T values so that they can use the SIMD scan kernels. The
+// last block is always kept unpacked so that appends stay cheap.
+template<typename T>
+class PackedIntegerVector {
+ public:
+  void PushBack(T val) {
+    m_tail.push_back(val);
+    if (m_tail.size() == ScanKernels::BLOCK_SIZE) {
+      SealTail();
+    }
+  }
+
+  std::size_t Size() const {
+    return m_blocks.size() * ScanKernels::BLOCK_SIZE + m_tail.size();
+  }
+
+  T Get(std::size_t index) const {
+    auto blockIndex = index / ScanKernels::BLOCK_SIZE;
+    auto offset = index % ScanKernels::BLOCK_SIZE;
+    if (blockIndex == m_blocks.size()) {
+      return m_tail[offset];
+    }
+
+    auto& block = m_blocks[blockIndex];
+    if (block.bitWidth == 0) {
+      return block.values[offset];
+    }
+
+    return static_cast<T>(static_cast<std::uint64_t>(block.base) +
+        Extract(block, offset * block.bitWidth));
+  }
+
+  // Matches the values in the inclusive range [lower, upper] like
+  // ScanKernels::Between. offset has to be the start of a block and count
+  // can not go past the block.
+  void Between(std::size_t offset, std::size_t count, T lower, T upper,
+               std::uint64_t* words) const {
+    auto blockIndex = offset / ScanKernels::BLOCK_SIZE;
+    if (blockIndex == m_blocks.size()) {
+      ScanKernels::Between(m_tail.data(), count, lower, upper, words);
+      return;
+    }
+
+    auto& block = m_blocks[blockIndex];
+    if (block.bitWidth == 0) {
+      ScanKernels::Between(block.values.data(), count, lower, upper, words);
+      return;
+    }
+
+    // Translate the range to the stored differences
+    auto wordCount =
+        (count + ScanKernels::WORD_SIZE_IN_BITS - 1) /
+            ScanKernels::WORD_SIZE_IN_BITS;
+    if (upper < block.base) {
+      std::fill(words, words + wordCount, 0);
+      return;
+    }
+    std::uint64_t lowerDiff = lower <= block.base ? 0 :
+        static_cast<std::uint64_t>(lower) -
+            static_cast<std::uint64_t>(block.base);
+    std::uint64_t upperDiff = std::min(
+        static_cast<std::uint64_t>(upper) -
+            static_cast<std::uint64_t>(block.base),
+        MaxValue(block.bitWidth));
+    if (lowerDiff > upperDiff) {
+      std::fill(words, words + wordCount, 0);
+      return;
+    }
+
+    auto width = upperDiff - lowerDiff;
+    std::size_t bitPosition = 0;
+    for (std::size_t i = 0; i < count; i += ScanKernels::WORD_SIZE_IN_BITS) {
+      auto size = std::min(count - i,
+                           std::size_t(ScanKernels::WORD_SIZE_IN_BITS));
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < size; j++) {
+        auto diff = Extract(block, bitPosition);
+        word |= static_cast<std::uint64_t>(diff - lowerDiff <= width) << j;
+        bitPosition += block.bitWidth;
+      }
+      words[i / ScanKernels::WORD_SIZE_IN_BITS] = word;
+    }
+  }
+
+ private:
+  struct Block {
+    std::int64_t base = 0;
+    // Number of bits per packed value, 0 if the block is not packed
+    std::uint32_t bitWidth = 0;
+    std::vector<std::uint64_t> packed;
+    std::vector<T> values;
+  };
+
+  static std::uint64_t MaxValue(std::uint32_t bitWidth) {
+    return bitWidth == 64 ? ~std::uint64_t(0) :
+        (std::uint64_t(1) << bitWidth) - 1;
+  }
+
+  static std::uint64_t Extract(const Block& block, std::size_t bitPosition) {
+    auto index = bitPosition / 64;
+    auto shift = bitPosition % 64;
+    auto val = block.packed[index] >> shift;
+    if (shift + block.bitWidth > 64) {
+      val |= block.packed[index + 1] << (64 - shift);
+    }
+    return val & MaxValue(block.bitWidth);
+  }
+
+  void SealTail() {
+    Block block;
+    auto minMax = std::minmax_element(m_tail.begin(), m_tail.end());
+    block.base = *minMax.first;
+    auto range = static_cast<std::uint64_t>(*minMax.second) -
+        static_cast<std::uint64_t>(*minMax.first);
+    std::uint32_t bitWidth = 0;
+    while (bitWidth < 64 && (range >> bitWidth) != 0) {
+      bitWidth++;
+    }
+
+    // A block of equal values still needs 1 bit per value so that
+    // bitWidth 0 can mean unpacked
+    bitWidth = std::max(bitWidth, std::uint32_t(1));
+    if (bitWidth * 2 > sizeof(T) * 8) {
+      block.values.swap(m_tail);
+    } else {
+      block.bitWidth = bitWidth;
+      block.packed.resize((m_tail.size() * bitWidth + 63) / 64);
+      std::size_t bitPosition = 0;
+      for (auto val : m_tail) {
+        auto diff = static_cast<std::uint64_t>(val) -
+            static_cast<std::uint64_t>(block.base);
+        auto index = bitPosition / 64;
+        auto shift = bitPosition % 64;
+        block.packed[index] |= diff << shift;
+        if (shift + bitWidth > 64) {
+          block.packed[index + 1] |= diff >> (64 - shift);
+        }
+        bitPosition += bitWidth;
+      }
+    }
+
+    m_blocks.push_back(std::move(block));
+    m_tail = std::vector<T>();
+    m_tail.reserve(ScanKernels::BLOCK_SIZE);
+  }
+
+  std::vector<Block> m_blocks;
+  std::vector<T> m_tail;
+};
+}  // namespace jonoondb_api
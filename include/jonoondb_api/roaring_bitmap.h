@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace jonoondb_api {
+// Compressed bitmap that splits the 64-bit positions into chunks of 2^16 by
+// their high bits. Every chunk is kept in the container that suits its
+// density: a sorted array of the low 16 bits for sparse chunks, a plain
+// bitset for dense chunks and a list of runs for clustered chunks. Unlike
+// EWAH it accepts positions in any order, intersects sparse sets by
+// looking up only the positions of the smaller side and knows its
+// cardinality without a scan.
+class RoaringBitmap {
+ public:
+  class ConstIterator {
+   public:
+    ConstIterator()
+        : m_bitmap(nullptr), m_containerIndex(0), m_index(0), m_runOffset(0),
+          m_current(0) {
+    }
+    ConstIterator(const RoaringBitmap* bitmap, std::size_t containerIndex);
+    std::uint64_t operator*() const {
+      return m_current;
+    }
+    ConstIterator& operator++();
+    // Writes the positions from the current one on into positions, at most
+    // capacity of them, and moves past them. Returns how many were written.
+    std::size_t Decode(std::uint64_t* positions, std::size_t capacity);
+    bool operator==(const ConstIterator& other) const {
+      return m_containerIndex == other.m_containerIndex &&
+          m_current == other.m_current;
+    }
+    bool operator!=(const ConstIterator& other) const {
+      return !(*this == other);
+    }
+    bool operator<(const ConstIterator& other) const {
+      return m_containerIndex < other.m_containerIndex ||
+          (m_containerIndex == other.m_containerIndex &&
+              m_current < other.m_current);
+    }
+    bool operator<=(const ConstIterator& other) const {
+      return !(other < *this);
+    }
+    bool operator>(const ConstIterator& other) const {
+      return other < *this;
+    }
+    bool operator>=(const ConstIterator& other) const {
+      return !(*this < other);
+    }
+
+   private:
+    void SeekContainer();
+    const RoaringBitmap* m_bitmap;
+    std::size_t m_containerIndex;
+    // Position in the container: value index for arrays, run index for
+    // runs and bit index for bitsets
+    std::uint32_t m_index;
+    // Offset in the current run
+    std::uint32_t m_runOffset;
+    std::uint64_t m_current;
+  };
+
+  void Add(std::uint64_t x);
+  // Sets the bits of count 64-bit words starting at bit offset, which has
+  // to be a multiple of 64 and at least GetSizeInBits()
+  void AddWords(std::uint64_t offset, const std::uint64_t* words,
+                std::size_t count);
+  bool Contains(std::uint64_t x) const;
+  std::uint64_t GetCount() const {
+    return m_count;
+  }
+  // Position of the last set bit plus one, words added with AddWords count
+  // completely
+  std::uint64_t GetSizeInBits() const {
+    return m_sizeInBits;
+  }
+  std::size_t GetSizeInBytes() const;
+  // Converts the containers to runs where that is smaller
+  void RunOptimize();
+
+  // ORs the bits into a dense buffer of count words, bit j of word i is
+  // position i * 64 + j. Bits beyond the buffer are ignored.
+  void OrInto(std::uint64_t* words, std::size_t count) const;
+
+  static void And(const RoaringBitmap& bitmap1, const RoaringBitmap& bitmap2,
+                  RoaringBitmap& output);
+  static void Or(const RoaringBitmap& bitmap1, const RoaringBitmap& bitmap2,
+                 RoaringBitmap& output);
+
+  ConstIterator begin() const;
+  ConstIterator end() const;
+
+  enum class ContainerType : std::uint8_t {
+    ARRAY,
+    BITSET,
+    RUN
+  };
+
+  struct Container {
+    ContainerType type = ContainerType::ARRAY;
+    std::uint32_t cardinality = 0;
+    // ARRAY: sorted low bits. RUN: pairs of run start and run length - 1.
+    std::vector<std::uint16_t> values;
+    // BITSET: BITSET_WORDS words
+    std::vector<std::uint64_t> words;
+  };
+
+  // An array container holds at most this many values, above that a bitset
+  // is smaller
+  static const std::uint32_t ARRAY_MAX_SIZE = 4096;
+  static const std::size_t BITSET_WORDS = 1024;
+
+ private:
+  Container& GetContainer(std::uint64_t key);
+
+  // High 48 bits of the positions in each container, in increasing order
+  std::vector<std::uint64_t> m_keys;
+  std::vector<Container> m_containers;
+  std::uint64_t m_sizeInBits = 0;
+  // Sum of the container cardinalities
+  std::uint64_t m_count = 0;
+};
+}  // namespace jonoondb_api
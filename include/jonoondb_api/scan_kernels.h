@@ -0,0 +1,445 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "mama_jennies_bitmap.h"
+
+// The AVX2 kernels are compiled for every x86 build with GCC or Clang and
+// only run on CPUs that support AVX2. Other compilers get them only when
+// the whole build targets AVX2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JONOONDB_AVX2_KERNELS
+#define JONOONDB_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define JONOONDB_AVX2_KERNELS
+#define JONOONDB_TARGET_AVX2
+#endif
+
+namespace jonoondb_api {
+// Compare kernels for the VECTOR indexers. Each kernel evaluates a range
+// predicate over a contiguous array and writes one 64-bit match word per 64
+// values, bit j of words[i] is set if values[i * 64 + j] matches. The bits
+// past count in the last word are always 0. The AVX2 kernels are picked at
+// runtime, otherwise the branch free scalar kernels are used. The integer
+// kernels require lower <= upper.
+// How many values of a block can match a predicate
+enum class BlockMatch {
+  NONE,
+  SOME,
+  ALL
+};
+
+class ScanKernels {
+ public:
+  static const std::size_t WORD_SIZE_IN_BITS = 64;
+  // Number of values that are scanned in one go
+  static const std::size_t BLOCK_SIZE_IN_WORDS = 64;
+  static const std::size_t BLOCK_SIZE =
+      BLOCK_SIZE_IN_WORDS * WORD_SIZE_IN_BITS;
+
+  // Matches values in the inclusive range [lower, upper].
+  static void Between(const std::int8_t* values, std::size_t count,
+                      std::int8_t lower, std::int8_t upper,
+                      std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2(values, count, lower, upper, words);
+    }
+#endif
+    BetweenScalar(values, i, count, lower, upper, words);
+  }
+
+  // Matches values in the inclusive range [lower, upper].
+  static void Between(const std::int16_t* values, std::size_t count,
+                      std::int16_t lower, std::int16_t upper,
+                      std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2(values, count, lower, upper, words);
+    }
+#endif
+    BetweenScalar(values, i, count, lower, upper, words);
+  }
+
+  // Matches values in the inclusive range [lower, upper].
+  static void Between(const std::int32_t* values, std::size_t count,
+                      std::int32_t lower, std::int32_t upper,
+                      std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2(values, count, lower, upper, words);
+    }
+#endif
+    BetweenScalar(values, i, count, lower, upper, words);
+  }
+
+  // Matches values in the inclusive range [lower, upper].
+  static void Between(const std::int64_t* values, std::size_t count,
+                      std::int64_t lower, std::int64_t upper,
+                      std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2(values, count, lower, upper, words);
+    }
+#endif
+    BetweenScalar(values, i, count, lower, upper, words);
+  }
+
+  // Matches values between lower and upper, the bounds are included or
+  // excluded as specified. NaN never matches.
+  static void Between(const float* values, std::size_t count,
+                      float lower, bool lowerInclusive,
+                      float upper, bool upperInclusive,
+                      std::uint64_t* words) {
+    if (lowerInclusive) {
+      if (upperInclusive) {
+        Between<true, true>(values, count, lower, upper, words);
+      } else {
+        Between<true, false>(values, count, lower, upper, words);
+      }
+    } else {
+      if (upperInclusive) {
+        Between<false, true>(values, count, lower, upper, words);
+      } else {
+        Between<false, false>(values, count, lower, upper, words);
+      }
+    }
+  }
+
+  // Matches values between lower and upper, the bounds are included or
+  // excluded as specified. NaN never matches.
+  static void Between(const double* values, std::size_t count,
+                      double lower, bool lowerInclusive,
+                      double upper, bool upperInclusive,
+                      std::uint64_t* words) {
+    if (lowerInclusive) {
+      if (upperInclusive) {
+        Between<true, true>(values, count, lower, upper, words);
+      } else {
+        Between<true, false>(values, count, lower, upper, words);
+      }
+    } else {
+      if (upperInclusive) {
+        Between<false, true>(values, count, lower, upper, words);
+      } else {
+        Between<false, false>(values, count, lower, upper, words);
+      }
+    }
+  }
+
+  // Matches values for which predicate returns true. This is used for the
+  // types that do not have a SIMD kernel.
+  template<typename T, typename Predicate>
+  static void Matching(const T* values, std::size_t count,
+                       Predicate predicate, std::uint64_t* words) {
+    ScalarScan(values, 0, count, words, predicate);
+  }
+
+  // Runs kernel over count values one block at a time and appends the match
+  // words to a new bitmap. kernel is called as kernel(offset, count, words)
+  // and must fill the match words for the values [offset, offset + count).
+  template<typename Kernel>
+  static std::shared_ptr<MamaJenniesBitmap> ScanToBitmap(std::size_t count,
+                                                         Kernel kernel) {
+    return ScanToBitmap(count, [](std::size_t block) {
+      return BlockMatch::SOME;
+    }, kernel);
+  }
+
+  // Same as above but classify(block) is called first for every block. The
+  // kernel only runs for the blocks where SOME values can match, the match
+  // words of the other blocks are filled without looking at the values.
+  template<typename Classify, typename Kernel>
+  static std::shared_ptr<MamaJenniesBitmap> ScanToBitmap(std::size_t count,
+                                                         Classify classify,
+                                                         Kernel kernel) {
+    return ScanToBitmap(count, classify, kernel, nullptr);
+  }
+
+  // Same as above but the match words are ANDed with mask, which has one
+  // word per 64 values, unless mask is nullptr. It is used to exclude the
+  // null values. The blocks before the one holding startID are not scanned
+  // and come out as 0.
+  template<typename Classify, typename Kernel>
+  static std::shared_ptr<MamaJenniesBitmap> ScanToBitmap(
+      std::size_t count, Classify classify, Kernel kernel,
+      const std::uint64_t* mask, std::uint64_t startID = 0) {
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    std::uint64_t words[BLOCK_SIZE_IN_WORDS];
+    const std::size_t blockSize = BLOCK_SIZE;
+    auto firstBlock = static_cast<std::size_t>(
+        std::min<std::uint64_t>(startID, count) / blockSize);
+    bitmap->AddEmptyWords(firstBlock * BLOCK_SIZE_IN_WORDS);
+    for (std::size_t offset = firstBlock * blockSize; offset < count;
+         offset += blockSize) {
+      auto size = std::min(blockSize, count - offset);
+      auto wordCount = (size + WORD_SIZE_IN_BITS - 1) / WORD_SIZE_IN_BITS;
+      switch (classify(offset / blockSize)) {
+        case BlockMatch::NONE:
+          std::fill(words, words + wordCount, 0);
+          break;
+        case BlockMatch::ALL:
+          std::fill(words, words + wordCount, ~std::uint64_t(0));
+          if (size % WORD_SIZE_IN_BITS != 0) {
+            // Bits past count have to stay 0
+            words[wordCount - 1] =
+                (std::uint64_t(1) << (size % WORD_SIZE_IN_BITS)) - 1;
+          }
+          break;
+        default:
+          kernel(offset, size, words);
+          break;
+      }
+      if (mask != nullptr) {
+        auto blockMask = mask + offset / WORD_SIZE_IN_BITS;
+        for (std::size_t i = 0; i < wordCount; i++) {
+          words[i] &= blockMask[i];
+        }
+      }
+      bitmap->AddWords(words, wordCount);
+    }
+
+    return bitmap;
+  }
+
+ private:
+#if defined(JONOONDB_AVX2_KERNELS)
+  static bool HasAVX2() {
+#if defined(__GNUC__)
+    static const bool hasAVX2 = [] {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return hasAVX2;
+#else
+    return true;
+#endif
+  }
+
+  // The AVX2 kernels fill the match words of the full words of values and
+  // return how many values they scanned, the scalar kernels do the rest.
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const std::int8_t* values, std::size_t count,
+                                 std::int8_t lower, std::int8_t upper,
+                                 std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256i lowerVec = _mm256_set1_epi8(lower);
+    const __m256i upperVec = _mm256_set1_epi8(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 32) {
+        auto vec = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(values + i + j));
+        auto outside = _mm256_or_si256(_mm256_cmpgt_epi8(lowerVec, vec),
+                                       _mm256_cmpgt_epi8(vec, upperVec));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(outside));
+        word |= static_cast<std::uint64_t>(~mask) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+
+  JONOONDB_TARGET_AVX2
+  static __m256i Outside(const std::int16_t* values, __m256i lowerVec,
+                         __m256i upperVec) {
+    auto vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    return _mm256_or_si256(_mm256_cmpgt_epi16(lowerVec, vec),
+                           _mm256_cmpgt_epi16(vec, upperVec));
+  }
+
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const std::int16_t* values,
+                                 std::size_t count, std::int16_t lower,
+                                 std::int16_t upper, std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256i lowerVec = _mm256_set1_epi16(lower);
+    const __m256i upperVec = _mm256_set1_epi16(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 32) {
+        // Packing interleaves the 128 bit lanes of the two vectors, the
+        // permute puts the 32 results back in order.
+        auto packed = _mm256_packs_epi16(
+            Outside(values + i + j, lowerVec, upperVec),
+            Outside(values + i + j + 16, lowerVec, upperVec));
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(packed));
+        word |= static_cast<std::uint64_t>(~mask) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const std::int32_t* values,
+                                 std::size_t count, std::int32_t lower,
+                                 std::int32_t upper, std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256i lowerVec = _mm256_set1_epi32(lower);
+    const __m256i upperVec = _mm256_set1_epi32(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 8) {
+        auto vec = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(values + i + j));
+        // A value is outside the range if lower > value or value > upper
+        auto outside = _mm256_or_si256(_mm256_cmpgt_epi32(lowerVec, vec),
+                                       _mm256_cmpgt_epi32(vec, upperVec));
+        auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(outside));
+        word |= static_cast<std::uint64_t>(~mask & 0xFF) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const std::int64_t* values,
+                                 std::size_t count, std::int64_t lower,
+                                 std::int64_t upper, std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256i lowerVec = _mm256_set1_epi64x(lower);
+    const __m256i upperVec = _mm256_set1_epi64x(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 4) {
+        auto vec = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(values + i + j));
+        auto outside = _mm256_or_si256(_mm256_cmpgt_epi64(lowerVec, vec),
+                                       _mm256_cmpgt_epi64(vec, upperVec));
+        auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(outside));
+        word |= static_cast<std::uint64_t>(~mask & 0xF) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+
+  template<bool LowerInclusive, bool UpperInclusive>
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const float* values, std::size_t count,
+                                 float lower, float upper,
+                                 std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256 lowerVec = _mm256_set1_ps(lower);
+    const __m256 upperVec = _mm256_set1_ps(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 8) {
+        auto vec = _mm256_loadu_ps(values + i + j);
+        auto aboveLower = LowerInclusive ?
+            _mm256_cmp_ps(vec, lowerVec, _CMP_GE_OQ) :
+            _mm256_cmp_ps(vec, lowerVec, _CMP_GT_OQ);
+        auto belowUpper = UpperInclusive ?
+            _mm256_cmp_ps(vec, upperVec, _CMP_LE_OQ) :
+            _mm256_cmp_ps(vec, upperVec, _CMP_LT_OQ);
+        auto mask = _mm256_movemask_ps(_mm256_and_ps(aboveLower, belowUpper));
+        word |= static_cast<std::uint64_t>(mask) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+
+  template<bool LowerInclusive, bool UpperInclusive>
+  JONOONDB_TARGET_AVX2
+  static std::size_t BetweenAVX2(const double* values, std::size_t count,
+                                 double lower, double upper,
+                                 std::uint64_t* words) {
+    std::size_t i = 0;
+    const __m256d lowerVec = _mm256_set1_pd(lower);
+    const __m256d upperVec = _mm256_set1_pd(upper);
+    for (; i + WORD_SIZE_IN_BITS <= count; i += WORD_SIZE_IN_BITS) {
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < WORD_SIZE_IN_BITS; j += 4) {
+        auto vec = _mm256_loadu_pd(values + i + j);
+        // Ordered compares are false for NaN
+        auto aboveLower = LowerInclusive ?
+            _mm256_cmp_pd(vec, lowerVec, _CMP_GE_OQ) :
+            _mm256_cmp_pd(vec, lowerVec, _CMP_GT_OQ);
+        auto belowUpper = UpperInclusive ?
+            _mm256_cmp_pd(vec, upperVec, _CMP_LE_OQ) :
+            _mm256_cmp_pd(vec, upperVec, _CMP_LT_OQ);
+        auto mask = _mm256_movemask_pd(_mm256_and_pd(aboveLower, belowUpper));
+        word |= static_cast<std::uint64_t>(mask) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+    return i;
+  }
+#endif
+
+  template<bool LowerInclusive, bool UpperInclusive>
+  static void Between(const float* values, std::size_t count,
+                      float lower, float upper, std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2<LowerInclusive, UpperInclusive>(values, count, lower,
+                                                      upper, words);
+    }
+#endif
+    ScalarScan(values, i, count, words, [lower, upper](float val) {
+      return (LowerInclusive ? val >= lower : val > lower) &
+          (UpperInclusive ? val <= upper : val < upper);
+    });
+  }
+
+  template<bool LowerInclusive, bool UpperInclusive>
+  static void Between(const double* values, std::size_t count,
+                      double lower, double upper, std::uint64_t* words) {
+    std::size_t i = 0;
+#if defined(JONOONDB_AVX2_KERNELS)
+    if (HasAVX2()) {
+      i = BetweenAVX2<LowerInclusive, UpperInclusive>(values, count, lower,
+                                                      upper, words);
+    }
+#endif
+    ScalarScan(values, i, count, words, [lower, upper](double val) {
+      return (LowerInclusive ? val >= lower : val > lower) &
+          (UpperInclusive ? val <= upper : val < upper);
+    });
+  }
+
+  // Subtracting lower maps the range to [0, upper - lower] so a single
+  // unsigned compare is enough. This works for every integer width because
+  // the subtraction is done modulo 2^64.
+  template<typename T>
+  static void BetweenScalar(const T* values, std::size_t begin,
+                            std::size_t count, T lower, T upper,
+                            std::uint64_t* words) {
+    auto width = static_cast<std::uint64_t>(upper) -
+        static_cast<std::uint64_t>(lower);
+    ScalarScan(values, begin, count, words, [lower, width](T val) {
+      return static_cast<std::uint64_t>(val) -
+          static_cast<std::uint64_t>(lower) <= width;
+    });
+  }
+
+  // Fills the match words for the values [begin, count). begin has to be a
+  // multiple of 64.
+  template<typename T, typename Predicate>
+  static void ScalarScan(const T* values, std::size_t begin,
+                         std::size_t count, std::uint64_t* words,
+                         Predicate predicate) {
+    for (std::size_t i = begin; i < count; i += WORD_SIZE_IN_BITS) {
+      auto size = std::min(count - i, std::size_t(WORD_SIZE_IN_BITS));
+      std::uint64_t word = 0;
+      for (std::size_t j = 0; j < size; j++) {
+        word |= static_cast<std::uint64_t>(predicate(values[i + j])) << j;
+      }
+      words[i / WORD_SIZE_IN_BITS] = word;
+    }
+  }
+};
+}  // namespace jonoondb_api
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+namespace jonoondb_api {
+class SortUtils {
+ public:
+  // Maps a int64 value to a uint64 key that sorts in the same order
+  static std::uint64_t ToSortableKey(std::int64_t val) {
+    return static_cast<std::uint64_t>(val) ^ (std::uint64_t(1) << 63);
+  }
+
+  static std::int64_t ToInt64(std::uint64_t key) {
+    return static_cast<std::int64_t>(key ^ (std::uint64_t(1) << 63));
+  }
+
+  // Maps a double value to a uint64 key that sorts in the same order.
+  // Positive values get their sign bit flipped, negative values get all
+  // their bits flipped. -0.0 and 0.0 compare equal so they get the same key.
+  static std::uint64_t ToSortableKey(double val) {
+    if (val == 0) {
+      val = 0;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    if (bits & (std::uint64_t(1) << 63)) {
+      return ~bits;
+    }
+    return bits | (std::uint64_t(1) << 63);
+  }
+
+  static double ToDouble(std::uint64_t key) {
+    std::uint64_t bits;
+    if (key & (std::uint64_t(1) << 63)) {
+      bits = key & ~(std::uint64_t(1) << 63);
+    } else {
+      bits = ~key;
+    }
+    double val;
+    std::memcpy(&val, &bits, sizeof(val));
+    return val;
+  }
+
+  // Stable LSD radix sort of (key, documentID) pairs on the key. Because the
+  // sort is stable, pairs that were appended in increasing documentID order
+  // come out sorted on (key, documentID). Byte positions that are the same
+  // for all the keys are skipped.
+  static void RadixSort(
+      std::vector<std::pair<std::uint64_t, std::uint64_t>>& entries) {
+    if (entries.size() < 2) {
+      return;
+    }
+
+    std::uint64_t orOfKeys = 0, andOfKeys = ~std::uint64_t(0);
+    for (auto& entry : entries) {
+      orOfKeys |= entry.first;
+      andOfKeys &= entry.first;
+    }
+    // Bits that differ in atleast one key
+    std::uint64_t diffBits = orOfKeys ^ andOfKeys;
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buffer(entries.size());
+    std::size_t counts[256];
+    for (int shift = 0; shift < 64; shift += 8) {
+      if (((diffBits >> shift) & 0xFF) == 0) {
+        continue;
+      }
+
+      std::memset(counts, 0, sizeof(counts));
+      for (auto& entry : entries) {
+        counts[(entry.first >> shift) & 0xFF]++;
+      }
+
+      std::size_t offset = 0;
+      for (auto& count : counts) {
+        auto tmp = count;
+        count = offset;
+        offset += tmp;
+      }
+
+      for (auto& entry : entries) {
+        buffer[counts[(entry.first >> shift) & 0xFF]++] = entry;
+      }
+      entries.swap(buffer);
+    }
+  }
+};
+}  // namespace jonoondb_api
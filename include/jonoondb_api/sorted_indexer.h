@@ -0,0 +1,346 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "string_pattern.h"
+#include "null_helpers.h"
+
+namespace jonoondb_api {
+// Sorted (value, documentID) index. New entries go to a small unsorted
+// buffer. A full buffer is sorted into a segment and segments are merged
+// whenever the previous segment is not bigger than the new one, which keeps
+// O(log n) segments of geometrically growing size. Equality and range
+// queries binary search every segment and cost O(log^2 n + k).
+// T can be std::int64_t, double or std::string.
+template<typename T>
+class SortedIndexer final: public Indexer {
+ public:
+  SortedIndexer(const IndexInfoImpl& indexInfo,
+                const FieldType& fieldType) {
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (indexInfo.GetColumnName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty column name.";
+    } else if (indexInfo.GetType() != IndexType::SORTED) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType SORTED for SortedIndexer.";
+    } else if (!IsValidFieldType(fieldType)) {
+      std::ostringstream ss;
+      ss << "Argument fieldType " << GetFieldString(fieldType)
+          << " is not valid for SortedIndexer.";
+      errorMsg = ss.str();
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_fieldNameTokens = StringUtils::Split(indexInfo.GetColumnName(), ".");
+    m_indexStat = IndexStat(indexInfo, fieldType);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_INT8
+        || fieldType == FieldType::BASE_TYPE_INT16
+        || fieldType == FieldType::BASE_TYPE_INT32
+        || fieldType == FieldType::BASE_TYPE_INT64
+        || fieldType == FieldType::BASE_TYPE_FLOAT32
+        || fieldType == FieldType::BASE_TYPE_DOUBLE
+        || fieldType == FieldType::BASE_TYPE_STRING);
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    T val;
+    if (!TryGetValue(document, val)) {
+      // Null values never satisfy a comparison so they are not indexed
+      m_indexStat.GetStatistics().AddNull();
+      return;
+    }
+
+    m_indexStat.GetStatistics().AddValue(val);
+    m_buffer.emplace_back(std::move(val), documentID);
+    if (m_buffer.size() >= BUFFER_SIZE) {
+      FlushBuffer();
+    }
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    switch (constraint.op) {
+      case jonoondb_api::IndexConstraintOperator::EQUAL:
+      case jonoondb_api::IndexConstraintOperator::LESS_THAN:
+      case jonoondb_api::IndexConstraintOperator::LESS_THAN_EQUAL:
+      case jonoondb_api::IndexConstraintOperator::GREATER_THAN:
+      case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
+        return GetBitmap(constraint, constraint);
+      case jonoondb_api::IndexConstraintOperator::LIKE:
+      case jonoondb_api::IndexConstraintOperator::GLOB:
+        return GetPatternBitmap(StringPattern(constraint));
+      default:
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator type "
+            << static_cast<std::int32_t>(constraint.op) << " is not valid.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    return GetBitmap(lowerConstraint, upperConstraint);
+  }
+
+ private:
+  typedef std::pair<T, std::uint64_t> Entry;
+  static const std::size_t BUFFER_SIZE = 1024;
+
+  bool TryGetValue(const Document& document, std::int64_t& val) {
+    val = DocumentUtils::GetIntegerValue(document, m_subDoc,
+                                         m_fieldNameTokens);
+    return !NullHelpers::IsNull(val);
+  }
+
+  bool TryGetValue(const Document& document, double& val) {
+    val = DocumentUtils::GetFloatValue(document, m_subDoc, m_fieldNameTokens);
+    return !std::isnan(val) && !NullHelpers::IsNull(val);
+  }
+
+  bool TryGetValue(const Document& document, std::string& val) {
+    val = DocumentUtils::GetStringValue(document, m_subDoc, m_fieldNameTokens);
+    return !NullHelpers::IsNull(val);
+  }
+
+  // Returns a negative number, zero or a positive number if val is less
+  // than, equal to or greater than the operand of the constraint.
+  static int CompareToOperand(std::int64_t val, const Constraint& constraint) {
+    if (constraint.operandType == OperandType::INTEGER) {
+      if (val < constraint.operand.int64Val) return -1;
+      return val > constraint.operand.int64Val ? 1 : 0;
+    }
+
+    // 2^63 and -2^63 are exactly representable as double
+    auto operand = constraint.operand.doubleVal;
+    if (operand >= 9223372036854775808.0) return -1;
+    if (operand < -9223372036854775808.0) return 1;
+    auto floor = std::floor(operand);
+    auto intOperand = static_cast<std::int64_t>(floor);
+    if (val < intOperand) return -1;
+    if (val > intOperand) return 1;
+    // val is equal to the integer part of the operand
+    return floor == operand ? 0 : -1;
+  }
+
+  static int CompareToOperand(double val, const Constraint& constraint) {
+    double operand = constraint.operandType == OperandType::INTEGER ?
+        static_cast<double>(constraint.operand.int64Val) :
+        constraint.operand.doubleVal;
+    if (val < operand) return -1;
+    return val > operand ? 1 : 0;
+  }
+
+  static int CompareToOperand(const std::string& val,
+                              const Constraint& constraint) {
+    return val.compare(constraint.strVal);
+  }
+
+  static bool IsComparable(const Constraint& constraint) {
+    if (std::is_same<T, std::string>::value) {
+      return constraint.operandType == OperandType::STRING;
+    }
+
+    return constraint.operandType == OperandType::INTEGER ||
+        (constraint.operandType == OperandType::DOUBLE &&
+            !std::isnan(constraint.operand.doubleVal));
+  }
+
+  static bool MatchesPattern(const std::string& val,
+                             const StringPattern& pattern) {
+    return pattern.Matches(val);
+  }
+
+  template<typename U>
+  static bool MatchesPattern(const U& val, const StringPattern& pattern) {
+    return false;
+  }
+
+  // Returns true if the entry satisfies the constraint
+  static bool Matches(const Entry& entry, const Constraint& constraint) {
+    auto cmp = CompareToOperand(entry.first, constraint);
+    switch (constraint.op) {
+      case IndexConstraintOperator::EQUAL:
+        return cmp == 0;
+      case IndexConstraintOperator::LESS_THAN:
+        return cmp < 0;
+      case IndexConstraintOperator::LESS_THAN_EQUAL:
+        return cmp <= 0;
+      case IndexConstraintOperator::GREATER_THAN:
+        return cmp > 0;
+      case IndexConstraintOperator::GREATER_THAN_EQUAL:
+        return cmp >= 0;
+      default:
+        return false;
+    }
+  }
+
+  // Narrows [begin, end) of a sorted segment to the entries that satisfy
+  // the constraint.
+  static void Narrow(const std::vector<Entry>& segment,
+                     const Constraint& constraint,
+                     typename std::vector<Entry>::const_iterator& begin,
+                     typename std::vector<Entry>::const_iterator& end) {
+    auto lessThan = [&constraint](const Entry& entry) {
+      return CompareToOperand(entry.first, constraint) < 0;
+    };
+    auto lessThanOrEqual = [&constraint](const Entry& entry) {
+      return CompareToOperand(entry.first, constraint) <= 0;
+    };
+
+    switch (constraint.op) {
+      case IndexConstraintOperator::EQUAL:
+        begin = std::max(begin, std::partition_point(segment.begin(),
+                                                     segment.end(), lessThan));
+        end = std::min(end, std::partition_point(segment.begin(),
+                                                 segment.end(),
+                                                 lessThanOrEqual));
+        break;
+      case IndexConstraintOperator::LESS_THAN:
+        end = std::min(end, std::partition_point(segment.begin(),
+                                                 segment.end(), lessThan));
+        break;
+      case IndexConstraintOperator::LESS_THAN_EQUAL:
+        end = std::min(end, std::partition_point(segment.begin(),
+                                                 segment.end(),
+                                                 lessThanOrEqual));
+        break;
+      case IndexConstraintOperator::GREATER_THAN:
+        begin = std::max(begin, std::partition_point(segment.begin(),
+                                                     segment.end(),
+                                                     lessThanOrEqual));
+        break;
+      case IndexConstraintOperator::GREATER_THAN_EQUAL:
+        begin = std::max(begin, std::partition_point(segment.begin(),
+                                                     segment.end(), lessThan));
+        break;
+      default:
+        end = begin;
+        break;
+    }
+  }
+
+  // Scans the range of the pattern prefix and checks the entries against
+  // the pattern only if the range is not exact.
+  std::shared_ptr<MamaJenniesBitmap> GetPatternBitmap(
+      const StringPattern& pattern) {
+    Constraint lowerConstraint(m_indexStat.GetIndexInfo().GetColumnName(),
+                               IndexConstraintOperator::GREATER_THAN_EQUAL);
+    lowerConstraint.operandType = OperandType::STRING;
+    lowerConstraint.strVal = pattern.GetLowerBound();
+    if (!pattern.HasUpperBound()) {
+      return GetBitmap(lowerConstraint, lowerConstraint, &pattern);
+    }
+
+    Constraint upperConstraint(m_indexStat.GetIndexInfo().GetColumnName(),
+                               IndexConstraintOperator::LESS_THAN);
+    upperConstraint.operandType = OperandType::STRING;
+    upperConstraint.strVal = pattern.GetUpperBound();
+    return GetBitmap(lowerConstraint, upperConstraint, &pattern);
+  }
+
+  // Returns the documents that satisfy both the constraints and the pattern
+  // if one is given. Filter passes the same constraint twice.
+  std::shared_ptr<MamaJenniesBitmap> GetBitmap(
+      const Constraint& constraint1, const Constraint& constraint2,
+      const StringPattern* pattern = nullptr) {
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    if (!IsComparable(constraint1) || !IsComparable(constraint2)) {
+      return bitmap;
+    }
+
+    auto residual = [pattern](const Entry& entry) {
+      return pattern == nullptr || pattern->IsExact() ||
+          MatchesPattern(entry.first, *pattern);
+    };
+
+    std::vector<std::uint64_t> documentIDs;
+    for (auto& segment : m_segments) {
+      auto begin = segment.cbegin();
+      auto end = segment.cend();
+      Narrow(segment, constraint1, begin, end);
+      Narrow(segment, constraint2, begin, end);
+      for (; begin < end; ++begin) {
+        if (residual(*begin)) {
+          documentIDs.push_back(begin->second);
+        }
+      }
+    }
+
+    for (auto& entry : m_buffer) {
+      if (Matches(entry, constraint1) && Matches(entry, constraint2) &&
+          residual(entry)) {
+        documentIDs.push_back(entry.second);
+      }
+    }
+
+    // Bitmaps have to be built in increasing documentID order
+    std::sort(documentIDs.begin(), documentIDs.end());
+    for (auto documentID : documentIDs) {
+      bitmap->Add(documentID);
+    }
+
+    return bitmap;
+  }
+
+  void FlushBuffer() {
+    std::sort(m_buffer.begin(), m_buffer.end());
+    m_segments.push_back(std::move(m_buffer));
+    m_buffer = std::vector<Entry>();
+    m_buffer.reserve(BUFFER_SIZE);
+
+    while (m_segments.size() > 1 &&
+        m_segments[m_segments.size() - 2].size() <= m_segments.back().size()) {
+      auto& first = m_segments[m_segments.size() - 2];
+      auto& second = m_segments.back();
+      std::vector<Entry> merged;
+      merged.reserve(first.size() + second.size());
+      std::merge(std::make_move_iterator(first.begin()),
+                 std::make_move_iterator(first.end()),
+                 std::make_move_iterator(second.begin()),
+                 std::make_move_iterator(second.end()),
+                 std::back_inserter(merged));
+      m_segments.pop_back();
+      m_segments.back() = std::move(merged);
+    }
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_fieldNameTokens;
+  std::unique_ptr<Document> m_subDoc;
+  // Sorted segments, oldest and biggest first
+  std::vector<std::vector<Entry>> m_segments;
+  std::vector<Entry> m_buffer;
+};
+}  // namespace jonoondb_api
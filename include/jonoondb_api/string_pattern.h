@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace jonoondb_api {
+// Forward declarations
+struct Constraint;
+
+// A LIKE or GLOB pattern with the semantics of the SQLite built-in
+// functions. LIKE uses % and _ as wildcards and folds the case of ASCII
+// characters. GLOB uses *, ? and [...] and is case sensitive.
+// The literal prefix of the pattern is turned into a string range so that
+// indexes can answer the pattern with a range scan and only check the
+// values inside the range with Matches.
+class StringPattern {
+ public:
+  explicit StringPattern(const Constraint& constraint);
+
+  // Every matching string is >= GetLowerBound()
+  const std::string& GetLowerBound() const {
+    return m_lowerBound;
+  }
+
+  // If HasUpperBound() is true then every matching string is
+  // < GetUpperBound()
+  bool HasUpperBound() const {
+    return m_hasUpperBound;
+  }
+
+  const std::string& GetUpperBound() const {
+    return m_upperBound;
+  }
+
+  // True if every string inside the range matches the pattern
+  bool IsExact() const {
+    return m_isExact;
+  }
+
+  bool Matches(const std::string& str) const;
+
+  // The runs of literal characters between the wildcards. Every matching
+  // string contains all of them.
+  std::vector<std::string> GetLiterals() const;
+
+ private:
+  bool MatchOne(std::size_t& patternPos, const std::string& str,
+                std::size_t& strPos, std::size_t strEnd) const;
+  bool MatchSet(std::size_t& patternPos, std::uint32_t c) const;
+
+  std::string m_pattern;
+  bool m_isLike;
+  std::string m_lowerBound;
+  std::string m_upperBound;
+  bool m_hasUpperBound;
+  bool m_isExact;
+};
+}  // namespace jonoondb_api
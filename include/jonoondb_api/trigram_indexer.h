@@ -0,0 +1,234 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include "indexer.h"
+#include "index_info_impl.h"
+#include "string_utils.h"
+#include "document.h"
+#include "mama_jennies_bitmap.h"
+#include "exception_utils.h"
+#include "index_stat.h"
+#include "constraint.h"
+#include "enums.h"
+#include "scan_kernels.h"
+#include "string_pattern.h"
+#include "null_helpers.h"
+
+namespace jonoondb_api {
+// Substring index for LIKE and GLOB. Every distinct 3 byte sequence of the
+// ASCII lower cased values has a posting list of the documents containing
+// it. A pattern is answered by ANDing the posting lists of the trigrams of
+// its literals, which gives the candidate documents, and by matching only
+// the candidates against the pattern. The values are kept dictionary
+// encoded so that each distinct value is matched at most once per query.
+class TrigramIndexer final: public Indexer {
+ public:
+  TrigramIndexer(const IndexInfoImpl& indexInfo,
+                 const FieldType& fieldType) {
+    std::string errorMsg;
+    if (indexInfo.GetIndexName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty name.";
+    } else if (indexInfo.GetColumnName().size() == 0) {
+      errorMsg = "Argument indexInfo has empty column name.";
+    } else if (indexInfo.GetType() != IndexType::TRIGRAM) {
+      errorMsg =
+          "Argument indexInfo can only have IndexType TRIGRAM for TrigramIndexer.";
+    } else if (!IsValidFieldType(fieldType)) {
+      std::ostringstream ss;
+      ss << "Argument fieldType " << GetFieldString(fieldType)
+          << " is not valid for TrigramIndexer.";
+      errorMsg = ss.str();
+    }
+
+    if (errorMsg.length() > 0) {
+      if (indexInfo.GetIndexName().size() > 0) {
+        errorMsg += " Index name is " + indexInfo.GetIndexName() + ".";
+      }
+      throw InvalidArgumentException(errorMsg, __FILE__, __func__, __LINE__);
+    }
+
+    m_fieldNameTokens = StringUtils::Split(indexInfo.GetColumnName(), ".");
+    m_indexStat = IndexStat(indexInfo, fieldType);
+  }
+
+  static bool IsValidFieldType(FieldType fieldType) {
+    return (fieldType == FieldType::BASE_TYPE_STRING);
+  }
+
+  void Insert(std::uint64_t documentID, const Document& document) override {
+    auto val = DocumentUtils::GetStringValue(document, m_subDoc,
+                                             m_fieldNameTokens);
+    assert(m_codes.size() == documentID);
+    if (NullHelpers::IsNull(val)) {
+      m_indexStat.GetStatistics().AddNull();
+      m_codes.push_back(std::int32_t(NULL_CODE));
+      return;
+    }
+
+    m_indexStat.GetStatistics().AddValue(val);
+
+    auto iter = m_codeMap.find(val);
+    if (iter != m_codeMap.end()) {
+      m_codes.push_back(iter->second);
+    } else {
+      if (m_dictionary.size() >=
+          static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+        throw JonoonDBException(
+            "TrigramIndexer cannot hold more distinct values.",
+            __FILE__, __func__, __LINE__);
+      }
+
+      auto code = static_cast<std::int32_t>(m_dictionary.size());
+      m_dictionary.push_back(val);
+      m_codeMap.emplace(val, code);
+      m_codes.push_back(code);
+    }
+
+    GetTrigrams(val, m_trigrams);
+    for (auto trigram : m_trigrams) {
+      auto& bitmap = m_postings[trigram];
+      if (bitmap == nullptr) {
+        bitmap = std::make_shared<MamaJenniesBitmap>();
+      }
+      bitmap->Add(documentID);
+    }
+  }
+
+  const IndexStat& GetIndexStats() override {
+    return m_indexStat;
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    switch (constraint.op) {
+      case jonoondb_api::IndexConstraintOperator::LIKE:
+      case jonoondb_api::IndexConstraintOperator::GLOB:
+        return GetPatternBitmap(StringPattern(constraint));
+      default:
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator type "
+            << static_cast<std::int32_t>(constraint.op) << " is not valid.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterRange(
+      const Constraint& lowerConstraint,
+      const Constraint& upperConstraint) override {
+    throw JonoonDBException("FilterRange is not supported by TrigramIndexer.",
+                            __FILE__, __func__, __LINE__);
+  }
+
+ private:
+  static const std::int32_t NULL_CODE = -1;
+
+  static char FoldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+  }
+
+  // Returns the distinct trigrams of the case folded string in
+  // increasing order
+  static void GetTrigrams(const std::string& str,
+                          std::vector<std::uint32_t>& trigrams) {
+    trigrams.clear();
+    if (str.size() < 3) {
+      return;
+    }
+
+    std::uint32_t trigram =
+        (static_cast<std::uint32_t>(static_cast<unsigned char>(
+            FoldCase(str[0]))) << 8) |
+            static_cast<unsigned char>(FoldCase(str[1]));
+    for (std::size_t i = 2; i < str.size(); i++) {
+      trigram = ((trigram << 8) |
+          static_cast<unsigned char>(FoldCase(str[i]))) & 0xFFFFFF;
+      trigrams.push_back(trigram);
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                   trigrams.end());
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> GetPatternBitmap(
+      const StringPattern& pattern) {
+    // Every matching value contains all the trigrams of the literals
+    std::vector<std::uint32_t> trigrams;
+    std::vector<std::uint32_t> literalTrigrams;
+    for (auto& literal : pattern.GetLiterals()) {
+      GetTrigrams(literal, literalTrigrams);
+      trigrams.insert(trigrams.end(), literalTrigrams.begin(),
+                      literalTrigrams.end());
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                   trigrams.end());
+
+    // Each distinct value is matched at most once: -1 not matched yet,
+    // 0 does not match, 1 matches
+    std::vector<std::int8_t> verdicts(m_dictionary.size(), -1);
+    auto matches = [&](std::int32_t code) {
+      if (code == NULL_CODE) {
+        return false;
+      }
+
+      if (verdicts[code] < 0) {
+        verdicts[code] = pattern.Matches(m_dictionary[code]) ? 1 : 0;
+      }
+      return verdicts[code] == 1;
+    };
+
+    if (trigrams.empty()) {
+      // Nothing to narrow down with, match every document
+      auto codes = m_codes.data();
+      return ScanKernels::ScanToBitmap(
+          m_codes.size(),
+          [codes, &matches](std::size_t offset, std::size_t count,
+                            std::uint64_t* words) {
+            ScanKernels::Matching(codes + offset, count, matches, words);
+          });
+    }
+
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    for (auto trigram : trigrams) {
+      auto iter = m_postings.find(trigram);
+      if (iter == m_postings.end()) {
+        return std::make_shared<MamaJenniesBitmap>();
+      }
+      bitmaps.push_back(iter->second);
+    }
+
+    auto candidates = bitmaps.size() == 1 ? bitmaps[0] :
+        MamaJenniesBitmap::LogicalAND(bitmaps);
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    for (auto iter = candidates->begin(); iter != candidates->end(); ++iter) {
+      auto documentID = *iter;
+      if (matches(m_codes[documentID])) {
+        bitmap->Add(documentID);
+      }
+    }
+
+    return bitmap;
+  }
+
+  IndexStat m_indexStat;
+  std::vector<std::string> m_fieldNameTokens;
+  // Distinct non null values, the index of a value is its code
+  std::vector<std::string> m_dictionary;
+  std::unordered_map<std::string, std::int32_t> m_codeMap;
+  // Code of every document
+  std::vector<std::int32_t> m_codes;
+  // Posting list of every trigram, the trigram is stored in the low 24 bits
+  std::unordered_map<std::uint32_t, std::shared_ptr<MamaJenniesBitmap>>
+      m_postings;
+  // Reused by Insert
+  std::vector<std::uint32_t> m_trigrams;
+  std::unique_ptr<Document> m_subDoc;
+};
+}  // namespace jonoondb_api
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "scan_kernels.h"
+
+namespace jonoondb_api {
+// One bit per row of a column, the bit is set if the row has a value and
+// clear if it is null. The VECTOR indexers AND their match words with it so
+// that nulls never match and the scans do not have to look for the null
+// sentinels.
+class ValidityBitmap {
+ public:
+  // Values have to be added for consecutive rows starting at 0
+  void PushBack(bool isValid) {
+    auto bit = m_size % ScanKernels::WORD_SIZE_IN_BITS;
+    if (bit == 0) {
+      m_words.push_back(0);
+    }
+
+    if (isValid) {
+      m_words.back() |= std::uint64_t(1) << bit;
+    } else {
+      m_nullCount++;
+    }
+    m_size++;
+  }
+
+  bool IsValid(std::size_t row) const {
+    return ((m_words[row / ScanKernels::WORD_SIZE_IN_BITS] >>
+        (row % ScanKernels::WORD_SIZE_IN_BITS)) & 1) != 0;
+  }
+
+  std::size_t Size() const {
+    return m_size;
+  }
+
+  std::uint64_t GetNullCount() const {
+    return m_nullCount;
+  }
+
+  // Returns the words to mask the match words with or nullptr if there are
+  // no nulls. Bit j of word i is the validity of row i * 64 + j.
+  const std::uint64_t* GetMask() const {
+    return m_nullCount == 0 ? nullptr : m_words.data();
+  }
+
+ private:
+  std::vector<std::uint64_t> m_words;
+  std::size_t m_size = 0;
+  std::uint64_t m_nullCount = 0;
+};
+}  // namespace jonoondb_api
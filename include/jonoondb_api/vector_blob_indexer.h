@@ -52,7 +52,8 @@ class VectorBlobIndexer final: public Indexer {
   void Insert(std::uint64_t documentID, const Document& document) override {
     std::size_t size = 0;
     auto data = DocumentUtils::GetBlobValue(document, m_subDoc,
-                                            m_fieldNameTokens, size);   
+                                            m_fieldNameTokens, size);
+    m_indexStat.GetStatistics().AddValue(std::string(data, size));
     assert(m_dataVector.size() == documentID);
     m_dataVector.push_back(BufferImpl(data, size, size));
   }
@@ -73,8 +74,13 @@ class VectorBlobIndexer final: public Indexer {
         return GetBitmapGT(constraint);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
         return GetBitmapGTE(constraint);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
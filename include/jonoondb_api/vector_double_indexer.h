@@ -5,6 +5,9 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <limits>
+#include <cmath>
+#include <type_traits>
 #include "indexer.h"
 #include "index_info_impl.h"
 #include "string_utils.h"
@@ -14,8 +17,14 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "scan_kernels.h"
+#include "zone_map.h"
+#include "validity_bitmap.h"
+#include "null_helpers.h"
 
 namespace jonoondb_api {
+// T can be float or double, it should match the width of the field
+template<typename T>
 class VectorDoubleIndexer final: public Indexer {
  public:
   VectorDoubleIndexer(const IndexInfoImpl& indexInfo,
@@ -53,7 +62,19 @@ class VectorDoubleIndexer final: public Indexer {
     auto val = DocumentUtils::GetFloatValue(document, m_subDoc,
                                             m_fieldNameTokens);
     assert(m_dataVector.size() == documentID);
-    m_dataVector.push_back(val);
+    if (NullHelpers::IsNull(val)) {
+      // The stored value is never read
+      m_indexStat.GetStatistics().AddNull();
+      m_zoneMap.AddNull(m_dataVector.size());
+      m_dataVector.push_back(0);
+      m_validity.PushBack(false);
+      return;
+    }
+
+    m_indexStat.GetStatistics().AddValue(val);
+    m_zoneMap.Add(m_dataVector.size(), static_cast<T>(val));
+    m_dataVector.push_back(static_cast<T>(val));
+    m_validity.PushBack(true);
   }
 
   const IndexStat& GetIndexStats() override {
@@ -61,19 +82,31 @@ class VectorDoubleIndexer final: public Indexer {
   }
 
   std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    return FilterFrom(constraint, 0);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterFrom(
+      const Constraint& constraint, std::uint64_t startID) override {
+    double val = GetOperandVal(constraint);
+    double infinity = std::numeric_limits<double>::infinity();
     switch (constraint.op) {
       case jonoondb_api::IndexConstraintOperator::EQUAL:
-        return GetBitmapEQ(constraint);
+        return GetBitmap(val, true, val, true, startID);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN:
-        return GetBitmapLT(constraint);
+        return GetBitmap(-infinity, true, val, false, startID);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN_EQUAL:
-        return GetBitmapLTE(constraint);
+        return GetBitmap(-infinity, true, val, true, startID);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN:
-        return GetBitmapGT(constraint);
+        return GetBitmap(val, false, infinity, true, startID);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
-        return GetBitmapGTE(constraint);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+        return GetBitmap(val, true, infinity, true, startID);
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -85,46 +118,24 @@ class VectorDoubleIndexer final: public Indexer {
   std::shared_ptr<MamaJenniesBitmap> FilterRange(
       const Constraint& lowerConstraint,
       const Constraint& upperConstraint) override {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double lowerVal = GetOperandVal(lowerConstraint);
-    double upperVal = GetOperandVal(upperConstraint);
-
-    if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] > lowerVal && m_dataVector[i] < upperVal) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] > lowerVal && m_dataVector[i] <= upperVal) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] >= lowerVal && m_dataVector[i] < upperVal) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] >= lowerVal && m_dataVector[i] <= upperVal) {
-          bitmap->Add(i);
-        }
-      }
-    }
+    return FilterRangeFrom(lowerConstraint, upperConstraint, 0);
+  }
 
-    return bitmap;
+  std::shared_ptr<MamaJenniesBitmap> FilterRangeFrom(
+      const Constraint& lowerConstraint, const Constraint& upperConstraint,
+      std::uint64_t startID) override {
+    return GetBitmap(
+        GetOperandVal(lowerConstraint),
+        lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL,
+        GetOperandVal(upperConstraint),
+        upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL,
+        startID);
   }
 
   bool TryGetDoubleValue(std::uint64_t documentID, double& val) override {
     if (documentID < m_dataVector.size()) {
-      val = m_dataVector[documentID];
+      val = m_validity.IsValid(documentID) ? m_dataVector[documentID] :
+          JONOONDB_NULL_DOUBLE;
       return true;
     }
 
@@ -139,7 +150,8 @@ class VectorDoubleIndexer final: public Indexer {
       if (documentIDs[i] >= m_dataVector.size()) {
         return false;
       }
-      values[i] = m_dataVector[documentIDs[i]];
+      values[i] = m_validity.IsValid(documentIDs[i]) ?
+          m_dataVector[documentIDs[i]] : JONOONDB_NULL_DOUBLE;
     }
 
     return true;
@@ -158,76 +170,62 @@ class VectorDoubleIndexer final: public Indexer {
     return val;
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapEQ(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double val = GetOperandVal(constraint);
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] == val) {
-        bitmap->Add(i);
-      }
+  // Converts a bound of the predicate to a bound of type T that selects the
+  // same values. A double that can't be represented exactly is replaced by
+  // the closest inclusive bound inside the range.
+  static T ToBound(double bound, bool isLower, bool& inclusive) {
+    if (std::isnan(bound) || std::is_same<T, double>::value) {
+      return static_cast<T>(bound);
     }
 
-    // In all other cases the operand cannot be equal. The cases are:
-    // Operand is a string value, this should not happen because the query should fail before reaching this point   
-    return bitmap;
-  }
-
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapLT(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double val = GetOperandVal(constraint);
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] < val) {
-        bitmap->Add(i);
-      }
+    T val;
+    if (bound > std::numeric_limits<T>::max()) {
+      val = std::numeric_limits<T>::infinity();
+    } else if (bound < std::numeric_limits<T>::lowest()) {
+      val = -std::numeric_limits<T>::infinity();
+    } else {
+      val = static_cast<T>(bound);
     }
 
-    return bitmap;
-  }
-
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapLTE(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double val = GetOperandVal(constraint);
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] <= val) {
-        bitmap->Add(i);
-      }
+    if (val == bound) {
+      return val;
     }
 
-    return bitmap;
-  }
-
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapGT(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double val = GetOperandVal(constraint);
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] > val) {
-        bitmap->Add(i);
-      }
+    inclusive = true;
+    if (isLower) {
+      return val > bound ? val :
+          std::nextafter(val, std::numeric_limits<T>::infinity());
     }
-
-    return bitmap;
+    return val < bound ? val :
+        std::nextafter(val, -std::numeric_limits<T>::infinity());
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapGTE(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    double val = GetOperandVal(constraint);
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] >= val) {
-        bitmap->Add(i);
-      }
-    }
-
-    return bitmap;
+  std::shared_ptr<MamaJenniesBitmap> GetBitmap(double lowerBound,
+                                               bool lowerInclusive,
+                                               double upperBound,
+                                               bool upperInclusive,
+                                               std::uint64_t startID) {
+    auto lower = ToBound(lowerBound, true, lowerInclusive);
+    auto upper = ToBound(upperBound, false, upperInclusive);
+    auto values = m_dataVector.data();
+    return ScanKernels::ScanToBitmap(
+        m_dataVector.size(),
+        [=](std::size_t block) {
+          return m_zoneMap.Classify(block, lower, lowerInclusive, upper,
+                                    upperInclusive);
+        },
+        [=](std::size_t offset, std::size_t count, std::uint64_t* words) {
+          ScanKernels::Between(values + offset, count, lower, lowerInclusive,
+                               upper, upperInclusive, words);
+        },
+        m_validity.GetMask(), startID);
   }
 
   IndexStat m_indexStat;
   std::vector<std::string> m_fieldNameTokens;
-  std::vector<double> m_dataVector;
+  std::vector<T> m_dataVector;
+  ZoneMap<T> m_zoneMap;
+  ValidityBitmap m_validity;
   std::unique_ptr<Document> m_subDoc;
 };
 } // namespace jonoondb_api
@@ -7,6 +7,7 @@
 #include <string>
 #include <cmath>
 #include <limits>
+#include <algorithm>
 #include "indexer.h"
 #include "index_info_impl.h"
 #include "string_utils.h"
@@ -16,6 +17,11 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "scan_kernels.h"
+#include "zone_map.h"
+#include "packed_integer_vector.h"
+#include "validity_bitmap.h"
+#include "null_helpers.h"
 
 namespace jonoondb_api {
 template<typename T>
@@ -57,14 +63,26 @@ class VectorIntegerIndexer final: public Indexer {
   void Insert(std::uint64_t documentID, const Document& document) override {
     auto val = DocumentUtils::GetIntegerValue(document, m_subDoc,
                                               m_fieldNameTokens);
-    assert(m_dataVector.size() == documentID);
+    assert(m_dataVector.Size() == documentID);
+    if (NullHelpers::IsNull(val)) {
+      // The stored value is never read
+      m_indexStat.GetStatistics().AddNull();
+      m_zoneMap.AddNull(m_dataVector.Size());
+      m_dataVector.PushBack(0);
+      m_validity.PushBack(false);
+      return;
+    }
+
+    m_indexStat.GetStatistics().AddValue(val);
     assert(val <= std::numeric_limits<T>::max());
     assert(val >= std::numeric_limits<T>::min());
-    // We create this class with int32_t as T for int32 and smaller types
-    // So we should never get a overflow situation for int32_t. However it is technically
+    // We create this class with T matching the width of the field so we
+    // should never get a overflow situation. However it is technically
     // possible to abuse this situation hence adding the asserts above to catch any misuse
     // atleast in debug build
-    m_dataVector.push_back(val);
+    m_zoneMap.Add(m_dataVector.Size(), static_cast<T>(val));
+    m_dataVector.PushBack(static_cast<T>(val));
+    m_validity.PushBack(true);
   }
 
   const IndexStat& GetIndexStats() override {
@@ -72,19 +90,25 @@ class VectorIntegerIndexer final: public Indexer {
   }
 
   std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    return FilterFrom(constraint, 0);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterFrom(
+      const Constraint& constraint, std::uint64_t startID) override {
     switch (constraint.op) {
       case jonoondb_api::IndexConstraintOperator::EQUAL:
-        return GetBitmapEQ(constraint);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN:
-        return GetBitmapLT(constraint, false);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN_EQUAL:
-        return GetBitmapLT(constraint, true);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN:
-        return GetBitmapGT(constraint, false);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
-        return GetBitmapGT(constraint, true);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+        return GetBitmap(constraint, constraint, startID);
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -96,46 +120,20 @@ class VectorIntegerIndexer final: public Indexer {
   std::shared_ptr<MamaJenniesBitmap> FilterRange(
       const Constraint& lowerConstraint,
       const Constraint& upperConstraint) override {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    std::int64_t lowerVal, upperVal;
-
-    if (lowerConstraint.operandType == OperandType::DOUBLE) {
-      lowerVal =
-          static_cast<int64_t>(std::floor(lowerConstraint.operand.doubleVal));
-    } else {
-      if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL) {
-        // Subtracting 1 here allows us to use > operator in the loop below
-        lowerVal = lowerConstraint.operand.int64Val - 1;
-      } else {
-        lowerVal = lowerConstraint.operand.int64Val;
-      }
-    }
-
-    if (upperConstraint.operandType == OperandType::DOUBLE) {
-      upperVal =
-          static_cast<int64_t>(std::ceil(upperConstraint.operand.doubleVal));
-    } else {
-      if (upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL) {
-        // Adding 1 here allows us to use < operator in the loop below
-        upperVal = upperConstraint.operand.int64Val + 1;
-      } else {
-        upperVal = upperConstraint.operand.int64Val;
-      }
-    }
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] > lowerVal && m_dataVector[i] < upperVal) {
-        bitmap->Add(i);
-      }
-    }
+    return FilterRangeFrom(lowerConstraint, upperConstraint, 0);
+  }
 
-    return bitmap;
+  std::shared_ptr<MamaJenniesBitmap> FilterRangeFrom(
+      const Constraint& lowerConstraint, const Constraint& upperConstraint,
+      std::uint64_t startID) override {
+    return GetBitmap(lowerConstraint, upperConstraint, startID);
   }
 
   bool TryGetIntegerValue(std::uint64_t documentID,
                           std::int64_t& val) override {
-    if (documentID < m_dataVector.size()) {
-      val = m_dataVector[documentID];
+    if (documentID < m_dataVector.Size()) {
+      val = m_validity.IsValid(documentID) ? m_dataVector.Get(documentID) :
+          JONOONDB_NULL_INT64;
       return true;
     }
 
@@ -147,94 +145,132 @@ class VectorIntegerIndexer final: public Indexer {
       std::vector<std::int64_t>& values) override {
     assert(documentIDs.size() == values.size());
     for (auto i = 0; i < documentIDs.size(); i++) {
-      if (documentIDs[i] >= m_dataVector.size()) {
+      if (documentIDs[i] >= m_dataVector.Size()) {
         return false;
       }
-      values[i] = m_dataVector[documentIDs[i]];
+      values[i] = m_validity.IsValid(documentIDs[i]) ?
+          m_dataVector.Get(documentIDs[i]) : JONOONDB_NULL_INT64;
     }
 
     return true;
   }
 
  private:
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapEQ(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+  // Narrows the inclusive range [lower, upper] to the values that satisfy
+  // the constraint. Returns false if no integer can satisfy it.
+  static bool NarrowRange(const Constraint& constraint, std::int64_t& lower,
+                          std::int64_t& upper) {
+    std::int64_t newLower = std::numeric_limits<std::int64_t>::min();
+    std::int64_t newUpper = std::numeric_limits<std::int64_t>::max();
+
     if (constraint.operandType == OperandType::INTEGER) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] == constraint.operand.int64Val) {
-          bitmap->Add(i);
-        }
+      auto val = constraint.operand.int64Val;
+      switch (constraint.op) {
+        case IndexConstraintOperator::EQUAL:
+          newLower = newUpper = val;
+          break;
+        case IndexConstraintOperator::LESS_THAN:
+          if (val == std::numeric_limits<std::int64_t>::min()) return false;
+          newUpper = val - 1;
+          break;
+        case IndexConstraintOperator::LESS_THAN_EQUAL:
+          newUpper = val;
+          break;
+        case IndexConstraintOperator::GREATER_THAN:
+          if (val == std::numeric_limits<std::int64_t>::max()) return false;
+          newLower = val + 1;
+          break;
+        case IndexConstraintOperator::GREATER_THAN_EQUAL:
+          newLower = val;
+          break;
+        default:
+          return false;
       }
     } else if (constraint.operandType == OperandType::DOUBLE) {
-      // Check if double has no fractional part. If it has fractional part
-      // then it can't be equal to any integer
-      std::int64_t
-          intVal = static_cast<std::int64_t>(constraint.operand.doubleVal);
-      if (constraint.operand.doubleVal == intVal) {
-        for (size_t i = 0; i < m_dataVector.size(); i++) {
-          if (m_dataVector[i] == intVal) {
-            bitmap->Add(i);
-          }
-        }
+      auto val = constraint.operand.doubleVal;
+      if (std::isnan(val)) {
+        return false;
       }
-    }
 
-    // In all other cases the operand cannot be equal. The cases are:
-    // Operand is a string value, this should not happen because the query should fail before reaching this point   
-    return bitmap;
-  }
-
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapLT(const Constraint& constraint,
-                                                 bool orEqual) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    int64_t valToCmp;
-    if (constraint.operandType == OperandType::DOUBLE) {
-      valToCmp = static_cast<int64_t>(std::ceil(constraint.operand.doubleVal));
-    } else {
-      if (orEqual) {
-        // Adding 1 here allows us to use < operator in the loop below
-        valToCmp = constraint.operand.int64Val + 1;
-      } else {
-        valToCmp = constraint.operand.int64Val;
+      // ceil(val) - 1 and floor(val) + 1 are the closest integers that are
+      // strictly less and greater than val.
+      double doubleLower = -std::numeric_limits<double>::infinity();
+      double doubleUpper = std::numeric_limits<double>::infinity();
+      switch (constraint.op) {
+        case IndexConstraintOperator::EQUAL:
+          // If val has a fractional part then it can't be equal to any integer
+          if (std::floor(val) != val) return false;
+          doubleLower = doubleUpper = val;
+          break;
+        case IndexConstraintOperator::LESS_THAN:
+          doubleUpper = std::ceil(val) - 1;
+          break;
+        case IndexConstraintOperator::LESS_THAN_EQUAL:
+          doubleUpper = std::floor(val);
+          break;
+        case IndexConstraintOperator::GREATER_THAN:
+          doubleLower = std::floor(val) + 1;
+          break;
+        case IndexConstraintOperator::GREATER_THAN_EQUAL:
+          doubleLower = std::ceil(val);
+          break;
+        default:
+          return false;
       }
-    }
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] < valToCmp) {
-        bitmap->Add(i);
+      // 2^63 and -2^63 are exactly representable as double
+      if (doubleLower >= 9223372036854775808.0 ||
+          doubleUpper < -9223372036854775808.0) {
+        return false;
       }
+      if (doubleLower > -9223372036854775808.0) {
+        newLower = static_cast<std::int64_t>(doubleLower);
+      }
+      if (doubleUpper < 9223372036854775808.0) {
+        newUpper = static_cast<std::int64_t>(doubleUpper);
+      }
+    } else {
+      // Operand is a string value, this should not happen because the query
+      // should fail before reaching this point
+      return false;
     }
 
-    return bitmap;
+    lower = std::max(lower, newLower);
+    upper = std::min(upper, newUpper);
+    return lower <= upper;
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapGT(const Constraint& constraint,
-                                                 bool orEqual) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    int64_t valToCmp;
-    if (constraint.operandType == OperandType::DOUBLE) {
-      valToCmp = static_cast<int64_t>(std::floor(constraint.operand.doubleVal));
-    } else {
-      if (orEqual) {
-        // Subtracting 1 here allows us to use > operator in the loop below
-        valToCmp = constraint.operand.int64Val - 1;
-      } else {
-        valToCmp = constraint.operand.int64Val;
-      }
-    }
-
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] > valToCmp) {
-        bitmap->Add(i);
-      }
+  // Returns the documents that satisfy both the constraints. Filter passes
+  // the same constraint twice. Documents before startID are not scanned.
+  std::shared_ptr<MamaJenniesBitmap> GetBitmap(const Constraint& constraint1,
+                                               const Constraint& constraint2,
+                                               std::uint64_t startID) {
+    // The range is clamped to the values T can hold
+    std::int64_t lower = std::numeric_limits<T>::min();
+    std::int64_t upper = std::numeric_limits<T>::max();
+    if (!NarrowRange(constraint1, lower, upper) ||
+        !NarrowRange(constraint2, lower, upper)) {
+      return std::make_shared<MamaJenniesBitmap>();
     }
 
-    return bitmap;
+    return ScanKernels::ScanToBitmap(
+        m_dataVector.Size(),
+        [this, lower, upper](std::size_t block) {
+          return m_zoneMap.Classify(block, lower, true, upper, true);
+        },
+        [this, lower, upper](std::size_t offset, std::size_t count,
+                             std::uint64_t* words) {
+          m_dataVector.Between(offset, count, static_cast<T>(lower),
+                               static_cast<T>(upper), words);
+        },
+        m_validity.GetMask(), startID);
   }
 
   IndexStat m_indexStat;
   std::vector<std::string> m_fieldNameTokens;
-  std::vector<T> m_dataVector;
+  PackedIntegerVector<T> m_dataVector;
+  ZoneMap<T> m_zoneMap;
+  ValidityBitmap m_validity;
   std::unique_ptr<Document> m_subDoc;
 };
 } // namespace jonoondb_api
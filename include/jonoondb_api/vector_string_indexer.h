@@ -4,6 +4,10 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <unordered_map>
 #include "indexer.h"
 #include "index_info_impl.h"
 #include "string_utils.h"
@@ -13,9 +17,17 @@
 #include "index_stat.h"
 #include "constraint.h"
 #include "enums.h"
+#include "scan_kernels.h"
+#include "string_pattern.h"
 #include "null_helpers.h"
+#include "validity_bitmap.h"
 
 namespace jonoondb_api {
+// Stores the column as an order preserving dictionary of the distinct
+// strings plus one int32 code per document. Predicates are translated to
+// code ranges once per query and then evaluated with the integer scan
+// kernels. Nulls are stored with code 0 and excluded by the validity
+// bitmap.
 class VectorStringIndexer final: public Indexer {
  public:
   VectorStringIndexer(const IndexInfoImpl& indexInfo,
@@ -51,8 +63,25 @@ class VectorStringIndexer final: public Indexer {
   void Insert(std::uint64_t documentID, const Document& document) override {
     auto val = DocumentUtils::GetStringValue(document, m_subDoc,
                                              m_fieldNameTokens);
-    assert(m_dataVector.size() == documentID);
-    m_dataVector.push_back(val);
+    m_indexStat.GetStatistics().AddValue(val);
+    assert(m_codes.size() == documentID);
+    if (NullHelpers::IsNull(val)) {
+      m_codes.push_back(0);
+      m_validity.PushBack(false);
+      return;
+    }
+
+    m_codes.push_back(GetCode(val));
+    m_validity.PushBack(true);
+    auto unsortedCount = m_dictionary.size() - m_sortedCount;
+    if (unsortedCount >= std::max(std::size_t(MIN_UNSORTED_COUNT),
+                                  m_sortedCount / 8)) {
+      SortDictionary();
+    }
+  }
+
+  void FinalizeBulkInsert() override {
+    SortDictionary();
   }
 
   const IndexStat& GetIndexStats() override {
@@ -60,19 +89,28 @@ class VectorStringIndexer final: public Indexer {
   }
 
   std::shared_ptr<MamaJenniesBitmap> Filter(const Constraint& constraint) override {
+    return FilterFrom(constraint, 0);
+  }
+
+  std::shared_ptr<MamaJenniesBitmap> FilterFrom(
+      const Constraint& constraint, std::uint64_t startID) override {
     switch (constraint.op) {
       case jonoondb_api::IndexConstraintOperator::EQUAL:
-        return GetBitmapEQ(constraint);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN:
-        return GetBitmapLT(constraint);
       case jonoondb_api::IndexConstraintOperator::LESS_THAN_EQUAL:
-        return GetBitmapLTE(constraint);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN:
-        return GetBitmapGT(constraint);
       case jonoondb_api::IndexConstraintOperator::GREATER_THAN_EQUAL:
-        return GetBitmapGTE(constraint);
-      case jonoondb_api::IndexConstraintOperator::MATCH:
-        // TODO: Handle this
+        return GetBitmap(constraint, constraint, startID);
+      case jonoondb_api::IndexConstraintOperator::LIKE:
+      case jonoondb_api::IndexConstraintOperator::GLOB:
+        return GetPatternBitmap(StringPattern(constraint), startID);
+      case jonoondb_api::IndexConstraintOperator::MATCH: {
+        std::ostringstream ss;
+        ss << "IndexConstraintOperator MATCH is not supported by index "
+            << m_indexStat.GetIndexInfo().GetIndexName()
+            << ", only FULL_TEXT indexes support it.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
       default:
         std::ostringstream ss;
         ss << "IndexConstraintOperator type "
@@ -84,50 +122,19 @@ class VectorStringIndexer final: public Indexer {
   std::shared_ptr<MamaJenniesBitmap> FilterRange(
       const Constraint& lowerConstraint,
       const Constraint& upperConstraint) override {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto lowerVal = GetOperandVal(lowerConstraint);
-    auto upperVal = GetOperandVal(upperConstraint);
-
-    if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] > lowerVal && m_dataVector[i] < upperVal
-            && !NullHelpers::IsNull(m_dataVector[i])) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] > lowerVal && m_dataVector[i] <= upperVal
-            && !NullHelpers::IsNull(m_dataVector[i])) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] >= lowerVal && m_dataVector[i] < upperVal
-            && !NullHelpers::IsNull(m_dataVector[i])) {
-          bitmap->Add(i);
-        }
-      }
-    } else if (lowerConstraint.op == IndexConstraintOperator::GREATER_THAN_EQUAL
-        && upperConstraint.op == IndexConstraintOperator::LESS_THAN_EQUAL) {
-      for (size_t i = 0; i < m_dataVector.size(); i++) {
-        if (m_dataVector[i] >= lowerVal && m_dataVector[i] <= upperVal
-            && !NullHelpers::IsNull(m_dataVector[i])) {
-          bitmap->Add(i);
-        }
-      }
-    }
+    return FilterRangeFrom(lowerConstraint, upperConstraint, 0);
+  }
 
-    return bitmap;
+  std::shared_ptr<MamaJenniesBitmap> FilterRangeFrom(
+      const Constraint& lowerConstraint, const Constraint& upperConstraint,
+      std::uint64_t startID) override {
+    return GetBitmap(lowerConstraint, upperConstraint, startID);
   }
 
   bool TryGetStringValue(std::uint64_t documentID, std::string& val) override {
-    if (documentID < m_dataVector.size()) {
-      val = m_dataVector[documentID];
+    if (documentID < m_codes.size()) {
+      val = m_validity.IsValid(documentID) ?
+          m_dictionary[m_codes[documentID]] : JONOONDB_NULL_STR;
       return true;
     }
 
@@ -135,6 +142,8 @@ class VectorStringIndexer final: public Indexer {
   }
 
  private:
+  static const std::size_t MIN_UNSORTED_COUNT = 64;
+
   inline std::string GetOperandVal(const Constraint& constraint) {
     std::string val;
     if (constraint.operandType == OperandType::INTEGER) {
@@ -146,74 +155,257 @@ class VectorStringIndexer final: public Indexer {
     }
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapEQ(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto val = GetOperandVal(constraint);
+  static bool Matches(const std::string& val, IndexConstraintOperator op,
+                      const std::string& operand) {
+    switch (op) {
+      case IndexConstraintOperator::EQUAL:
+        return val == operand;
+      case IndexConstraintOperator::LESS_THAN:
+        return val < operand;
+      case IndexConstraintOperator::LESS_THAN_EQUAL:
+        return val <= operand;
+      case IndexConstraintOperator::GREATER_THAN:
+        return val > operand;
+      case IndexConstraintOperator::GREATER_THAN_EQUAL:
+        return val >= operand;
+      default:
+        return false;
+    }
+  }
+
+  // Narrows the inclusive range [lower, upper] of sorted codes to the codes
+  // whose strings satisfy the constraint.
+  void NarrowCodeRange(IndexConstraintOperator op, const std::string& operand,
+                       std::int64_t& lower, std::int64_t& upper) {
+    auto begin = m_dictionary.begin();
+    auto end = m_dictionary.begin() + m_sortedCount;
+    auto lowerBound = [&]() -> std::int64_t {
+      return std::lower_bound(begin, end, operand) - begin;
+    };
+    auto upperBound = [&]() -> std::int64_t {
+      return std::upper_bound(begin, end, operand) - begin;
+    };
+
+    switch (op) {
+      case IndexConstraintOperator::EQUAL:
+        lower = std::max(lower, lowerBound());
+        upper = std::min(upper, upperBound() - 1);
+        break;
+      case IndexConstraintOperator::LESS_THAN:
+        upper = std::min(upper, lowerBound() - 1);
+        break;
+      case IndexConstraintOperator::LESS_THAN_EQUAL:
+        upper = std::min(upper, upperBound() - 1);
+        break;
+      case IndexConstraintOperator::GREATER_THAN:
+        lower = std::max(lower, upperBound());
+        break;
+      case IndexConstraintOperator::GREATER_THAN_EQUAL:
+        lower = std::max(lower, lowerBound());
+        break;
+      default:
+        upper = lower - 1;
+        break;
+    }
+  }
+
+  // Returns the documents that satisfy both the constraints. Filter passes
+  // the same constraint twice. The constraints are translated to a range of
+  // sorted codes and a set of unsorted codes once, the scan only compares
+  // codes. Documents before startID are not scanned.
+  std::shared_ptr<MamaJenniesBitmap> GetBitmap(const Constraint& constraint1,
+                                               const Constraint& constraint2,
+                                               std::uint64_t startID) {
+    auto operand1 = GetOperandVal(constraint1);
+    auto operand2 = GetOperandVal(constraint2);
+
+    std::int64_t lower = 0;
+    std::int64_t upper = static_cast<std::int64_t>(m_sortedCount) - 1;
+    NarrowCodeRange(constraint1.op, operand1, lower, upper);
+    NarrowCodeRange(constraint2.op, operand2, lower, upper);
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] == val && !NullHelpers::IsNull(m_dataVector[i])) {
-        bitmap->Add(i);
+    std::vector<bool> unsortedMatches(m_dictionary.size() - m_sortedCount);
+    bool hasUnsortedMatches = false;
+    for (std::size_t i = 0; i < unsortedMatches.size(); i++) {
+      auto& val = m_dictionary[m_sortedCount + i];
+      if (Matches(val, constraint1.op, operand1) &&
+          Matches(val, constraint2.op, operand2)) {
+        unsortedMatches[i] = true;
+        hasUnsortedMatches = true;
       }
     }
 
-    return bitmap;
+    if (!hasUnsortedMatches) {
+      return GetCodeRangeBitmap(lower, upper, startID);
+    }
+
+    auto sortedCount = static_cast<std::int64_t>(m_sortedCount);
+    return GetMatchingBitmap([&](std::int32_t code) {
+      if (code < sortedCount) {
+        return code >= lower && code <= upper;
+      }
+      return static_cast<bool>(unsortedMatches[code - sortedCount]);
+    }, startID);
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapLT(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto val = GetOperandVal(constraint);
+  // The pattern prefix gives a range of sorted codes. The strings in the
+  // range are only matched against the pattern when the range is not
+  // exact, the unsorted strings are always matched.
+  std::shared_ptr<MamaJenniesBitmap> GetPatternBitmap(
+      const StringPattern& pattern, std::uint64_t startID) {
+    if (m_dictionary.empty()) {
+      // Every value is null
+      return std::make_shared<MamaJenniesBitmap>();
+    }
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] < val && !NullHelpers::IsNull(m_dataVector[i])) {
-        bitmap->Add(i);
+    auto begin = m_dictionary.begin();
+    auto end = m_dictionary.begin() + m_sortedCount;
+    std::int64_t lower =
+        std::lower_bound(begin, end, pattern.GetLowerBound()) - begin;
+    std::int64_t upper = static_cast<std::int64_t>(m_sortedCount) - 1;
+    if (pattern.HasUpperBound()) {
+      upper =
+          (std::lower_bound(begin, end, pattern.GetUpperBound()) - begin) - 1;
+    }
+
+    std::vector<bool> matches(m_dictionary.size());
+    bool hasUnsortedMatches = false;
+    for (auto i = m_sortedCount; i < m_dictionary.size(); i++) {
+      if (pattern.Matches(m_dictionary[i])) {
+        matches[i] = true;
+        hasUnsortedMatches = true;
       }
     }
 
-    return bitmap;
+    if (pattern.IsExact() && !hasUnsortedMatches) {
+      return GetCodeRangeBitmap(lower, upper, startID);
+    }
+
+    for (auto i = lower; i <= upper; i++) {
+      matches[i] = pattern.IsExact() || pattern.Matches(m_dictionary[i]);
+    }
+
+    return GetMatchingBitmap([&matches](std::int32_t code) {
+      return static_cast<bool>(matches[code]);
+    }, startID);
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapLTE(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto val = GetOperandVal(constraint);
+  // Returns the documents whose code satisfies the predicate
+  template<typename Predicate>
+  std::shared_ptr<MamaJenniesBitmap> GetMatchingBitmap(Predicate predicate,
+                                                       std::uint64_t startID) {
+    auto codes = m_codes.data();
+    return ScanCodes(
+        [codes, &predicate](std::size_t offset, std::size_t count,
+                            std::uint64_t* words) {
+          ScanKernels::Matching(codes + offset, count, predicate, words);
+        }, startID);
+  }
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] <= val && !NullHelpers::IsNull(m_dataVector[i])) {
-        bitmap->Add(i);
-      }
+  // Runs kernel over the codes like ScanKernels::ScanToBitmap, the nulls
+  // are masked out of the result
+  template<typename Kernel>
+  std::shared_ptr<MamaJenniesBitmap> ScanCodes(Kernel kernel,
+                                               std::uint64_t startID) {
+    return ScanKernels::ScanToBitmap(
+        m_codes.size(),
+        [](std::size_t) {
+          return BlockMatch::SOME;
+        },
+        kernel, m_validity.GetMask(), startID);
+  }
+
+  // Returns the documents whose code is in the inclusive range
+  // [lower, upper] of sorted codes.
+  std::shared_ptr<MamaJenniesBitmap> GetCodeRangeBitmap(std::int64_t lower,
+                                                        std::int64_t upper,
+                                                        std::uint64_t startID) {
+    if (lower > upper) {
+      return std::make_shared<MamaJenniesBitmap>();
     }
 
-    return bitmap;
+    auto codes = m_codes.data();
+    auto lowerCode = static_cast<std::int32_t>(lower);
+    auto upperCode = static_cast<std::int32_t>(upper);
+    return ScanCodes(
+        [codes, lowerCode, upperCode](std::size_t offset, std::size_t count,
+                                      std::uint64_t* words) {
+          ScanKernels::Between(codes + offset, count, lowerCode, upperCode,
+                               words);
+        }, startID);
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapGT(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto val = GetOperandVal(constraint);
+  std::int32_t GetCode(const std::string& val) {
+    auto end = m_dictionary.begin() + m_sortedCount;
+    auto iter = std::lower_bound(m_dictionary.begin(), end, val);
+    if (iter != end && *iter == val) {
+      return static_cast<std::int32_t>(iter - m_dictionary.begin());
+    }
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] > val && !NullHelpers::IsNull(m_dataVector[i])) {
-        bitmap->Add(i);
-      }
+    auto unsortedIter = m_unsortedCodes.find(val);
+    if (unsortedIter != m_unsortedCodes.end()) {
+      return unsortedIter->second;
+    }
+
+    if (m_dictionary.size() >=
+        static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+      throw JonoonDBException(
+          "VectorStringIndexer cannot hold more distinct values.",
+          __FILE__, __func__, __LINE__);
     }
 
-    return bitmap;
+    auto code = static_cast<std::int32_t>(m_dictionary.size());
+    m_dictionary.push_back(val);
+    m_unsortedCodes.emplace(val, code);
+    return code;
   }
 
-  std::shared_ptr<MamaJenniesBitmap> GetBitmapGTE(const Constraint& constraint) {
-    auto bitmap = std::make_shared<MamaJenniesBitmap>();
-    auto val = GetOperandVal(constraint);
+  // Merges the unsorted strings into the sorted part of the dictionary and
+  // re-encodes the documents so that codes are in the same order as the
+  // strings.
+  void SortDictionary() {
+    if (m_sortedCount == m_dictionary.size()) {
+      return;
+    }
 
-    for (size_t i = 0; i < m_dataVector.size(); i++) {
-      if (m_dataVector[i] >= val && !NullHelpers::IsNull(m_dataVector[i])) {
-        bitmap->Add(i);
-      }
+    std::vector<std::int32_t> order(m_dictionary.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto compare = [this](std::int32_t code1, std::int32_t code2) {
+      return m_dictionary[code1] < m_dictionary[code2];
+    };
+    auto middle = order.begin() + m_sortedCount;
+    std::sort(middle, order.end(), compare);
+    std::inplace_merge(order.begin(), middle, order.end(), compare);
+
+    std::vector<std::int32_t> newCodes(order.size());
+    std::vector<std::string> dictionary;
+    dictionary.reserve(order.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+      newCodes[order[i]] = static_cast<std::int32_t>(i);
+      dictionary.push_back(std::move(m_dictionary[order[i]]));
+    }
+
+    // The codes of the nulls are remapped as well, they are never read
+    for (auto& code : m_codes) {
+      code = newCodes[code];
     }
 
-    return bitmap;
+    m_dictionary.swap(dictionary);
+    m_sortedCount = m_dictionary.size();
+    m_unsortedCodes.clear();
   }
 
   IndexStat m_indexStat;
   std::vector<std::string> m_fieldNameTokens;
-  std::vector<std::string> m_dataVector;
+  // Distinct non null strings, the first m_sortedCount are sorted and their
+  // index is their code. Strings added after the last sort are appended and
+  // looked up through m_unsortedCodes.
+  std::vector<std::string> m_dictionary;
+  std::size_t m_sortedCount = 0;
+  std::unordered_map<std::string, std::int32_t> m_unsortedCodes;
+  // Code of every document
+  std::vector<std::int32_t> m_codes;
+  ValidityBitmap m_validity;
   std::unique_ptr<Document> m_subDoc;
 };
 } // namespace jonoondb_api
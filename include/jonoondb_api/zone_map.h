@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "scan_kernels.h"
+
+namespace jonoondb_api {
+// Min/max summary of every block of ScanKernels::BLOCK_SIZE values of a
+// column. Predicates use it to skip the blocks that cannot match and to
+// emit the blocks that fully match without looking at the values.
+template<typename T>
+class ZoneMap {
+ public:
+  // Values have to be added for consecutive rows starting at 0
+  void Add(std::size_t row, T val) {
+    if (row % ScanKernels::BLOCK_SIZE == 0) {
+      m_zones.push_back(Zone());
+    }
+
+    auto& zone = m_zones.back();
+    if (IsUnordered(val)) {
+      zone.unorderedCount++;
+      return;
+    }
+
+    zone.min = std::min(zone.min, val);
+    zone.max = std::max(zone.max, val);
+    zone.hasValues = true;
+  }
+
+  // Nulls are not part of the min/max, they are excluded by the validity
+  // bitmap of the column
+  void AddNull(std::size_t row) {
+    if (row % ScanKernels::BLOCK_SIZE == 0) {
+      m_zones.push_back(Zone());
+    }
+  }
+
+  // Classifies the block for the predicate lower < val < upper, the bounds
+  // are included or excluded as specified.
+  template<typename Bound>
+  BlockMatch Classify(std::size_t block, Bound lower, bool lowerInclusive,
+                      Bound upper, bool upperInclusive) const {
+    const auto& zone = m_zones[block];
+    auto aboveLower = [&](T val) {
+      return lowerInclusive ? val >= lower : val > lower;
+    };
+    auto belowUpper = [&](T val) {
+      return upperInclusive ? val <= upper : val < upper;
+    };
+
+    if (!zone.hasValues || !aboveLower(zone.max) || !belowUpper(zone.min)) {
+      return BlockMatch::NONE;
+    }
+
+    if (zone.unorderedCount == 0 && aboveLower(zone.min) &&
+        belowUpper(zone.max)) {
+      return BlockMatch::ALL;
+    }
+
+    return BlockMatch::SOME;
+  }
+
+ private:
+  struct Zone {
+    T min = std::numeric_limits<T>::max();
+    T max = std::numeric_limits<T>::lowest();
+    bool hasValues = false;
+    // Number of values that never satisfy a comparison i.e. NaN
+    std::uint32_t unorderedCount = 0;
+  };
+
+  static bool IsUnordered(double val) {
+    return std::isnan(val);
+  }
+
+  template<typename U>
+  static bool IsUnordered(U val) {
+    return false;
+  }
+
+  std::vector<Zone> m_zones;
+};
+}  // namespace jonoondb_api
@@ -0,0 +1,3 @@
+// the configured options and settings
+#define TEST_FOLDER_PATH "/tmp/verify/build/unittests"
+#define RESOURCES_FOLDER_PATH "/tmp/verify/resources"
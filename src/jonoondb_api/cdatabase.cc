@@ -166,10 +166,16 @@ IndexType ToIndexType(std::int32_t type) {
   switch (static_cast<IndexType>(type)) {
     case IndexType::EWAH_COMPRESSED_BITMAP:
     case IndexType::VECTOR:
+    case IndexType::BIT_SLICED:
+    case IndexType::SORTED:
+    case IndexType::HASH:
+    case IndexType::UNIQUE_HASH:
+    case IndexType::TRIGRAM:
+    case IndexType::FULL_TEXT:
       return static_cast<IndexType>(type);
     default:
       throw InvalidArgumentException(
-          "Argument type is not valid. Allowed values are {EWAH_COMPRESSED_BITMAP = 1, VECTOR = 2}.",
+          "Argument type is not valid. Allowed values are {EWAH_COMPRESSED_BITMAP = 1, VECTOR = 2, BIT_SLICED = 3, SORTED = 4, HASH = 5, UNIQUE_HASH = 6, TRIGRAM = 7, FULL_TEXT = 8}.",
           __FILE__,
           __func__,
           __LINE__);
@@ -723,6 +729,80 @@ void jonoondb_database_multi_insert(database_ptr db,
   }, *sts);
 }
 
+void jonoondb_database_createindex(database_ptr db,
+                                   const char* collectionName,
+                                   const indexinfo_ptr indexInfo,
+                                   status_ptr* sts) {
+  TranslateExceptions([&] {
+    db->impl.CreateIndex(collectionName, indexInfo->impl);
+  }, *sts);
+}
+
+void jonoondb_database_dropindex(database_ptr db,
+                                 const char* collectionName,
+                                 const char* indexName,
+                                 status_ptr* sts) {
+  TranslateExceptions([&] {
+    db->impl.DropIndex(collectionName, indexName);
+  }, *sts);
+}
+
+void jonoondb_database_begin_bulk_load(database_ptr db,
+                                       const char* collectionName,
+                                       status_ptr* sts) {
+  TranslateExceptions([&] {
+    db->impl.BeginBulkLoad(collectionName);
+  }, *sts);
+}
+
+void jonoondb_database_end_bulk_load(database_ptr db,
+                                     const char* collectionName,
+                                     status_ptr* sts) {
+  TranslateExceptions([&] {
+    db->impl.EndBulkLoad(collectionName);
+  }, *sts);
+}
+
+int32_t jonoondb_database_try_get_by_key_integer(database_ptr db,
+                                                 const char* collectionName,
+                                                 const char* columnName,
+                                                 int64_t key,
+                                                 jonoondb_buffer_ptr document,
+                                                 status_ptr* sts) {
+  int32_t val = 0;
+  TranslateExceptions([&] {
+    BufferImpl buffer;
+    if (db->impl.TryGetByKey(collectionName, columnName, key, buffer)) {
+      // buffer can point to memory owned by the collection, so copy it
+      document->impl = buffer;
+      val = 1;
+    }
+  }, *sts);
+
+  return val;
+}
+
+int32_t jonoondb_database_try_get_by_key_string(database_ptr db,
+                                                const char* collectionName,
+                                                const char* columnName,
+                                                const char* key,
+                                                uint64_t keyLength,
+                                                jonoondb_buffer_ptr document,
+                                                status_ptr* sts) {
+  int32_t val = 0;
+  TranslateExceptions([&] {
+    BufferImpl buffer;
+    boost::string_ref keyRef(key, keyLength);
+    if (db->impl.TryGetByKey(collectionName, columnName, keyRef, buffer)) {
+      // buffer can point to memory owned by the collection, so copy it
+      document->impl = buffer;
+      val = 1;
+    }
+  }, *sts);
+
+  return val;
+}
+
 resultset_ptr jonoondb_database_executeselect(database_ptr db,
                                               const char* selectStmt,
                                               uint64_t selectStmtLength,
@@ -0,0 +1,295 @@
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include "column_statistics.h"
+#include "constraint.h"
+#include "enums.h"
+#include "string_pattern.h"
+#include "null_helpers.h"
+
+using namespace jonoondb_api;
+
+namespace {
+// Selectivities used when the operand is not known or cannot be compared
+// with the sampled values
+const double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+const double DEFAULT_PATTERN_SELECTIVITY = 1.0 / 10;
+const double DEFAULT_MATCH_SELECTIVITY = 1.0 / 20;
+
+std::uint64_t Mix(std::uint64_t hash) {
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+bool IsComparison(IndexConstraintOperator op) {
+  return op == IndexConstraintOperator::EQUAL ||
+      op == IndexConstraintOperator::LESS_THAN ||
+      op == IndexConstraintOperator::LESS_THAN_EQUAL ||
+      op == IndexConstraintOperator::GREATER_THAN ||
+      op == IndexConstraintOperator::GREATER_THAN_EQUAL;
+}
+
+bool SatisfiesComparison(int cmp, IndexConstraintOperator op) {
+  switch (op) {
+    case IndexConstraintOperator::EQUAL:
+      return cmp == 0;
+    case IndexConstraintOperator::LESS_THAN:
+      return cmp < 0;
+    case IndexConstraintOperator::LESS_THAN_EQUAL:
+      return cmp <= 0;
+    case IndexConstraintOperator::GREATER_THAN:
+      return cmp > 0;
+    case IndexConstraintOperator::GREATER_THAN_EQUAL:
+      return cmp >= 0;
+    default:
+      return false;
+  }
+}
+
+// Evaluates a constraint against sampled values
+class SampleMatcher {
+ public:
+  explicit SampleMatcher(const Constraint& constraint)
+      : m_constraint(constraint) {
+    if (constraint.op == IndexConstraintOperator::LIKE ||
+        constraint.op == IndexConstraintOperator::GLOB) {
+      m_pattern.reset(new StringPattern(constraint));
+    }
+  }
+
+  bool CanMatchNumbers() const {
+    return IsComparison(m_constraint.op) &&
+        (m_constraint.operandType == OperandType::INTEGER ||
+            m_constraint.operandType == OperandType::DOUBLE);
+  }
+
+  bool CanMatchStrings() const {
+    return m_pattern != nullptr || (IsComparison(m_constraint.op) &&
+        m_constraint.operandType == OperandType::STRING);
+  }
+
+  bool Matches(double sample) const {
+    double operand = m_constraint.operandType == OperandType::INTEGER ?
+        static_cast<double>(m_constraint.operand.int64Val) :
+        m_constraint.operand.doubleVal;
+    int cmp = sample < operand ? -1 : (sample > operand ? 1 : 0);
+    return SatisfiesComparison(cmp, m_constraint.op);
+  }
+
+  bool Matches(const std::string& sample) const {
+    if (m_pattern != nullptr) {
+      return m_pattern->Matches(sample);
+    }
+    return SatisfiesComparison(sample.compare(m_constraint.strVal),
+                               m_constraint.op);
+  }
+
+ private:
+  const Constraint& m_constraint;
+  std::unique_ptr<StringPattern> m_pattern;
+};
+
+template<typename T>
+double GetSampleFraction(const std::vector<T>& samples,
+                         const SampleMatcher& matcher1,
+                         const SampleMatcher& matcher2) {
+  std::size_t count = 0;
+  for (auto& sample : samples) {
+    if (matcher1.Matches(sample) && matcher2.Matches(sample)) {
+      count++;
+    }
+  }
+
+  // Never report 0, the sample can miss rare values
+  return (count + 0.5) / (samples.size() + 1);
+}
+}  // namespace
+
+ColumnStatistics::ColumnStatistics()
+    : m_valueCount(0), m_nullCount(0), m_registers(1 << REGISTER_BITS, 0) {
+}
+
+void ColumnStatistics::AddValue(std::int64_t val) {
+  if (NullHelpers::IsNull(val)) {
+    AddNull();
+    return;
+  }
+
+  AddHash(Mix(static_cast<std::uint64_t>(val)));
+  AddSample(static_cast<double>(val), m_numericSamples);
+}
+
+void ColumnStatistics::AddValue(double val) {
+  if (std::isnan(val) || NullHelpers::IsNull(val)) {
+    AddNull();
+    return;
+  }
+
+  // 0.0 and -0.0 are the same value
+  double normalized = val == 0 ? 0.0 : val;
+  std::uint64_t bits;
+  std::memcpy(&bits, &normalized, sizeof(bits));
+  AddHash(Mix(bits));
+  AddSample(val, m_numericSamples);
+}
+
+void ColumnStatistics::AddValue(const std::string& val) {
+  if (NullHelpers::IsNull(val)) {
+    AddNull();
+    return;
+  }
+
+  AddHash(Mix(std::hash<std::string>()(val)));
+  AddSample(val, m_stringSamples);
+}
+
+template<typename T>
+void ColumnStatistics::AddSample(const T& val, std::vector<T>& samples) {
+  std::size_t slot;
+  if (!TryGetSampleSlot(slot)) {
+    return;
+  }
+
+  if (slot >= samples.size()) {
+    samples.push_back(val);
+  } else {
+    samples[slot] = val;
+  }
+}
+
+void ColumnStatistics::AddNull() {
+  m_nullCount++;
+}
+
+void ColumnStatistics::AddHash(std::uint64_t hash) {
+  m_valueCount++;
+  auto index = hash >> (64 - REGISTER_BITS);
+  auto rest = hash << REGISTER_BITS;
+  std::uint8_t rank = 1;
+  while (rank <= 64 - REGISTER_BITS && (rest & (1ULL << 63)) == 0) {
+    rest <<= 1;
+    rank++;
+  }
+  m_registers[index] = std::max(m_registers[index], rank);
+}
+
+// Reservoir sampling: the n-th value replaces a random sample with
+// probability SAMPLE_SIZE / n. m_valueCount already includes the value.
+// Returns false if the value is not sampled, a slot past the samples means
+// append.
+bool ColumnStatistics::TryGetSampleSlot(std::size_t& slot) {
+  if (m_valueCount <= SAMPLE_SIZE) {
+    slot = static_cast<std::size_t>(m_valueCount - 1);
+    return true;
+  }
+
+  std::uniform_int_distribution<std::uint64_t> distribution(0,
+                                                            m_valueCount - 1);
+  auto randomSlot = distribution(m_random);
+  slot = static_cast<std::size_t>(randomSlot);
+  return randomSlot < SAMPLE_SIZE;
+}
+
+std::uint64_t ColumnStatistics::GetDistinctCount() const {
+  if (m_valueCount == 0) {
+    return 0;
+  }
+
+  const double registerCount = static_cast<double>(m_registers.size());
+  double sum = 0;
+  std::size_t zeroCount = 0;
+  for (auto reg : m_registers) {
+    sum += std::ldexp(1.0, -reg);
+    if (reg == 0) {
+      zeroCount++;
+    }
+  }
+
+  double alpha = 0.7213 / (1 + 1.079 / registerCount);
+  double estimate = alpha * registerCount * registerCount / sum;
+  if (estimate <= 2.5 * registerCount && zeroCount > 0) {
+    // Linear counting is more accurate for small cardinalities
+    estimate = registerCount * std::log(registerCount / zeroCount);
+  }
+
+  auto count = static_cast<std::uint64_t>(std::llround(estimate));
+  return std::max<std::uint64_t>(1, std::min(count, m_valueCount));
+}
+
+double ColumnStatistics::GetValueFraction() const {
+  auto documentCount = GetDocumentCount();
+  return documentCount == 0 ? 0 :
+      static_cast<double>(m_valueCount) / documentCount;
+}
+
+double ColumnStatistics::EstimateSelectivity(
+    const Constraint& constraint) const {
+  return EstimateSelectivity(constraint, constraint);
+}
+
+double ColumnStatistics::EstimateSelectivity(
+    const Constraint& constraint1, const Constraint& constraint2) const {
+  // Uniform distribution of the distinct values for equality
+  if (constraint1.op == IndexConstraintOperator::EQUAL ||
+      constraint2.op == IndexConstraintOperator::EQUAL) {
+    return EstimateSelectivity(IndexConstraintOperator::EQUAL);
+  }
+
+  auto selectivity = EstimateSampleSelectivity(constraint1, constraint2);
+  if (selectivity >= 0) {
+    return selectivity * GetValueFraction();
+  }
+
+  selectivity = EstimateSelectivity(constraint1.op);
+  auto valueFraction = GetValueFraction();
+  if (&constraint1 != &constraint2 && valueFraction > 0) {
+    // Nulls are already excluded by the first estimate
+    selectivity *= EstimateSelectivity(constraint2.op) / valueFraction;
+  }
+  return selectivity;
+}
+
+// Returns the fraction of the non null values that satisfy the constraints
+// according to the sample or -1 if the sample cannot be used
+double ColumnStatistics::EstimateSampleSelectivity(
+    const Constraint& constraint1, const Constraint& constraint2) const {
+  SampleMatcher matcher1(constraint1);
+  SampleMatcher matcher2(constraint2);
+  if (!m_numericSamples.empty() && matcher1.CanMatchNumbers() &&
+      matcher2.CanMatchNumbers()) {
+    return GetSampleFraction(m_numericSamples, matcher1, matcher2);
+  }
+
+  if (!m_stringSamples.empty() && matcher1.CanMatchStrings() &&
+      matcher2.CanMatchStrings()) {
+    return GetSampleFraction(m_stringSamples, matcher1, matcher2);
+  }
+
+  return -1;
+}
+
+double ColumnStatistics::EstimateSelectivity(
+    IndexConstraintOperator op) const {
+  switch (op) {
+    case IndexConstraintOperator::EQUAL: {
+      auto distinctCount = GetDistinctCount();
+      return distinctCount == 0 ? 0 : GetValueFraction() / distinctCount;
+    }
+    case IndexConstraintOperator::LESS_THAN:
+    case IndexConstraintOperator::LESS_THAN_EQUAL:
+    case IndexConstraintOperator::GREATER_THAN:
+    case IndexConstraintOperator::GREATER_THAN_EQUAL:
+      return DEFAULT_RANGE_SELECTIVITY * GetValueFraction();
+    case IndexConstraintOperator::LIKE:
+    case IndexConstraintOperator::GLOB:
+      return DEFAULT_PATTERN_SELECTIVITY * GetValueFraction();
+    default:
+      return DEFAULT_MATCH_SELECTIVITY * GetValueFraction();
+  }
+}
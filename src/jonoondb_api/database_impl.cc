@@ -18,6 +18,8 @@
 #include "index_info_impl.h"
 #include "proc_utils.h"
 #include "jonoondb_api/write_options_impl.h"
+#include "constraint.h"
+#include "buffer_impl.h"
 
 using namespace jonoondb_api;
 
@@ -189,6 +191,95 @@ void DatabaseImpl::MultiInsert(const boost::string_ref& collectionName,
   item->second->MultiInsert(documents, wo);
 }
 
+void DatabaseImpl::CreateIndex(const char* collectionName,
+                               const IndexInfoImpl& indexInfo) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  // The collection validates the index and starts building it
+  item->second->CreateIndex(indexInfo);
+  try {
+    m_dbMetadataMgrImpl->CreateIndex(collectionName, indexInfo);
+  } catch (...) {
+    item->second->DropIndex(indexInfo.GetIndexName());
+    throw;
+  }
+}
+
+void DatabaseImpl::DropIndex(const char* collectionName,
+                             const char* indexName) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  item->second->DropIndex(indexName);
+  m_dbMetadataMgrImpl->RemoveIndex(collectionName, indexName);
+}
+
+void DatabaseImpl::BeginBulkLoad(const char* collectionName) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  item->second->BeginBulkLoad();
+}
+
+void DatabaseImpl::EndBulkLoad(const char* collectionName) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  item->second->EndBulkLoad();
+}
+
+bool DatabaseImpl::TryGetByKey(const char* collectionName,
+                               const char* columnName, std::int64_t key,
+                               BufferImpl& document) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  std::string colName(columnName);
+  Constraint constraint(colName, IndexConstraintOperator::EQUAL);
+  constraint.operandType = OperandType::INTEGER;
+  constraint.operand.int64Val = key;
+  return item->second->TryGetDocumentByKey(constraint, document);
+}
+
+bool DatabaseImpl::TryGetByKey(const char* collectionName,
+                               const char* columnName,
+                               const boost::string_ref& key,
+                               BufferImpl& document) {
+  auto item = m_collectionContainer.find(collectionName);
+  if (item == m_collectionContainer.end()) {
+    std::ostringstream ss;
+    ss << "Collection \"" << collectionName << "\" not found.";
+    throw CollectionNotFoundException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  std::string colName(columnName);
+  Constraint constraint(colName, IndexConstraintOperator::EQUAL);
+  constraint.operandType = OperandType::STRING;
+  constraint.strVal.assign(key.data(), key.size());
+  return item->second->TryGetDocumentByKey(constraint, document);
+}
+
 ResultSetImpl DatabaseImpl::ExecuteSelect(const std::string& selectStatement) {
   return m_queryProcessor->ExecuteSelect(selectStatement);
 }
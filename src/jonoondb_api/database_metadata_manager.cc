@@ -145,6 +145,20 @@ void DatabaseMetadataManager::PrepareStatements() {
     throw SQLException(msg, __FILE__, __func__, __LINE__);
   }
 
+  sqliteCode =
+      sqlite3_prepare_v2(
+          m_metadataDBConnection.get(),
+          "DELETE FROM CollectionIndex WHERE CollectionName = ? AND IndexName = ?",  // stmt
+          -1,  // If greater than zero, then stmt is read up to the first null terminator
+          &m_deleteCollectionIndexStmt,  //Statement that is to be prepared
+          0  // Pointer to unused portion of stmt
+      );
+
+  if (sqliteCode != SQLITE_OK) {
+    std::string msg = sqlite3_errstr(sqliteCode);
+    throw SQLException(msg, __FILE__, __func__, __LINE__);
+  }
+
   sqliteCode =
       sqlite3_prepare_v2(
           m_metadataDBConnection.get(),
@@ -477,7 +491,44 @@ void DatabaseMetadataManager::CreateIndex(const std::string& collectionName,
   }
 }
 
+void DatabaseMetadataManager::RemoveIndex(const std::string& collectionName,
+                                          const std::string& indexName) {
+  std::unique_ptr<sqlite3_stmt, void (*)(sqlite3_stmt*)> statementGuard(
+      m_deleteCollectionIndexStmt, SQLiteUtils::ClearAndResetStatement);
+
+  int sqliteCode =
+      sqlite3_bind_text(m_deleteCollectionIndexStmt, 1,  // Index of wildcard
+                        collectionName.c_str(),
+                        collectionName.size(),
+                        SQLITE_STATIC);
+  if (sqliteCode != SQLITE_OK)
+    throw SQLException(sqlite3_errstr(sqliteCode),
+                       __FILE__,
+                       __func__,
+                       __LINE__);
+
+  sqliteCode =
+      sqlite3_bind_text(m_deleteCollectionIndexStmt, 2,  // Index of wildcard
+                        indexName.c_str(),
+                        indexName.size(),
+                        SQLITE_STATIC);
+  if (sqliteCode != SQLITE_OK)
+    throw SQLException(sqlite3_errstr(sqliteCode),
+                       __FILE__,
+                       __func__,
+                       __LINE__);
+
+  sqliteCode = sqlite3_step(m_deleteCollectionIndexStmt);
+  if (sqliteCode != SQLITE_DONE) {
+    throw SQLException(sqlite3_errstr(sqliteCode),
+                       __FILE__,
+                       __func__,
+                       __LINE__);
+  }
+}
+
 void DatabaseMetadataManager::FinalizeStatements() {
   GuardFuncs::SQLite3Finalize(m_insertCollectionIndexStmt);
+  GuardFuncs::SQLite3Finalize(m_deleteCollectionIndexStmt);
   GuardFuncs::SQLite3Finalize(m_insertCollectionSchemaStmt);
 }
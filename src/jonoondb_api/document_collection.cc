@@ -1,7 +1,9 @@
 #include <string>
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <unordered_map>
 #include <string>
+#include <future>
 #include "sqlite3.h"
 #include "document_collection.h"
 #include "string_utils.h"
@@ -16,6 +18,7 @@
 #include "enums.h"
 #include "jonoondb_exceptions.h"
 #include "index_stat.h"
+#include "composite_indexer.h"
 #include "mama_jennies_bitmap.h"
 #include "blob_manager.h"
 #include "constraint.h"
@@ -35,7 +38,10 @@ DocumentCollection::DocumentCollection(const std::string& databaseMetadataFilePa
                                        const std::vector<FileInfo>& dataFilesToLoad)
     :
     m_blobManager(move(blobManager)),
-    m_dbConnection(nullptr, SQLiteUtils::CloseSQLiteConnection) {
+    m_dbConnection(nullptr, SQLiteUtils::CloseSQLiteConnection),
+    m_bulkLoadInProgress(false), m_bulkLoadStartID(0),
+    m_indexesAreInvalid(false),
+    m_indexedDocumentCount(0) {
   // Validate function arguments
   if (databaseMetadataFilePath.size() == 0) {
     throw InvalidArgumentException("Argument databaseMetadataFilePath is empty.",
@@ -95,13 +101,27 @@ DocumentCollection::DocumentCollection(const std::string& databaseMetadataFilePa
                                                        blobs[i]));
       }
 
-      auto
-          startID = m_indexManager->IndexDocuments(m_documentIDGenerator, docs);
+      auto startID = m_documentIDGenerator.ReserveID(actualBatchSize);
       assert(startID == m_documentIDMap.size());
+      m_indexManager->BulkIndexDocuments(startID, docs);
       m_documentIDMap.insert(m_documentIDMap.end(), blobMetadataVec.begin(),
                              blobMetadataVec.begin() + actualBatchSize);
     }
   }
+
+  m_indexManager->FinalizeBulkIndexing();
+  m_indexedDocumentCount = m_documentIDMap.size();
+}
+
+DocumentCollection::~DocumentCollection() {
+  for (auto& build : m_indexBuilds) {
+    build->isCancelled = true;
+  }
+  for (auto& build : m_indexBuilds) {
+    if (build->thread.joinable()) {
+      build->thread.join();
+    }
+  }
 }
 
 void DocumentCollection::Insert(const BufferImpl& documentData,
@@ -113,6 +133,7 @@ void DocumentCollection::Insert(const BufferImpl& documentData,
 
 void jonoondb_api::DocumentCollection::MultiInsert(
     gsl::span<const BufferImpl*>& documents, const WriteOptionsImpl& wo) {
+  ThrowIfIndexesAreInvalid();
   std::vector<std::unique_ptr<Document>> docs;
 
   for (size_t i = 0; i < documents.size(); i++) {
@@ -128,8 +149,14 @@ void jonoondb_api::DocumentCollection::MultiInsert(
   std::vector<BlobMetadata> blobMetadataVec(documents.size());
   // Indexing should not fail after we have called ValidateForIndexing
   try {
-    auto startID = m_indexManager->IndexDocuments(m_documentIDGenerator, docs);
-    assert(startID == m_documentIDMap.size());
+    if (m_bulkLoadInProgress) {
+      // Documents are indexed in EndBulkLoad
+      auto startID = m_documentIDGenerator.ReserveID(documents.size());
+      assert(startID == m_documentIDMap.size());
+    } else {
+      auto startID = m_indexManager->IndexDocuments(m_documentIDGenerator, docs);
+      assert(startID == m_documentIDMap.size());
+    }
     m_blobManager->MultiPut(documents, blobMetadataVec, wo.compress);
   } catch (...) {
     // This is a serious error. Exception at this point will leave DB in a invalid state.
@@ -138,9 +165,280 @@ void jonoondb_api::DocumentCollection::MultiInsert(
     throw;
   }
 
+  std::unique_lock<std::mutex> lock(m_documentIDMapMutex);
   m_documentIDMap.insert(m_documentIDMap.end(),
                          blobMetadataVec.begin(),
                          blobMetadataVec.end());
+  if (!m_bulkLoadInProgress) {
+    m_indexedDocumentCount = m_documentIDMap.size();
+  }
+}
+
+void DocumentCollection::BeginBulkLoad() {
+  ThrowIfIndexesAreInvalid();
+  if (m_bulkLoadInProgress) {
+    ostringstream ss;
+    ss << "Bulk load is already in progress for collection " << m_name << ".";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  RemoveFinishedIndexBuilds();
+  if (!m_indexBuilds.empty()) {
+    // The index builds read the documents that are not indexed yet
+    ostringstream ss;
+    ss << "Bulk load cannot start for collection " << m_name
+        << " while indexes are being built.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  if (m_indexManager->HasUniqueIndex()) {
+    // Uniqueness is checked when documents are indexed which happens only
+    // at the end of a bulk load
+    ostringstream ss;
+    ss << "Bulk load is not supported for collection " << m_name
+        << " because it has a unique index.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  m_bulkLoadInProgress = true;
+  m_bulkLoadStartID = m_documentIDMap.size();
+}
+
+void DocumentCollection::EndBulkLoad() {
+  if (!m_bulkLoadInProgress) {
+    ostringstream ss;
+    ss << "Bulk load is not in progress for collection " << m_name << ".";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  ThrowIfIndexesAreInvalid();
+  // Read back the documents inserted during the bulk load and index them.
+  // If reading fails nothing of the batch is staged and calling EndBulkLoad
+  // again resumes with it.
+  const std::size_t desiredBatchSize = 10000;
+  std::vector<BufferImpl> blobs(desiredBatchSize);
+  std::vector<std::unique_ptr<Document>> docs;
+  while (m_bulkLoadStartID < m_documentIDMap.size()) {
+    auto startID = m_bulkLoadStartID;
+    auto batchSize = std::min<std::size_t>(desiredBatchSize,
+                                           m_documentIDMap.size() - startID);
+    docs.clear();
+    for (size_t i = 0; i < batchSize; i++) {
+      m_blobManager->Get(m_documentIDMap[startID + i], blobs[i]);
+      docs.push_back(DocumentFactory::CreateDocument(*m_documentSchema,
+                                                     blobs[i]));
+    }
+
+    IndexBulkLoadedDocuments([&]() {
+      m_indexManager->BulkIndexDocuments(startID, docs);
+    });
+    m_bulkLoadStartID = startID + batchSize;
+  }
+
+  IndexBulkLoadedDocuments([&]() {
+    m_indexManager->FinalizeBulkIndexing();
+  });
+  // The bulk loaded documents become visible to queries together
+  m_indexedDocumentCount = m_documentIDMap.size();
+  m_bulkLoadInProgress = false;
+}
+
+void DocumentCollection::CreateIndex(const IndexInfoImpl& indexInfo) {
+  ThrowIfIndexesAreInvalid();
+  if (m_bulkLoadInProgress) {
+    ostringstream ss;
+    ss << "Index " << indexInfo.GetIndexName()
+        << " cannot be created while a bulk load is in progress for collection "
+        << m_name << ".";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  if (indexInfo.GetType() == IndexType::UNIQUE_HASH) {
+    // Documents inserted during the build could not be rejected anymore
+    ostringstream ss;
+    ss << "Index " << indexInfo.GetIndexName()
+        << " cannot be created on an existing collection because it is unique.";
+    throw InvalidArgumentException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  RemoveFinishedIndexBuilds();
+  auto build = std::find_if(
+      m_indexBuilds.begin(), m_indexBuilds.end(),
+      [&indexInfo](const std::unique_ptr<IndexBuild>& build) {
+        return build->indexName == indexInfo.GetIndexName();
+      });
+  if (build != m_indexBuilds.end() && !(*build)->error.empty()) {
+    ostringstream ss;
+    ss << "Index with name " << indexInfo.GetIndexName()
+        << " already exists but could not be built: " << (*build)->error
+        << ". Drop the index and create it again.";
+    throw IndexAlreadyExistException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  if (build != m_indexBuilds.end() ||
+      m_indexManager->HasIndex(indexInfo.GetIndexName())) {
+    ostringstream ss;
+    ss << "Index with name " << indexInfo.GetIndexName()
+        << " already exists.";
+    throw IndexAlreadyExistException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  unordered_map<string, FieldType> columnTypes;
+  std::vector<IndexInfoImpl*> indexes{const_cast<IndexInfoImpl*>(&indexInfo)};
+  PopulateColumnTypes(indexes, *m_documentSchema, columnTypes);
+  auto indexer = m_indexManager->CreateIndexer(indexInfo, columnTypes);
+
+  auto newBuild = std::make_unique<IndexBuild>();
+  newBuild->indexName = indexInfo.GetIndexName();
+  newBuild->thread = std::thread(&DocumentCollection::BuildIndex, this,
+                                 newBuild.get(), std::move(indexer));
+  m_indexBuilds.push_back(std::move(newBuild));
+}
+
+void DocumentCollection::DropIndex(const std::string& indexName) {
+  bool wasBuilding = false;
+  for (auto& build : m_indexBuilds) {
+    if (build->indexName == indexName) {
+      build->isCancelled = true;
+      if (build->thread.joinable()) {
+        build->thread.join();
+      }
+      wasBuilding = true;
+    }
+  }
+  m_indexBuilds.erase(
+      std::remove_if(m_indexBuilds.begin(), m_indexBuilds.end(),
+                     [&indexName](const std::unique_ptr<IndexBuild>& build) {
+                       return build->indexName == indexName;
+                     }),
+      m_indexBuilds.end());
+
+  // A build can finish before it sees the cancellation, a failed build
+  // never added its indexer
+  if (!m_indexManager->TryDropIndex(indexName) && !wasBuilding) {
+    ostringstream ss;
+    ss << "Index with name " << indexName << " does not exist in collection "
+        << m_name << ".";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+}
+
+// An indexer that fails while indexing a batch can keep part of it, the
+// indexes cannot be used anymore. The documents are persisted so reopening
+// the database indexes them again.
+template<typename Function>
+void DocumentCollection::IndexBulkLoadedDocuments(Function function) {
+  try {
+    function();
+  } catch (...) {
+    m_indexesAreInvalid = true;
+    throw;
+  }
+}
+
+void DocumentCollection::ThrowIfIndexesAreInvalid() {
+  if (m_indexesAreInvalid) {
+    ostringstream ss;
+    ss << "The indexes of collection " << m_name
+        << " are incomplete because indexing failed at the end of a bulk"
+        << " load. Reopen the database to index the documents again.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+}
+
+void DocumentCollection::RemoveFinishedIndexBuilds() {
+  for (auto& build : m_indexBuilds) {
+    if (build->isDone && build->thread.joinable()) {
+      build->thread.join();
+    }
+  }
+  // Failed builds are kept until the index is dropped
+  m_indexBuilds.erase(
+      std::remove_if(m_indexBuilds.begin(), m_indexBuilds.end(),
+                     [](const std::unique_ptr<IndexBuild>& build) {
+                       return build->isDone && build->error.empty();
+                     }),
+      m_indexBuilds.end());
+}
+
+// Indexes the documents in batches until the indexer has caught up with
+// the inserts, then hands it over to the IndexManager.
+void DocumentCollection::BuildIndex(IndexBuild* build,
+                                    std::unique_ptr<Indexer> indexer) {
+  const std::size_t desiredBatchSize = 10000;
+  std::vector<BlobMetadata> blobMetadataVec;
+  std::vector<BufferImpl> blobs;
+  std::vector<std::unique_ptr<Document>> docs;
+  std::uint64_t indexedCount = 0;
+  try {
+    while (!build->isCancelled) {
+      {
+        std::unique_lock<std::mutex> lock(m_documentIDMapMutex);
+        auto batchSize = std::min<std::size_t>(
+            desiredBatchSize, m_documentIDMap.size() - indexedCount);
+        blobMetadataVec.assign(m_documentIDMap.begin() + indexedCount,
+                               m_documentIDMap.begin() + indexedCount +
+                                   batchSize);
+      }
+
+      if (blobMetadataVec.empty()) {
+        if (m_indexManager->TryAddBuiltIndexer(indexer, indexedCount,
+                                               m_documentIDGenerator)) {
+          break;
+        }
+
+        // Documents with reserved ids are still being written
+        std::this_thread::yield();
+        continue;
+      }
+
+      ReadDocuments(blobMetadataVec, blobs, docs);
+      indexer->BulkInsert(indexedCount, docs);
+      indexedCount += blobMetadataVec.size();
+    }
+  } catch (std::exception& ex) {
+    // The index is not added, CreateIndex reports the error until the
+    // index is dropped
+    build->error = ex.what();
+  }
+
+  build->isDone = true;
+}
+
+// Reads and parses the documents on several threads
+void DocumentCollection::ReadDocuments(
+    const std::vector<BlobMetadata>& blobMetadataVec,
+    std::vector<BufferImpl>& blobs,
+    std::vector<std::unique_ptr<Document>>& documents) {
+  const std::size_t minDocumentsPerThread = 1000;
+  auto count = blobMetadataVec.size();
+  if (blobs.size() < count) {
+    blobs.resize(count);
+  }
+  documents.clear();
+  documents.resize(count);
+
+  auto threadCount = std::max<std::size_t>(1, std::min<std::size_t>(
+      std::thread::hardware_concurrency(), count / minDocumentsPerThread));
+  auto read = [&](std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; i++) {
+      m_blobManager->Get(blobMetadataVec[i], blobs[i]);
+      documents[i] = DocumentFactory::CreateDocument(*m_documentSchema,
+                                                     blobs[i]);
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  auto chunkSize = (count + threadCount - 1) / threadCount;
+  for (std::size_t begin = chunkSize; begin < count; begin += chunkSize) {
+    futures.push_back(std::async(std::launch::async, read, begin,
+                                 std::min(count, begin + chunkSize)));
+  }
+  read(0, std::min(count, chunkSize));
+  for (auto& future : futures) {
+    // Rethrows the exceptions of the other threads
+    future.get();
+  }
 }
 
 const std::string& DocumentCollection::GetName() {
@@ -151,26 +449,62 @@ const std::shared_ptr<DocumentSchema>& DocumentCollection::GetDocumentSchema() {
   return m_documentSchema;
 }
 
+std::uint64_t DocumentCollection::GetDocumentCount() const {
+  return m_documentIDMap.size();
+}
+
 bool DocumentCollection::TryGetBestIndex(const std::string& columnName,
                                          IndexConstraintOperator op,
                                          IndexStat& indexStat) {
   return m_indexManager->TryGetBestIndex(columnName, op, indexStat);
 }
 
+bool DocumentCollection::TryGetBestCompositeIndex(
+    const std::vector<Constraint>& constraints, IndexStat& indexStat,
+    std::vector<std::size_t>& coveredConstraints, double& selectivity) {
+  return m_indexManager->TryGetBestCompositeIndex(constraints, indexStat,
+                                                  coveredConstraints,
+                                                  selectivity);
+}
+
+bool DocumentCollection::TryGetValueBitmaps(
+    const std::string& columnName, std::vector<ValueBitmap>& valueBitmaps) {
+  return m_indexManager->TryGetValueBitmaps(columnName, valueBitmaps);
+}
+
+bool DocumentCollection::TryGetOrderedIndex(const std::string& columnName,
+                                            IndexStat& indexStat) {
+  return m_indexManager->TryGetOrderedIndex(columnName, indexStat);
+}
+
+bool DocumentCollection::TryGetOrderedBitmaps(
+    const std::string& columnName,
+    std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) {
+  return m_indexManager->TryGetOrderedBitmaps(columnName, bitmaps);
+}
+
 std::shared_ptr<MamaJenniesBitmap> DocumentCollection::Filter(const std::vector<
     Constraint>& constraints) {
+  ThrowIfIndexesAreInvalid();
   if (constraints.size() > 0) {
     return m_indexManager->Filter(constraints);
   } else {
-    // Return all the ids
-    auto lastID = m_documentIDMap.size();
-    auto bm = std::make_shared<MamaJenniesBitmap>();
-    for (std::size_t i = 0; i < lastID; i++) {
-      bm->Add(i);
-    }
+    // Return all the ids as a single run, nothing is materialized per id.
+    // Documents of a bulk load in progress are not indexed yet and are left
+    // out like they are by the indexes.
+    return MamaJenniesBitmap::CreateRange(m_indexedDocumentCount);
+  }
+}
 
-    return bm;
+bool DocumentCollection::TryGetDocumentByKey(const Constraint& key,
+                                             BufferImpl& buffer) const {
+  std::uint64_t docID;
+  if (!m_indexManager->TryGetDocumentID(key, docID)) {
+    return false;
   }
+
+  m_blobManager->Get(m_documentIDMap.at(docID), buffer);
+  return true;
 }
 
 void DocumentCollection::GetDocumentAndBuffer(
@@ -339,8 +673,14 @@ void DocumentCollection::PopulateColumnTypes(
     const DocumentSchema& documentSchema,
     std::unordered_map<string, FieldType>& columnTypes) {
   for (std::size_t i = 0; i < indexes.size(); i++) {
-    columnTypes.insert(
-        pair<string, FieldType>(indexes[i]->GetColumnName(),
-                                documentSchema.GetFieldType(indexes[i]->GetColumnName())));
+    // Composite indexes list several columns
+    auto columnNames = CompositeIndexer::IsComposite(*indexes[i]) ?
+        CompositeIndexer::GetColumnNames(indexes[i]->GetColumnName()) :
+        std::vector<std::string>{indexes[i]->GetColumnName()};
+    for (auto& columnName : columnNames) {
+      columnTypes.insert(
+          pair<string, FieldType>(columnName,
+                                  documentSchema.GetFieldType(columnName)));
+    }
   }
 }
@@ -11,6 +11,13 @@ DocumentCollectionDictionary* DocumentCollectionDictionary::Instance() {
   return instance;
 }
 
+std::string DocumentCollectionDictionary::GetKey(
+    const std::string& dbName, const std::string& collectionName) {
+  std::string key("'");
+  key.append(dbName).append(">").append(collectionName).append("'");
+  return key;
+}
+
 void DocumentCollectionDictionary::Insert(const std::string& key,
                                           const std::shared_ptr<
                                               DocumentCollectionInfo>& collection) {
@@ -10,3 +10,7 @@ DocumentIDGenerator::DocumentIDGenerator()
 std::uint64_t DocumentIDGenerator::ReserveID(uint32_t numOfIDsToReserve) {
   return m_currentID.fetch_add(numOfIDsToReserve);
 }
+
+std::uint64_t DocumentIDGenerator::GetReservedIDCount() const {
+  return m_currentID.load() - DOC_ID_START;
+}
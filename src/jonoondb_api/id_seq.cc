@@ -4,11 +4,20 @@ using namespace jonoondb_api;
 using namespace gsl;
 
 IDSequence::IDSequence(std::shared_ptr<MamaJenniesBitmap> bitmap, int vecSize) :
-    m_bitmap(move(bitmap)) {
+    m_bitmap(move(bitmap)), m_decoder(*m_bitmap) {
+  m_currentVector.resize(vecSize);
+  m_currentSpan = span<std::uint64_t>(m_currentVector.data(), 0);
+}
+
+IDSequence::IDSequence(
+    std::shared_ptr<MamaJenniesBitmap> filter,
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> orderedBitmaps,
+    bool descending, int vecSize) :
+    m_bitmap(std::make_shared<MamaJenniesBitmap>()), m_decoder(*m_bitmap),
+    m_filter(move(filter)), m_orderedBitmaps(move(orderedBitmaps)),
+    m_descending(descending) {
   m_currentVector.resize(vecSize);
   m_currentSpan = span<std::uint64_t>(m_currentVector.data(), 0);
-  m_iter = m_bitmap->begin_pointer();
-  m_end = m_bitmap->end_pointer();
 }
 
 const span<std::uint64_t>& IDSequence::Current() {
@@ -16,18 +25,21 @@ const span<std::uint64_t>& IDSequence::Current() {
 }
 
 bool IDSequence::Next() {
-  if (*(m_iter) >= *(m_end)) {
-    m_currentSpan = span<std::uint64_t>(m_currentVector.data(), 0);
-    return false;
-  }
-
-  int index = 0;
-  while (index < m_currentVector.size() && *(m_iter) < *(m_end)) {
-    m_currentVector[index] = m_iter->operator*();
-    ++(*m_iter);
-    index++;
+  auto count = m_decoder.Decode(m_currentVector.data(),
+                                m_currentVector.size());
+  while (count == 0 && m_groupCount < m_orderedBitmaps.size()) {
+    auto index = m_descending ? m_orderedBitmaps.size() - 1 - m_groupCount
+                              : m_groupCount;
+    m_groupCount++;
+    // The group is a new bitmap so later inserts into the index cannot
+    // change it while it is decoded
+    auto group = std::make_shared<MamaJenniesBitmap>();
+    m_orderedBitmaps[index]->LogicalAND(*m_filter, *group);
+    m_bitmap = move(group);
+    m_decoder = MamaJenniesBitmapDecoder(*m_bitmap);
+    count = m_decoder.Decode(m_currentVector.data(), m_currentVector.size());
   }
 
-  m_currentSpan = span<std::uint64_t>(m_currentVector.data(), index);
-  return true;
+  m_currentSpan = span<std::uint64_t>(m_currentVector.data(), count);
+  return count > 0;
 }
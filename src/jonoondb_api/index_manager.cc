@@ -1,6 +1,8 @@
 #include <memory>
 #include <assert.h>
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 #include "index_manager.h"
 #include "document.h"
 #include "indexer.h"
@@ -11,6 +13,7 @@
 #include "mama_jennies_bitmap.h"
 #include "document_id_generator.h"
 #include "buffer_impl.h"
+#include "composite_indexer.h"
 
 using namespace std;
 using namespace jonoondb_api;
@@ -18,42 +21,145 @@ using namespace jonoondb_api;
 IndexManager::IndexManager(const std::vector<IndexInfoImpl*>& indexes,
                            const std::unordered_map<std::string,
                                                     FieldType>& columnTypes) :
-    m_columnIndexerMap(new ColumnIndexderMap()) {
+    m_columnIndexerMap(new ColumnIndexderMap()), m_hasBuiltIndexers(false),
+    m_documentCount(0), m_filterCache(FILTER_CACHE_SIZE) {
   for (size_t i = 0; i < indexes.size(); i++) {
-    auto it = columnTypes.find(indexes[i]->GetColumnName());
+    AddIndexer(CreateIndexer(*indexes[i], columnTypes));
+  }
+}
+
+void IndexManager::CreateIndex(const IndexInfoImpl& indexInfo,
+                               const std::unordered_map<std::string,
+                                                        FieldType>& columnTypes) {
+  auto indexer = CreateIndexer(indexInfo, columnTypes);
+  boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+  AddIndexer(std::move(indexer));
+}
+
+std::unique_ptr<Indexer> IndexManager::CreateIndexer(
+    const IndexInfoImpl& indexInfo,
+    const std::unordered_map<std::string, FieldType>& columnTypes) {
+  auto columnNames = CompositeIndexer::IsComposite(indexInfo) ?
+      CompositeIndexer::GetColumnNames(indexInfo.GetColumnName()) :
+      std::vector<std::string>{indexInfo.GetColumnName()};
+  std::vector<FieldType> fieldTypes;
+  for (auto& columnName : columnNames) {
+    auto it = columnTypes.find(columnName);
     if (it == columnTypes.end()) {
       ostringstream ss;
-      ss << "The field type for " << indexes[i]->GetColumnName()
+      ss << "The field type for " << columnName
           << " could not be determined.";
       throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
     }
-    unique_ptr<Indexer>
-        indexer(IndexerFactory::CreateIndexer(*indexes[i], it->second));
-    (*m_columnIndexerMap)[indexes[i]->GetColumnName()].push_back(move(indexer));
+    fieldTypes.push_back(it->second);
+  }
+
+  if (CompositeIndexer::IsComposite(indexInfo)) {
+    return unique_ptr<Indexer>(
+        IndexerFactory::CreateCompositeIndexer(indexInfo, fieldTypes));
   }
+  return unique_ptr<Indexer>(
+      IndexerFactory::CreateIndexer(indexInfo, fieldTypes[0]));
 }
 
-void IndexManager::CreateIndex(const IndexInfoImpl& indexInfo,
-                               const std::unordered_map<std::string,
-                                                        FieldType>& columnTypes) {
-  auto it = columnTypes.find(indexInfo.GetColumnName());
-  if (it == columnTypes.end()) {
-    ostringstream ss;
-    ss << "The field type for " << indexInfo.GetColumnName()
-        << " could not be determined.";
-    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+void IndexManager::AddIndexer(std::unique_ptr<Indexer> indexer) {
+  auto& indexInfo = indexer->GetIndexStats().GetIndexInfo();
+  if (CompositeIndexer::IsComposite(indexInfo)) {
+    m_compositeIndexers.push_back(
+        static_cast<CompositeIndexer*>(indexer.get()));
   }
-  unique_ptr<Indexer>
-      indexer(IndexerFactory::CreateIndexer(indexInfo, it->second));
   (*m_columnIndexerMap)[indexInfo.GetColumnName()].push_back(move(indexer));
 }
 
+bool IndexManager::TryAddBuiltIndexer(
+    std::unique_ptr<Indexer>& indexer, std::uint64_t documentCount,
+    const DocumentIDGenerator& documentIDGenerator) {
+  boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+  // IndexDocuments reserves the ids under m_mutex, so no document can be
+  // indexed without this indexer once the check passes
+  if (documentIDGenerator.GetReservedIDCount() != documentCount) {
+    return false;
+  }
+
+  indexer->FinalizeBulkInsert();
+  m_builtIndexers.push_back(std::move(indexer));
+  m_hasBuiltIndexers = true;
+  return true;
+}
+
+void IndexManager::AddBuiltIndexers() {
+  if (m_hasBuiltIndexers) {
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+    AddBuiltIndexersUnlocked();
+  }
+}
+
+void IndexManager::AddBuiltIndexersUnlocked() {
+  for (auto& indexer : m_builtIndexers) {
+    AddIndexer(std::move(indexer));
+  }
+  m_builtIndexers.clear();
+  m_hasBuiltIndexers = false;
+}
+
+bool IndexManager::HasIndex(const std::string& indexName) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  for (const auto& columnIndexerMapPair : *m_columnIndexerMap) {
+    for (const auto& indexer : columnIndexerMapPair.second) {
+      if (indexer->GetIndexStats().GetIndexInfo().GetIndexName() ==
+          indexName) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool IndexManager::TryDropIndex(const std::string& indexName) {
+  boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+  AddBuiltIndexersUnlocked();
+  for (auto mapIter = m_columnIndexerMap->begin();
+       mapIter != m_columnIndexerMap->end(); ++mapIter) {
+    auto& indexers = mapIter->second;
+    for (auto iter = indexers.begin(); iter != indexers.end(); ++iter) {
+      if ((*iter)->GetIndexStats().GetIndexInfo().GetIndexName() !=
+          indexName) {
+        continue;
+      }
+
+      m_compositeIndexers.erase(
+          std::remove(m_compositeIndexers.begin(), m_compositeIndexers.end(),
+                      iter->get()), m_compositeIndexers.end());
+      indexers.erase(iter);
+      if (indexers.empty()) {
+        m_columnIndexerMap->erase(mapIter);
+      }
+      // Filters on the column may not be possible anymore
+      m_filterCache.Clear();
+      return true;
+    }
+  }
+
+  return false;
+}
+
 std::uint64_t IndexManager::IndexDocuments(DocumentIDGenerator& documentIDGenerator,
                                            const std::vector<std::unique_ptr<
                                                Document>>& documents) {
   std::uint64_t startID = 0;
   {
-    std::unique_lock<std::mutex> lock(m_mutex);
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+    AddBuiltIndexersUnlocked();
+    // Validate before reserving the ids so that a failure leaves the
+    // collection untouched
+    for (const auto& columnIndexerMapPair : *m_columnIndexerMap) {
+      for (const auto& indexer : columnIndexerMapPair.second) {
+        indexer->ValidateForIndexing(documents);
+      }
+    }
+
     startID = documentIDGenerator.ReserveID(documents.size());
     auto documentID = startID;
     for (const auto& doc : documents) {
@@ -64,40 +170,279 @@ std::uint64_t IndexManager::IndexDocuments(DocumentIDGenerator& documentIDGenera
       }
       ++documentID;
     }
+    m_documentCount = documentID;
   }
 
   return startID;
 }
 
+void IndexManager::BulkIndexDocuments(std::uint64_t startID,
+                                      const std::vector<std::unique_ptr<
+                                          Document>>& documents) {
+  boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+  AddBuiltIndexersUnlocked();
+  for (const auto& columnIndexerMapPair : *m_columnIndexerMap) {
+    for (const auto& indexer : columnIndexerMapPair.second) {
+      indexer->BulkInsert(startID, documents);
+    }
+  }
+  m_bulkDocumentCount =
+      std::max<std::uint64_t>(m_bulkDocumentCount, startID + documents.size());
+}
+
+void IndexManager::FinalizeBulkIndexing() {
+  boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+  for (const auto& columnIndexerMapPair : *m_columnIndexerMap) {
+    for (const auto& indexer : columnIndexerMapPair.second) {
+      indexer->FinalizeBulkInsert();
+    }
+  }
+  // The staged documents are queryable from now on
+  m_documentCount = std::max<std::uint64_t>(m_documentCount,
+                                            m_bulkDocumentCount);
+}
+
 bool IndexManager::TryGetBestIndex(const std::string& columnName,
                                    IndexConstraintOperator op,
                                    IndexStat& indexStat) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter == m_columnIndexerMap->end()) {
     return false;
   }
 
   // see if the operators are supported
-  if (op == IndexConstraintOperator::GLOB ||
-      op == IndexConstraintOperator::LIKE ||
-      op == IndexConstraintOperator::MATCH ||
-      op == IndexConstraintOperator::REGEX) {
+  if (op == IndexConstraintOperator::REGEX) {
     // These operators are not yet supported by indexers
     // As these will be supported, we will update this check
     return false;
   }
 
   assert(columnIndexerIter->second.size() > 0);
-  // Todo: When we have different kinds of indexes, 
-  // Add the logic to select the best index for the column  
-  indexStat = columnIndexerIter->second[0]->GetIndexStats();
+  auto indexer = GetBestIndexer(columnIndexerIter->second, op);
+  if (indexer == nullptr) {
+    return false;
+  }
+
+  indexStat = indexer->GetIndexStats();
+  return true;
+}
+
+std::vector<std::size_t>
+IndexManager::CompositeMatch::GetCoveredConstraints() const {
+  auto covered = equalConstraints;
+  if (lowerConstraint != NO_CONSTRAINT) {
+    covered.push_back(lowerConstraint);
+  }
+  if (upperConstraint != NO_CONSTRAINT) {
+    covered.push_back(upperConstraint);
+  }
+  return covered;
+}
+
+bool IndexManager::HasIndexer(const std::string& columnName,
+                              IndexConstraintOperator op) {
+  auto columnIndexerIter = m_columnIndexerMap->find(columnName);
+  return columnIndexerIter != m_columnIndexerMap->end() &&
+      GetBestIndexer(columnIndexerIter->second, op) != nullptr;
+}
+
+CompositeIndexer* IndexManager::GetBestCompositeIndexer(
+    const std::vector<Constraint>& constraints, CompositeMatch& match) {
+  auto isLower = [](IndexConstraintOperator op) {
+    return op == IndexConstraintOperator::GREATER_THAN ||
+        op == IndexConstraintOperator::GREATER_THAN_EQUAL;
+  };
+  auto isUpper = [](IndexConstraintOperator op) {
+    return op == IndexConstraintOperator::LESS_THAN ||
+        op == IndexConstraintOperator::LESS_THAN_EQUAL;
+  };
+
+  CompositeIndexer* bestIndexer = nullptr;
+  std::size_t bestCount = 0;
+  for (auto indexer : m_compositeIndexers) {
+    CompositeMatch currentMatch;
+    auto& columnNames = indexer->GetColumnNames();
+    for (auto& columnName : columnNames) {
+      auto iter = std::find_if(
+          constraints.begin(), constraints.end(),
+          [&columnName](const Constraint& constraint) {
+            return constraint.columnName == columnName &&
+                constraint.op == IndexConstraintOperator::EQUAL;
+          });
+      if (iter == constraints.end()) {
+        break;
+      }
+      currentMatch.equalConstraints.push_back(iter - constraints.begin());
+    }
+
+    auto equalCount = currentMatch.equalConstraints.size();
+    if (equalCount < indexer->GetMinEqualityCount()) {
+      continue;
+    }
+
+    if (equalCount < columnNames.size() && indexer->SupportsRange()) {
+      for (std::size_t i = 0; i < constraints.size(); i++) {
+        if (constraints[i].columnName != columnNames[equalCount]) {
+          continue;
+        }
+        if (isLower(constraints[i].op) &&
+            currentMatch.lowerConstraint == NO_CONSTRAINT) {
+          currentMatch.lowerConstraint = i;
+        } else if (isUpper(constraints[i].op) &&
+            currentMatch.upperConstraint == NO_CONSTRAINT) {
+          currentMatch.upperConstraint = i;
+        }
+      }
+    }
+
+    // A single constraint is left to the index of its column if there is one
+    auto covered = currentMatch.GetCoveredConstraints();
+    if (covered.empty() || (covered.size() == 1 &&
+        HasIndexer(constraints[covered[0]].columnName,
+                   constraints[covered[0]].op))) {
+      continue;
+    }
+
+    if (covered.size() > bestCount) {
+      bestIndexer = indexer;
+      bestCount = covered.size();
+      match = currentMatch;
+    }
+  }
+
+  return bestIndexer;
+}
+
+bool IndexManager::TryGetBestCompositeIndex(
+    const std::vector<Constraint>& constraints, IndexStat& indexStat,
+    std::vector<std::size_t>& coveredConstraints, double& selectivity) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  CompositeMatch match;
+  auto indexer = GetBestCompositeIndexer(constraints, match);
+  if (indexer == nullptr) {
+    return false;
+  }
+
+  indexStat = indexer->GetIndexStats();
+  coveredConstraints = match.GetCoveredConstraints();
+  // The statistics are kept for the whole key, the selectivity of an
+  // equality on a prefix of the columns is interpolated geometrically
+  auto& statistics = indexStat.GetStatistics();
+  auto columnCount = indexer->GetColumnNames().size();
+  selectivity = std::pow(
+      statistics.EstimateSelectivity(IndexConstraintOperator::EQUAL),
+      static_cast<double>(match.equalConstraints.size()) / columnCount);
+  for (auto i : {match.lowerConstraint, match.upperConstraint}) {
+    if (i != NO_CONSTRAINT) {
+      selectivity *= statistics.EstimateSelectivity(constraints[i].op);
+    }
+  }
+
   return true;
 }
 
 std::shared_ptr<MamaJenniesBitmap> IndexManager::Filter(const std::vector<
     Constraint>& constraints) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  std::uint64_t documentCount = m_documentCount;
+  auto key = GetFilterCacheKey(constraints);
+  std::shared_ptr<FilterCacheEntry> entry;
+  if (m_filterCache.Find(key, entry)) {
+    if (entry->documentCount == documentCount) {
+      return entry->bitmap;
+    }
+
+    // The documents the cached result was computed from have not changed,
+    // only the new ones have to be filtered. The cached bitmap may be in
+    // use by a cursor so the result is a new bitmap.
+    auto delta = FilterFrom(constraints, entry->documentCount);
+    auto bitmap = std::make_shared<MamaJenniesBitmap>();
+    entry->bitmap->LogicalOR(*delta, *bitmap);
+    m_filterCache.Add(key, std::make_shared<FilterCacheEntry>(
+        FilterCacheEntry{bitmap, documentCount}), true);
+    return bitmap;
+  }
+
+  auto bitmap = FilterFrom(constraints, 0);
+  m_filterCache.Add(key, std::make_shared<FilterCacheEntry>(
+      FilterCacheEntry{bitmap, documentCount}), true);
+  m_filterCache.PerformEviction();
+  return bitmap;
+}
+
+std::string IndexManager::GetFilterCacheKey(
+    const std::vector<Constraint>& constraints) {
+  std::vector<std::string> keys;
+  for (auto& constraint : constraints) {
+    std::ostringstream ss;
+    ss << constraint.columnName << '\0'
+        << static_cast<std::int32_t>(constraint.op) << ','
+        << static_cast<std::int32_t>(constraint.operandType) << ',';
+    switch (constraint.operandType) {
+      case OperandType::INTEGER:
+        ss << constraint.operand.int64Val;
+        break;
+      case OperandType::DOUBLE:
+        // The bits identify the value exactly
+        ss << std::hex << constraint.operand.int64Val;
+        break;
+      case OperandType::STRING:
+        ss << constraint.strVal;
+        break;
+      default:
+        ss.write(constraint.blobVal.GetData(), constraint.blobVal.GetLength());
+        break;
+    }
+    keys.push_back(ss.str());
+  }
+
+  std::sort(keys.begin(), keys.end());
+  std::string key;
+  for (auto& constraintKey : keys) {
+    // The length prefix keeps the keys of different sets apart
+    key += std::to_string(constraintKey.size());
+    key += ':';
+    key += constraintKey;
+  }
+  return key;
+}
+
+std::shared_ptr<MamaJenniesBitmap> IndexManager::FilterFrom(
+    const std::vector<Constraint>& constraints, std::uint64_t startID) {
   std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+  std::vector<bool> isCovered(constraints.size(), false);
+  CompositeMatch match;
+  auto compositeIndexer = GetBestCompositeIndexer(constraints, match);
+  if (compositeIndexer != nullptr) {
+    std::vector<const Constraint*> equalConstraints;
+    for (auto i : match.equalConstraints) {
+      equalConstraints.push_back(&constraints[i]);
+    }
+    for (auto i : match.GetCoveredConstraints()) {
+      isCovered[i] = true;
+    }
+
+    auto bm = compositeIndexer->FilterComposite(
+        equalConstraints,
+        match.lowerConstraint == NO_CONSTRAINT ? nullptr :
+            &constraints[match.lowerConstraint],
+        match.upperConstraint == NO_CONSTRAINT ? nullptr :
+            &constraints[match.upperConstraint]);
+    if (bm->IsEmpty()) {
+      return bm;
+    }
+    bitmaps.push_back(bm);
+  }
+
   for (std::size_t i = 0; i < constraints.size(); i++) {
+    if (isCovered[i]) {
+      continue;
+    }
+
     auto
         columnIndexerIter = m_columnIndexerMap->find(constraints[i].columnName);
     if (columnIndexerIter == m_columnIndexerMap->end()) {
@@ -107,45 +452,198 @@ std::shared_ptr<MamaJenniesBitmap> IndexManager::Filter(const std::vector<
           << " because no indexes exist on this field.";
       throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
     }
-    // Todo: When we have different kinds of indexes, 
-    // Add the logic to select the best index for the column  
 
     // First lets see if we have range condition e.g. val > 10 AND val < 20
     // We look for adjacent constraints if they are on the same column and are
     // representing a range then we use FilterRange func instead which is more
-    // optimized.    
-    if (i + 1 < constraints.size()
+    // optimized.
+    bool isRange = i + 1 < constraints.size() && !isCovered[i + 1]
         && constraints[i].columnName == constraints[i + 1].columnName &&
         (constraints[i].op == IndexConstraintOperator::GREATER_THAN
             || constraints[i].op == IndexConstraintOperator::GREATER_THAN_EQUAL)
         &&
             (constraints[i + 1].op == IndexConstraintOperator::LESS_THAN
                 || constraints[i + 1].op
-                    == IndexConstraintOperator::LESS_THAN_EQUAL)) {
-      auto bm = columnIndexerIter->second[0]->FilterRange(constraints[i],
-                                                          constraints[i + 1]);
-      bitmaps.push_back(bm);
+                    == IndexConstraintOperator::LESS_THAN_EQUAL);
+    auto indexer = GetBestIndexer(columnIndexerIter->second,
+                                  constraints[i].op, &constraints[i],
+                                  isRange ? &constraints[i + 1] : nullptr);
+    if (indexer == nullptr) {
+      std::ostringstream ss;
+      ss << "Cannot apply filter operation on field "
+          << constraints[i].columnName
+          << " because no index on this field supports the operator.";
+      throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+    }
+
+    std::shared_ptr<MamaJenniesBitmap> bm;
+    if (isRange) {
+      bm = indexer->FilterRangeFrom(constraints[i], constraints[i + 1],
+                                    startID);
       i++; // advance i because we have processed 2 constraints
     } else {
-      // Todo: Uncomment the code below which is an optimization.
-      // But first we need a fast way to check if bitmap is empty.
-      /*if (bm->IsEmpty()) {
-      // no need to proceed further as the AND opaeration will yield
+      bm = indexer->FilterFrom(constraints[i], startID);
+    }
+
+    if (bm->IsEmpty()) {
+      // no need to proceed further as the AND operation will yield
       // an empty bitmap in the end
-      bitmaps.clear();
-      break;
-      }*/
-      auto bm = columnIndexerIter->second[0]->Filter(constraints[i]);
-      bitmaps.push_back(bm);
+      return bm;
     }
+    bitmaps.push_back(bm);
   }
 
   return MamaJenniesBitmap::LogicalAND(bitmaps);
 }
 
+// Returns how well an index type can serve the operator, higher is better.
+// -1 means the operator cannot be served by the index type. Indexers that
+// can serve the operator are compared by IndexStat::EstimateCost first.
+static int GetIndexerRank(IndexType type, FieldType fieldType,
+                          IndexConstraintOperator op) {
+  // Trigram indexes narrow LIKE and GLOB down with every literal of the
+  // pattern. The other string indexes scan the range of the pattern prefix:
+  // a sorted map visits each distinct value once, sorted indexes visit each
+  // entry and vector indexes scan all documents.
+  if (op == IndexConstraintOperator::LIKE ||
+      op == IndexConstraintOperator::GLOB) {
+    if (fieldType != FieldType::BASE_TYPE_STRING) {
+      return -1;
+    }
+
+    switch (type) {
+      case IndexType::TRIGRAM:
+        return 4;
+      case IndexType::EWAH_COMPRESSED_BITMAP:
+        return 3;
+      case IndexType::SORTED:
+        return 2;
+      case IndexType::VECTOR:
+        return 1;
+      default:
+        return -1;
+    }
+  }
+
+  // MATCH is only understood by full-text indexes
+  if (op == IndexConstraintOperator::MATCH) {
+    return type == IndexType::FULL_TEXT ? 1 : -1;
+  }
+
+  if (type == IndexType::TRIGRAM || type == IndexType::FULL_TEXT) {
+    return -1;
+  }
+
+  if (op == IndexConstraintOperator::EQUAL) {
+    switch (type) {
+      case IndexType::HASH:
+      case IndexType::UNIQUE_HASH:
+        return 3;
+      case IndexType::VECTOR:
+        return 0;
+      case IndexType::BIT_SLICED:
+        return 1;
+      default:
+        return 2;
+    }
+  }
+
+  // Range predicates are answered with a fixed number of bitmap operations
+  // by bit-sliced indexes and with binary searches by sorted indexes, other
+  // indexes need one bitmap per distinct value or a full scan
+  switch (type) {
+    case IndexType::BIT_SLICED:
+      return 3;
+    case IndexType::SORTED:
+      return 2;
+    case IndexType::HASH:
+    case IndexType::UNIQUE_HASH:
+      return -1;
+    default:
+      return 1;
+  }
+}
+
+Indexer* IndexManager::GetBestIndexer(
+    const std::vector<std::unique_ptr<Indexer>>& indexers,
+    IndexConstraintOperator op, const Constraint* constraint,
+    const Constraint* upperConstraint) {
+  Indexer* bestIndexer = nullptr;
+  int bestRank = -1;
+  double bestCost = 0;
+  for (auto& indexer : indexers) {
+    auto& indexStat = indexer->GetIndexStats();
+    auto rank = GetIndexerRank(indexStat.GetIndexInfo().GetType(),
+                               indexStat.GetFieldType(), op);
+    if (rank < 0) {
+      continue;
+    }
+
+    auto& statistics = indexStat.GetStatistics();
+    double selectivity;
+    if (constraint == nullptr) {
+      selectivity = statistics.EstimateSelectivity(op);
+    } else if (upperConstraint == nullptr) {
+      selectivity = statistics.EstimateSelectivity(*constraint);
+    } else {
+      selectivity = statistics.EstimateSelectivity(*constraint,
+                                                   *upperConstraint);
+    }
+
+    // The rank breaks ties e.g. when the collection is empty
+    auto cost = indexStat.EstimateCost(op, selectivity);
+    if (bestIndexer == nullptr || cost < bestCost ||
+        (cost == bestCost && rank > bestRank)) {
+      bestIndexer = indexer.get();
+      bestRank = rank;
+      bestCost = cost;
+    }
+  }
+
+  return bestIndexer;
+}
+
+bool IndexManager::TryGetDocumentID(const Constraint& constraint,
+                                    std::uint64_t& documentID) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  auto columnIndexerIter = m_columnIndexerMap->find(constraint.columnName);
+  if (columnIndexerIter == m_columnIndexerMap->end()) {
+    std::ostringstream ss;
+    ss << "Cannot lookup document by field " << constraint.columnName
+        << " because no indexes exist on this field.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  auto indexer = GetBestIndexer(columnIndexerIter->second,
+                                IndexConstraintOperator::EQUAL);
+  if (indexer == nullptr) {
+    std::ostringstream ss;
+    ss << "Cannot lookup document by field " << constraint.columnName
+        << " because no index on this field supports equality lookups.";
+    throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+  }
+
+  return indexer->TryGetDocumentID(constraint, documentID);
+}
+
+bool IndexManager::HasUniqueIndex() {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  for (const auto& columnIndexerMapPair : *m_columnIndexerMap) {
+    for (const auto& indexer : columnIndexerMapPair.second) {
+      if (indexer->GetIndexStats().GetIndexInfo().GetType()
+          == IndexType::UNIQUE_HASH) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 bool IndexManager::TryGetIntegerValue(std::uint64_t documentID,
                                       const std::string& columnName,
                                       std::int64_t& val) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -162,6 +660,7 @@ bool IndexManager::TryGetIntegerValue(std::uint64_t documentID,
 bool IndexManager::TryGetDoubleValue(std::uint64_t documentID,
                                      const std::string& columnName,
                                      double& val) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -178,6 +677,7 @@ bool IndexManager::TryGetDoubleValue(std::uint64_t documentID,
 bool IndexManager::TryGetStringValue(
     std::uint64_t documentID, const std::string& columnName,
     std::string& val) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -194,6 +694,7 @@ bool IndexManager::TryGetStringValue(
 bool IndexManager::TryGetBlobValue(
   std::uint64_t documentID, const std::string& columnName,
   BufferImpl& val) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -211,6 +712,7 @@ bool IndexManager::TryGetIntegerVector(
     const gsl::span<std::uint64_t>& documentIDs,
     const std::string& columnName,
     std::vector<std::int64_t>& values) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -228,6 +730,7 @@ bool IndexManager::TryGetDoubleVector(
     const gsl::span<std::uint64_t>& documentIDs,
     const std::string& columnName,
     std::vector<double>& values) {
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
   auto columnIndexerIter = m_columnIndexerMap->find(columnName);
   if (columnIndexerIter != m_columnIndexerMap->end()) {
     for (auto& indexer : columnIndexerIter->second) {
@@ -240,3 +743,65 @@ bool IndexManager::TryGetDoubleVector(
 
   return false;
 }
+
+bool IndexManager::TryGetValueBitmaps(const std::string& columnName,
+                                      std::vector<ValueBitmap>& valueBitmaps) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  auto columnIndexerIter = m_columnIndexerMap->find(columnName);
+  if (columnIndexerIter != m_columnIndexerMap->end()) {
+    for (auto& indexer : columnIndexerIter->second) {
+      if (indexer->TryGetValueBitmaps(valueBitmaps)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// Indexes that keep a bitmap per value in a sorted map can visit the
+// documents in value order
+static bool SupportsOrderedScan(IndexType type, FieldType fieldType) {
+  return type == IndexType::EWAH_COMPRESSED_BITMAP &&
+      fieldType != FieldType::BASE_TYPE_BLOB;
+}
+
+bool IndexManager::TryGetOrderedIndex(const std::string& columnName,
+                                      IndexStat& indexStat) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  auto columnIndexerIter = m_columnIndexerMap->find(columnName);
+  if (columnIndexerIter != m_columnIndexerMap->end()) {
+    for (auto& indexer : columnIndexerIter->second) {
+      auto& stat = indexer->GetIndexStats();
+      if (SupportsOrderedScan(stat.GetIndexInfo().GetType(),
+                              stat.GetFieldType())) {
+        indexStat = stat;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool IndexManager::TryGetOrderedBitmaps(
+    const std::string& columnName,
+    std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) {
+  AddBuiltIndexers();
+  boost::shared_lock<boost::shared_mutex> lock(m_mutex);
+  auto columnIndexerIter = m_columnIndexerMap->find(columnName);
+  if (columnIndexerIter != m_columnIndexerMap->end()) {
+    for (auto& indexer : columnIndexerIter->second) {
+      auto& stat = indexer->GetIndexStats();
+      if (SupportsOrderedScan(stat.GetIndexInfo().GetType(),
+                              stat.GetFieldType()) &&
+          indexer->TryGetOrderedBitmaps(bitmaps)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
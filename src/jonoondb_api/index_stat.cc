@@ -1,13 +1,17 @@
+#include <cmath>
+#include <algorithm>
 #include "index_stat.h"
 #include "enums.h"
 
 using namespace jonoondb_api;
 
-IndexStat::IndexStat() : m_fieldType(FieldType::BASE_TYPE_INT32) {
+IndexStat::IndexStat() : m_fieldType(FieldType::BASE_TYPE_INT32),
+    m_statistics(std::make_shared<ColumnStatistics>()) {
 }
 
 IndexStat::IndexStat(const IndexInfoImpl& indexInfo, FieldType fieldType) :
-    m_indexInfo(indexInfo), m_fieldType(fieldType) {
+    m_indexInfo(indexInfo), m_fieldType(fieldType),
+    m_statistics(std::make_shared<ColumnStatistics>()) {
 }
 
 const IndexInfoImpl& IndexStat::GetIndexInfo() const {
@@ -16,4 +20,61 @@ const IndexInfoImpl& IndexStat::GetIndexInfo() const {
 
 FieldType IndexStat::GetFieldType() const {
   return m_fieldType;
-}
\ No newline at end of file
+}
+
+ColumnStatistics& IndexStat::GetStatistics() {
+  return *m_statistics;
+}
+
+const ColumnStatistics& IndexStat::GetStatistics() const {
+  return *m_statistics;
+}
+
+double IndexStat::EstimateCost(IndexConstraintOperator op,
+                               double selectivity) const {
+  auto documentCount = static_cast<double>(
+      std::max<std::uint64_t>(m_statistics->GetDocumentCount(), 1));
+  auto distinctCount = static_cast<double>(
+      std::max<std::uint64_t>(m_statistics->GetDistinctCount(), 1));
+  auto rowCount = selectivity * documentCount;
+  // Building the result bitmap costs about one operation per 64 documents
+  auto resultCost = rowCount / 64;
+
+  switch (m_indexInfo.GetType()) {
+    case IndexType::HASH:
+    case IndexType::UNIQUE_HASH:
+      return 1 + resultCost;
+    case IndexType::EWAH_COMPRESSED_BITMAP: {
+      // A map lookup plus one bitmap per distinct value in the range
+      auto lookupCost = std::log2(distinctCount + 1);
+      if (op == IndexConstraintOperator::EQUAL) {
+        return lookupCost + resultCost;
+      }
+      return lookupCost + distinctCount * selectivity + resultCost;
+    }
+    case IndexType::SORTED: {
+      // Binary searches in the segments plus sorting the documentIDs
+      auto lookupCost = std::log2(documentCount + 1);
+      return lookupCost * lookupCost + rowCount * std::log2(rowCount + 2) / 8;
+    }
+    case IndexType::BIT_SLICED:
+      // Bitmap operations on every slice, compressed slices help
+      return documentCount / 8;
+    case IndexType::VECTOR: {
+      // SIMD scan of the column
+      auto scanCost = documentCount / 4;
+      if (op == IndexConstraintOperator::LIKE ||
+          op == IndexConstraintOperator::GLOB) {
+        return scanCost + distinctCount;
+      }
+      return scanCost;
+    }
+    case IndexType::TRIGRAM:
+      // Posting list intersection plus verifying the candidates
+      return 8 * std::log2(documentCount + 1) + rowCount;
+    case IndexType::FULL_TEXT:
+      return 8 * std::log2(documentCount + 1) + resultCost;
+    default:
+      return documentCount;
+  }
+}
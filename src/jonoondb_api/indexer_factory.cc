@@ -11,6 +11,12 @@
 #include "jonoondb_api/vector_double_indexer.h"
 #include "jonoondb_api/vector_string_indexer.h"
 #include "jonoondb_api/vector_blob_indexer.h"
+#include "jonoondb_api/bit_sliced_indexer.h"
+#include "jonoondb_api/sorted_indexer.h"
+#include "jonoondb_api/hash_indexer.h"
+#include "jonoondb_api/trigram_indexer.h"
+#include "jonoondb_api/full_text_indexer.h"
+#include "jonoondb_api/composite_indexer.h"
 
 using namespace std;
 using namespace jonoondb_api;
@@ -51,17 +57,50 @@ Indexer* IndexerFactory::CreateIndexer(
     case IndexType::VECTOR: {
       if (fieldType == FieldType::BASE_TYPE_STRING) {
         return new VectorStringIndexer(indexInfo, fieldType);
-      } else if (fieldType == FieldType::BASE_TYPE_DOUBLE ||
-          fieldType == FieldType::BASE_TYPE_FLOAT32) {
-        return new VectorDoubleIndexer(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_DOUBLE) {
+        return new VectorDoubleIndexer<double>(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_FLOAT32) {
+        return new VectorDoubleIndexer<float>(indexInfo, fieldType);
       } else if (fieldType == FieldType::BASE_TYPE_INT64) {
         return new VectorIntegerIndexer<std::int64_t>(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_INT16) {
+        return new VectorIntegerIndexer<std::int16_t>(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_INT8) {
+        return new VectorIntegerIndexer<std::int8_t>(indexInfo, fieldType);
       } else if (fieldType == FieldType::BASE_TYPE_BLOB) {
         return new VectorBlobIndexer(indexInfo, fieldType);
       } else {
         return new VectorIntegerIndexer<std::int32_t>(indexInfo, fieldType);
       }
     }
+    case IndexType::BIT_SLICED: {
+      return new BitSlicedIndexer(indexInfo, fieldType);
+    }
+    case IndexType::SORTED: {
+      if (fieldType == FieldType::BASE_TYPE_STRING) {
+        return new SortedIndexer<std::string>(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_DOUBLE ||
+          fieldType == FieldType::BASE_TYPE_FLOAT32) {
+        return new SortedIndexer<double>(indexInfo, fieldType);
+      } else {
+        return new SortedIndexer<std::int64_t>(indexInfo, fieldType);
+      }
+    }
+    case IndexType::HASH:
+    case IndexType::UNIQUE_HASH: {
+      if (fieldType == FieldType::BASE_TYPE_STRING) {
+        return new HashIndexer<std::string>(indexInfo, fieldType);
+      } else if (fieldType == FieldType::BASE_TYPE_DOUBLE ||
+          fieldType == FieldType::BASE_TYPE_FLOAT32) {
+        return new HashIndexer<double>(indexInfo, fieldType);
+      } else {
+        return new HashIndexer<std::int64_t>(indexInfo, fieldType);
+      }
+    }
+    case IndexType::TRIGRAM:
+      return new TrigramIndexer(indexInfo, fieldType);
+    case IndexType::FULL_TEXT:
+      return new FullTextIndexer(indexInfo, fieldType);
 
     default:
       std::ostringstream ss;
@@ -70,3 +109,9 @@ Indexer* IndexerFactory::CreateIndexer(
       throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
   }
 }
+
+CompositeIndexer* IndexerFactory::CreateCompositeIndexer(
+    const IndexInfoImpl& indexInfo,
+    const std::vector<FieldType>& fieldTypes) {
+  return new CompositeIndexer(indexInfo, fieldTypes);
+}
@@ -7,6 +7,8 @@
 #include <vector>
 #include <assert.h>
 #include <tuple>
+#include <algorithm>
+#include <limits>
 #include "sqlite3ext.h"
 #include "document_collection_dictionary.h"
 #include "document_collection.h"
@@ -27,6 +29,18 @@ using namespace jonoondb_api;
 SQLITE_EXTENSION_INIT1;
 
 const int VECTOR_SIZE = 100; 
+// Cost of fetching one document, in the unit of IndexStat::EstimateCost
+const double DOCUMENT_FETCH_COST = 10;
+// Cost of SQLite evaluating a constraint on a fetched document
+const double CONSTRAINT_EVALUATION_COST = 1;
+// Plans are enumerated for at most this many indexes, 2^n combinations
+const std::size_t MAX_ENUMERATED_PLAN_ITEMS = 10;
+// Flags in idxNum for scans that return the documents ordered by a column,
+// the column index follows the constraints in idxStr
+const int ORDER_BY_ASC_FLAG = 1 << 29;
+const int ORDER_BY_DESC_FLAG = 1 << 30;
+// Bits of idxNum that hold the length of the constraints in idxStr
+const int CONSTRAINTS_LENGTH_MASK = ORDER_BY_ASC_FLAG - 1;
 
 struct jonoondb_vtab {
   
@@ -179,12 +193,88 @@ static int jonoondb_destroy(sqlite3_vtab* vtab) {
   return SQLITE_OK;
 }
 
+// An index that answers some of the constraints of a query
+struct PlanItem {
+  // Positions of the constraints in the usable constraints
+  std::vector<std::size_t> constraints;
+  double selectivity = 1;
+  double cost = 0;
+  // The constraints have to be answered by the index
+  bool isRequired = false;
+  // The constraint matches at most one document
+  bool isUnique = false;
+};
+
+struct Plan {
+  std::vector<bool> isUsed;
+  double estimatedRows;
+  double cost;
+  bool isUnique;
+};
+
+// Returns the cheapest combination of the items. A constraint that is not
+// answered by an index is evaluated by SQLite on every returned document,
+// so an index only pays off if it removes enough document fetches to make
+// up for its own cost.
+static Plan ChoosePlan(const std::vector<PlanItem>& items,
+                       std::size_t constraintCount, double documentCount) {
+  Plan best;
+  best.cost = std::numeric_limits<double>::max();
+  // Beyond this many items every item is used instead of trying them all
+  auto itemCount = std::min(items.size(), MAX_ENUMERATED_PLAN_ITEMS);
+  for (std::size_t mask = 0; mask < (std::size_t(1) << itemCount); mask++) {
+    Plan plan;
+    plan.isUsed.assign(constraintCount, false);
+    plan.isUnique = false;
+    double selectivity = 1;
+    double indexCost = 0;
+    bool isValid = true;
+    for (std::size_t k = 0; k < items.size() && isValid; k++) {
+      if (k < itemCount && (mask & (std::size_t(1) << k)) == 0) {
+        isValid = !items[k].isRequired;
+        continue;
+      }
+
+      for (auto j : items[k].constraints) {
+        // Each constraint is answered by one index
+        isValid = isValid && !plan.isUsed[j];
+        plan.isUsed[j] = true;
+      }
+      selectivity *= items[k].selectivity;
+      indexCost += items[k].cost;
+      plan.isUnique = plan.isUnique || items[k].isUnique;
+    }
+    if (!isValid) {
+      continue;
+    }
+
+    auto residualCount = std::count(plan.isUsed.begin(), plan.isUsed.end(),
+                                    false);
+    plan.estimatedRows = documentCount * selectivity;
+    if (plan.isUnique) {
+      plan.estimatedRows = std::min(plan.estimatedRows, 1.0);
+    }
+    plan.cost = indexCost + plan.estimatedRows *
+        (DOCUMENT_FETCH_COST + residualCount * CONSTRAINT_EVALUATION_COST) + 1;
+    if (plan.cost < best.cost) {
+      best = std::move(plan);
+    }
+  }
+
+  return best;
+}
+
 static int jonoondb_bestindex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
   try {
     jonoondb_vtab* jdbVtab = reinterpret_cast<jonoondb_vtab*>(vtab);
     IndexStat indexStat;
     int argvIndex = 0;
     std::string sbuf;
+    auto documentCount = static_cast<double>(
+        jdbVtab->collectionInfo->collection->GetDocumentCount());
+    // Usable constraints and their positions in info->aConstraint
+    std::vector<Constraint> constraints;
+    std::vector<int> positions;
     for (int i = 0; i < info->nConstraint; i++) {
       if (info->aConstraint[i].usable) {
         if (info->aConstraint[i].iColumn == -1) {
@@ -193,20 +283,86 @@ static int jonoondb_bestindex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
           return SQLITE_ERROR;
         }
 
-        IndexConstraintOperator
-            op = MapSQLiteToJonoonDBOperator(info->aConstraint[i].op);
-        if (jdbVtab->collectionInfo->collection->TryGetBestIndex(
+        constraints.emplace_back(
             jdbVtab->collectionInfo->columnsInfo[info->aConstraint[i].iColumn].columnName,
-            op,
-            indexStat)) {
-          info->aConstraintUsage[i].argvIndex = ++argvIndex;
-          info->aConstraintUsage[i].omit = 1;
-          assert(sizeof(int) == sizeof(info->aConstraint[i].iColumn));
-          assert(sizeof(IndexConstraintOperator) == sizeof(op));
-          // type of info->aConstraint[i].iColumn is int
-          sbuf.append((char*) &info->aConstraint[i].iColumn, sizeof(int));
-          sbuf.append((char*) &op, sizeof(IndexConstraintOperator));
-        }
+            MapSQLiteToJonoonDBOperator(info->aConstraint[i].op));
+        positions.push_back(i);
+      }
+    }
+
+    // Every index that can answer some of the constraints is a plan item. A
+    // composite index answers several constraints with one lookup, the same
+    // constraints can also be answered by the indexes of their columns.
+    std::vector<PlanItem> items;
+    std::vector<std::size_t> coveredConstraints;
+    double compositeSelectivity;
+    if (jdbVtab->collectionInfo->collection->TryGetBestCompositeIndex(
+        constraints, indexStat, coveredConstraints, compositeSelectivity)) {
+      PlanItem item;
+      item.constraints = coveredConstraints;
+      item.selectivity = compositeSelectivity;
+      item.cost = indexStat.EstimateCost(IndexConstraintOperator::EQUAL,
+                                         compositeSelectivity);
+      items.push_back(std::move(item));
+    }
+
+    for (std::size_t j = 0; j < constraints.size(); j++) {
+      auto op = constraints[j].op;
+      if (!jdbVtab->collectionInfo->collection->TryGetBestIndex(
+          constraints[j].columnName, op, indexStat)) {
+        continue;
+      }
+
+      // The operand values are not known yet, estimate from the operator
+      PlanItem item;
+      item.constraints.push_back(j);
+      item.selectivity = indexStat.GetStatistics().EstimateSelectivity(op);
+      item.cost = indexStat.EstimateCost(op, item.selectivity);
+      // SQLite cannot evaluate MATCH itself
+      item.isRequired = op == IndexConstraintOperator::MATCH;
+      item.isUnique = op == IndexConstraintOperator::EQUAL &&
+          indexStat.GetIndexInfo().GetType() == IndexType::UNIQUE_HASH;
+      items.push_back(std::move(item));
+    }
+
+    auto plan = ChoosePlan(items, constraints.size(), documentCount);
+    for (std::size_t j = 0; j < constraints.size(); j++) {
+      if (!plan.isUsed[j]) {
+        // SQLite evaluates it on the returned documents
+        continue;
+      }
+
+      auto i = positions[j];
+      auto op = constraints[j].op;
+      info->aConstraintUsage[i].argvIndex = ++argvIndex;
+      // The indexes match LIKE without case, with PRAGMA case_sensitive_like
+      // that is a superset so SQLite has to check LIKE again
+      info->aConstraintUsage[i].omit = op != IndexConstraintOperator::LIKE;
+      assert(sizeof(int) == sizeof(info->aConstraint[i].iColumn));
+      assert(sizeof(IndexConstraintOperator) == sizeof(op));
+      // type of info->aConstraint[i].iColumn is int
+      sbuf.append((char*) &info->aConstraint[i].iColumn, sizeof(int));
+      sbuf.append((char*) &op, sizeof(IndexConstraintOperator));
+    }
+
+    info->idxNum = sbuf.size();
+    info->estimatedCost = plan.cost;
+    // ORDER BY on a single column with an ordered index is answered by
+    // visiting the values of the index in order, which costs one bitmap
+    // intersection per value but spares SQLite the sort and lets a LIMIT
+    // stop the scan early
+    info->orderByConsumed = 0;
+    if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn >= 0) {
+      auto column = info->aOrderBy[0].iColumn;
+      if (jdbVtab->collectionInfo->collection->TryGetOrderedIndex(
+          jdbVtab->collectionInfo->columnsInfo[column].columnName,
+          indexStat)) {
+        info->orderByConsumed = 1;
+        info->idxNum |= info->aOrderBy[0].desc ? ORDER_BY_DESC_FLAG
+                                               : ORDER_BY_ASC_FLAG;
+        sbuf.append((char*) &column, sizeof(int));
+        info->estimatedCost += static_cast<double>(
+            indexStat.GetStatistics().GetDistinctCount());
       }
     }
 
@@ -216,12 +372,15 @@ static int jonoondb_bestindex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
         return SQLITE_NOMEM;
       }
       info->needToFreeIdxStr = 1;
-      info->idxNum = sbuf.size();
 
       std::memcpy(info->idxStr, sbuf.data(), sbuf.size());
     }
 
-    info->orderByConsumed = 0;
+    info->estimatedRows = static_cast<sqlite3_int64>(plan.estimatedRows) + 1;
+    if (plan.isUnique) {
+      info->estimatedRows = 1;
+      info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+    }
 
     return SQLITE_OK;
   } catch (JonoonDBException& ex) {
@@ -261,12 +420,14 @@ static int jonoondb_filter(sqlite3_vtab_cursor* cur, int idxnum,
                            sqlite3_value** value) {
   try {
     auto cursor = reinterpret_cast<jonoondb_cursor*>(cur);
+    auto constraintsEnd = idxstr + (idxnum & CONSTRAINTS_LENGTH_MASK);
+    std::shared_ptr<MamaJenniesBitmap> bitmap;
     // Get the constraints    
     if (argc > 0) {
       std::vector<Constraint> constraints;
       auto currIndex = idxstr;
 
-      while (currIndex < (idxstr + idxnum)) {
+      while (currIndex < constraintsEnd) {
         // idxstr is encoded as: sizeof(int) bytes for column index, sizeof(IndexConstraintOperator) for Op
         int colIndex;
         memcpy(&colIndex, currIndex, sizeof(int));
@@ -314,13 +475,31 @@ static int jonoondb_filter(sqlite3_vtab_cursor* cur, int idxnum,
         value++;
       }
 
-      cursor->idSeq = std::make_unique<IDSequence>(
-          cursor->collectionInfo->collection->Filter(constraints), VECTOR_SIZE);
+      bitmap = cursor->collectionInfo->collection->Filter(constraints);
     } else {
       // We need to do a full scan      
+      bitmap = cursor->collectionInfo->collection->Filter(
+          std::vector<Constraint>());
+    }
+
+    if ((idxnum & (ORDER_BY_ASC_FLAG | ORDER_BY_DESC_FLAG)) != 0) {
+      int colIndex;
+      memcpy(&colIndex, constraintsEnd, sizeof(int));
+      auto& columnName = cursor->collectionInfo->columnsInfo[colIndex].columnName;
+      std::vector<std::shared_ptr<MamaJenniesBitmap>> orderedBitmaps;
+      if (!cursor->collectionInfo->collection->TryGetOrderedBitmaps(
+          columnName, orderedBitmaps)) {
+        std::ostringstream ss;
+        ss << "Cannot order by field " << columnName
+            << " because its ordered index does not exist anymore.";
+        throw JonoonDBException(ss.str(), __FILE__, __func__, __LINE__);
+      }
+
       cursor->idSeq = std::make_unique<IDSequence>(
-          cursor->collectionInfo->collection->Filter(std::vector<Constraint>()),
-          VECTOR_SIZE);
+          std::move(bitmap), std::move(orderedBitmaps),
+          (idxnum & ORDER_BY_DESC_FLAG) != 0, VECTOR_SIZE);
+    } else {
+      cursor->idSeq = std::make_unique<IDSequence>(std::move(bitmap), VECTOR_SIZE);
     }
   } catch (JonoonDBException& ex) {
     AllocateAndCopy(ex.to_string(), &cur->pVtab->zErrMsg);
@@ -674,8 +853,244 @@ static sqlite3_module jonoondb_mod = {
     jonoondb_next_vec       /* xNextVec()      */
 };
 
+// jonoondb_value_counts is a table valued function that returns the distinct
+// values of an indexed column with the number of documents that have them,
+// e.g. SELECT value, count FROM jonoondb_value_counts('tweet', 'user.name').
+// The counts come from the bitmaps of an EWAH_COMPRESSED_BITMAP index so no
+// document is read. Nulls are not counted.
+enum ValueCountsColumn {
+  VALUE_COUNTS_VALUE,
+  VALUE_COUNTS_COUNT,
+  VALUE_COUNTS_COLLECTION,
+  VALUE_COUNTS_COLUMN
+};
+
+struct value_counts_vtab {
+  sqlite3_vtab vtab;
+  // Name of the database, collections are looked up with it
+  std::string dbName;
+};
+
+struct value_counts_cursor {
+  sqlite3_vtab_cursor cur;
+  std::string collectionName;
+  std::string columnName;
+  std::vector<ValueBitmap> valueBitmaps;
+  std::size_t index = 0;
+};
+
+static int value_counts_connect(sqlite3* db, void* udp, int argc,
+                                const char* const* argv, sqlite3_vtab** vtab,
+                                char** errmsg) {
+  int code = sqlite3_declare_vtab(db, "CREATE TABLE x(value, count INTEGER, "
+      "collection TEXT HIDDEN, column TEXT HIDDEN)");
+  if (code != SQLITE_OK) {
+    return code;
+  }
+
+  std::unique_ptr<value_counts_vtab> v(new value_counts_vtab());
+  // The database file is <dbPath>/<dbName>.dat
+  std::string fileName = sqlite3_db_filename(db, argv[1]);
+  auto separator = fileName.find_last_of("/\\");
+  if (separator != std::string::npos) {
+    fileName.erase(0, separator + 1);
+  }
+  v->dbName = fileName.substr(0, fileName.rfind(".dat"));
+  *vtab = reinterpret_cast<sqlite3_vtab*>(v.release());
+
+  return SQLITE_OK;
+}
+
+static int value_counts_disconnect(sqlite3_vtab* vtab) {
+  delete reinterpret_cast<value_counts_vtab*>(vtab);
+  return SQLITE_OK;
+}
+
+static int value_counts_bestindex(sqlite3_vtab* vtab,
+                                  sqlite3_index_info* info) {
+  int collectionIndex = -1;
+  int columnIndex = -1;
+  for (int i = 0; i < info->nConstraint; i++) {
+    if (!info->aConstraint[i].usable ||
+        info->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ) {
+      continue;
+    }
+
+    if (info->aConstraint[i].iColumn == VALUE_COUNTS_COLLECTION) {
+      collectionIndex = i;
+    } else if (info->aConstraint[i].iColumn == VALUE_COUNTS_COLUMN) {
+      columnIndex = i;
+    }
+  }
+
+  if (collectionIndex < 0 || columnIndex < 0) {
+    // Both the arguments are required, xFilter fails without them
+    info->estimatedCost = 1e99;
+    return SQLITE_OK;
+  }
+
+  info->aConstraintUsage[collectionIndex].argvIndex = 1;
+  info->aConstraintUsage[collectionIndex].omit = 1;
+  info->aConstraintUsage[columnIndex].argvIndex = 2;
+  info->aConstraintUsage[columnIndex].omit = 1;
+  info->idxNum = 1;
+  info->estimatedCost = 1;
+  info->estimatedRows = 100;
+
+  return SQLITE_OK;
+}
+
+static int value_counts_open(sqlite3_vtab* vtab, sqlite3_vtab_cursor** cur) {
+  try {
+    *cur = reinterpret_cast<sqlite3_vtab_cursor*>(new value_counts_cursor());
+  } catch (std::bad_alloc&) {
+    return SQLITE_NOMEM;
+  }
+
+  return SQLITE_OK;
+}
+
+static int value_counts_close(sqlite3_vtab_cursor* cur) {
+  delete reinterpret_cast<value_counts_cursor*>(cur);
+  return SQLITE_OK;
+}
+
+static int value_counts_filter(sqlite3_vtab_cursor* cur, int idxnum,
+                               const char* idxstr, int argc,
+                               sqlite3_value** value) {
+  try {
+    auto cursor = reinterpret_cast<value_counts_cursor*>(cur);
+    auto vtab = reinterpret_cast<value_counts_vtab*>(cur->pVtab);
+    if (idxnum != 1 || argc != 2) {
+      AllocateAndCopy("jonoondb_value_counts needs the collection and column "
+                          "arguments.", &cur->pVtab->zErrMsg);
+      return SQLITE_ERROR;
+    }
+
+    cursor->collectionName =
+        reinterpret_cast<const char*>(sqlite3_value_text(value[0]));
+    cursor->columnName =
+        reinterpret_cast<const char*>(sqlite3_value_text(value[1]));
+    cursor->valueBitmaps.clear();
+    cursor->index = 0;
+
+    std::shared_ptr<DocumentCollectionInfo> collectionInfo;
+    if (!DocumentCollectionDictionary::Instance()->TryGet(
+        DocumentCollectionDictionary::GetKey(vtab->dbName,
+                                             cursor->collectionName),
+        collectionInfo)) {
+      std::ostringstream ss;
+      ss << "Collection " << cursor->collectionName << " does not exist.";
+      AllocateAndCopy(ss.str(), &cur->pVtab->zErrMsg);
+      return SQLITE_ERROR;
+    }
+
+    if (!collectionInfo->collection->TryGetValueBitmaps(
+        cursor->columnName, cursor->valueBitmaps)) {
+      std::ostringstream ss;
+      ss << "Column " << cursor->columnName << " of collection "
+          << cursor->collectionName
+          << " does not have an index that keeps the value counts.";
+      AllocateAndCopy(ss.str(), &cur->pVtab->zErrMsg);
+      return SQLITE_ERROR;
+    }
+  } catch (JonoonDBException& ex) {
+    AllocateAndCopy(ex.to_string(), &cur->pVtab->zErrMsg);
+    return SQLITE_ERROR;
+  } catch (std::exception& ex) {
+    std::ostringstream errMessage;
+    errMessage << "Exception caugth in value_counts_filter function. Error: "
+        << ex.what();
+    AllocateAndCopy(errMessage.str(), &cur->pVtab->zErrMsg);
+    return SQLITE_ERROR;
+  }
+
+  return SQLITE_OK;
+}
+
+static int value_counts_next(sqlite3_vtab_cursor* cur) {
+  reinterpret_cast<value_counts_cursor*>(cur)->index++;
+  return SQLITE_OK;
+}
+
+static int value_counts_eof(sqlite3_vtab_cursor* cur) {
+  auto cursor = reinterpret_cast<value_counts_cursor*>(cur);
+  return cursor->index >= cursor->valueBitmaps.size();
+}
+
+static int value_counts_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx,
+                               int cidx) {
+  auto cursor = reinterpret_cast<value_counts_cursor*>(cur);
+  auto& valueBitmap = cursor->valueBitmaps[cursor->index];
+  switch (cidx) {
+    case VALUE_COUNTS_VALUE:
+      if (valueBitmap.valueType == OperandType::INTEGER) {
+        sqlite3_result_int64(ctx, valueBitmap.value.int64Val);
+      } else if (valueBitmap.valueType == OperandType::DOUBLE) {
+        sqlite3_result_double(ctx, valueBitmap.value.doubleVal);
+      } else {
+        sqlite3_result_text(ctx, valueBitmap.strVal.c_str(),
+                            valueBitmap.strVal.size(), SQLITE_TRANSIENT);
+      }
+      break;
+    case VALUE_COUNTS_COUNT:
+      // Only computed for the rows that SQLite asks for
+      sqlite3_result_int64(ctx, valueBitmap.bitmap->GetCount());
+      break;
+    case VALUE_COUNTS_COLLECTION:
+      sqlite3_result_text(ctx, cursor->collectionName.c_str(),
+                          cursor->collectionName.size(), SQLITE_TRANSIENT);
+      break;
+    default:
+      sqlite3_result_text(ctx, cursor->columnName.c_str(),
+                          cursor->columnName.size(), SQLITE_TRANSIENT);
+      break;
+  }
+
+  return SQLITE_OK;
+}
+
+static int value_counts_rowid(sqlite3_vtab_cursor* cur, sqlite_int64* rowid) {
+  *rowid = reinterpret_cast<value_counts_cursor*>(cur)->index;
+  return SQLITE_OK;
+}
+
+static sqlite3_module value_counts_mod = {
+    1,                        /* iVersion        */
+    NULL,                     /* xCreate()       */
+    value_counts_connect,     /* xConnect()      */
+    value_counts_bestindex,   /* xBestIndex()    */
+    value_counts_disconnect,  /* xDisconnect()   */
+    value_counts_disconnect,  /* xDestroy()      */
+    value_counts_open,        /* xOpen()         */
+    value_counts_close,       /* xClose()        */
+    value_counts_filter,      /* xFilter()       */
+    value_counts_next,        /* xNext()         */
+    value_counts_eof,         /* xEof()          */
+    value_counts_column,      /* xColumn()       */
+    value_counts_rowid,       /* xRowid()        */
+    NULL,                     /* xUpdate()       */
+    NULL,                     /* xBegin()        */
+    NULL,                     /* xSync()         */
+    NULL,                     /* xCommit()       */
+    NULL,                     /* xRollback()     */
+    NULL,                     /* xFindFunction() */
+    NULL,                     /* xRename()       */
+    NULL,                     /* xSavepoint()    */
+    NULL,                     /* xRelease()      */
+    NULL,                     /* xRollbackTo()   */
+    NULL,                     /* xColumnVec()    */
+    NULL                      /* xNextVec()      */
+};
+
 int jonoondb_vtable_init(sqlite3* db, char** error,
                          const sqlite3_api_routines* api) {
   SQLITE_EXTENSION_INIT2(api);
-  return sqlite3_create_module(db, "jonoondb_vtable", &jonoondb_mod, NULL);
+  int code = sqlite3_create_module(db, "jonoondb_vtable", &jonoondb_mod, NULL);
+  if (code != SQLITE_OK) {
+    return code;
+  }
+
+  return sqlite3_create_module(db, "jonoondb_value_counts",
+                               &value_counts_mod, NULL);
 }
@@ -1,45 +1,143 @@
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <queue>
 #include <sstream>
 #include "mama_jennies_bitmap.h"
 #include "jonoondb_exceptions.h"
 
 using namespace jonoondb_api;
 
+// A k-way OR accumulates into a dense buffer if the buffer has at most this
+// many words per compressed word of the inputs
+static const std::size_t DENSE_OR_RATIO = 16;
+
 MamaJenniesBitmapConstIterator::MamaJenniesBitmapConstIterator(EWAHBoolArray<std::uint64_t>::const_iterator& iter)
-    : m_iter(iter) {
+    : m_iter(std::make_unique<EWAHBoolArray<std::uint64_t>::const_iterator>(iter)) {
+}
+
+MamaJenniesBitmapConstIterator::MamaJenniesBitmapConstIterator(const RoaringBitmap::ConstIterator& iter)
+    : m_roaringIter(iter) {
+}
+
+MamaJenniesBitmapConstIterator::MamaJenniesBitmapConstIterator(const MamaJenniesBitmapConstIterator& other)
+    : m_roaringIter(other.m_roaringIter) {
+  if (other.m_iter != nullptr) {
+    m_iter =
+        std::make_unique<EWAHBoolArray<std::uint64_t>::const_iterator>(*other.m_iter);
+  }
 }
 
 std::size_t MamaJenniesBitmapConstIterator::operator*() const {
-  return m_iter.operator*();
+  if (m_iter == nullptr) {
+    return *m_roaringIter;
+  }
+  return m_iter->operator*();
 }
 
 MamaJenniesBitmapConstIterator& MamaJenniesBitmapConstIterator::operator++() {
-  ++m_iter;
+  if (m_iter == nullptr) {
+    ++m_roaringIter;
+  } else {
+    ++(*m_iter);
+  }
   return *this;
 }
 
 bool MamaJenniesBitmapConstIterator::operator==(const MamaJenniesBitmapConstIterator& other) {
-  return this->m_iter == other.m_iter;
+  if (m_iter == nullptr) {
+    return m_roaringIter == other.m_roaringIter;
+  }
+  return *m_iter == *other.m_iter;
 }
 
 bool MamaJenniesBitmapConstIterator::operator!=(const MamaJenniesBitmapConstIterator& other) {
-  return this->m_iter != other.m_iter;
+  if (m_iter == nullptr) {
+    return m_roaringIter != other.m_roaringIter;
+  }
+  return *m_iter != *other.m_iter;
 }
 
 bool MamaJenniesBitmapConstIterator::operator<(const MamaJenniesBitmapConstIterator& other) {
-  return m_iter.operator<(other.m_iter);
+  if (m_iter == nullptr) {
+    return m_roaringIter < other.m_roaringIter;
+  }
+  return m_iter->operator<(*other.m_iter);
 }
 
 bool MamaJenniesBitmapConstIterator::operator<=(const MamaJenniesBitmapConstIterator& other) {
-  return m_iter.operator<=(other.m_iter);
+  if (m_iter == nullptr) {
+    return m_roaringIter <= other.m_roaringIter;
+  }
+  return m_iter->operator<=(*other.m_iter);
 }
 
 bool MamaJenniesBitmapConstIterator::operator>(const MamaJenniesBitmapConstIterator& other) {
-  return m_iter.operator>(other.m_iter);
+  if (m_iter == nullptr) {
+    return m_roaringIter > other.m_roaringIter;
+  }
+  return m_iter->operator>(*other.m_iter);
 }
 
 bool MamaJenniesBitmapConstIterator::operator>=(const MamaJenniesBitmapConstIterator& other) {
-  return m_iter.operator>=(other.m_iter);
+  if (m_iter == nullptr) {
+    return m_roaringIter >= other.m_roaringIter;
+  }
+  return m_iter->operator>=(*other.m_iter);
+}
+
+MamaJenniesBitmapDecoder::MamaJenniesBitmapDecoder(
+    const MamaJenniesBitmap& bitmap) {
+  if (bitmap.m_roaringBitmap != nullptr) {
+    m_roaringIter = bitmap.m_roaringBitmap->begin();
+  } else {
+    m_rawIter = std::make_unique<EWAHBoolArrayRawIterator<std::uint64_t>>(
+        *bitmap.m_ewahBoolArray);
+  }
+}
+
+std::size_t MamaJenniesBitmapDecoder::Decode(std::uint64_t* positions,
+                                             std::size_t capacity) {
+  if (m_rawIter == nullptr) {
+    return m_roaringIter.Decode(positions, capacity);
+  }
+
+  std::size_t count = 0;
+  while (count < capacity) {
+    if (m_word != 0) {
+      do {
+        positions[count++] = m_wordPosition + ctz64(m_word);
+        m_word &= m_word - 1;
+      } while (m_word != 0 && count < capacity);
+    } else if (m_runNext < m_runEnd) {
+      auto n = std::min<std::uint64_t>(capacity - count,
+                                       m_runEnd - m_runNext);
+      for (std::uint64_t i = 0; i < n; i++) {
+        positions[count + i] = m_runNext + i;
+      }
+      count += static_cast<std::size_t>(n);
+      m_runNext += n;
+    } else if (m_literalCount > 0) {
+      m_word = *m_literals++;
+      m_literalCount--;
+      m_wordPosition = m_nextWordPosition;
+      m_nextWordPosition += 64;
+    } else if (m_rawIter->hasNext()) {
+      auto& rlw = m_rawIter->next();
+      auto runSizeInBits = std::uint64_t(rlw.getRunningLength()) * 64;
+      if (rlw.getRunningBit()) {
+        m_runNext = m_nextWordPosition;
+        m_runEnd = m_nextWordPosition + runSizeInBits;
+      }
+      m_nextWordPosition += runSizeInBits;
+      m_literals = m_rawIter->dirtyWords();
+      m_literalCount = rlw.getNumberOfLiteralWords();
+    } else {
+      break;
+    }
+  }
+
+  return count;
 }
 
 MamaJenniesBitmap::MamaJenniesBitmap()
@@ -49,22 +147,29 @@ MamaJenniesBitmap::MamaJenniesBitmap()
 MamaJenniesBitmap::MamaJenniesBitmap(MamaJenniesBitmap&& other) {
   if (this != &other) {
     m_ewahBoolArray.reset(other.m_ewahBoolArray.release());
+    m_roaringBitmap.reset(other.m_roaringBitmap.release());
+    m_ewahCount = other.m_ewahCount;
   }
 }
 
 MamaJenniesBitmap::MamaJenniesBitmap(const MamaJenniesBitmap& other) {
   if (this != &other) {
-    // Lets call copy ctor of EWAHBoolArray
-    m_ewahBoolArray =
-        std::make_unique<EWAHBoolArray<std::uint64_t>>(*other.m_ewahBoolArray);
+    *this = other;
   }
 }
 
 MamaJenniesBitmap& MamaJenniesBitmap::operator=(const MamaJenniesBitmap& other) {
   if (this != &other) {
-    // Lets call copy ctor of EWAHBoolArray
-    m_ewahBoolArray =
-        std::make_unique<EWAHBoolArray<std::uint64_t>>(*other.m_ewahBoolArray);
+    if (other.m_roaringBitmap != nullptr) {
+      m_ewahBoolArray.reset();
+      m_roaringBitmap = std::make_unique<RoaringBitmap>(*other.m_roaringBitmap);
+    } else {
+      // Lets call copy ctor of EWAHBoolArray
+      m_roaringBitmap.reset();
+      m_ewahBoolArray =
+          std::make_unique<EWAHBoolArray<std::uint64_t>>(*other.m_ewahBoolArray);
+    }
+    m_ewahCount = other.m_ewahCount;
   }
   return *this;
 }
@@ -72,46 +177,218 @@ MamaJenniesBitmap& MamaJenniesBitmap::operator=(const MamaJenniesBitmap& other)
 MamaJenniesBitmap& MamaJenniesBitmap::operator=(MamaJenniesBitmap&& other) {
   if (this != &other) {
     m_ewahBoolArray.reset(other.m_ewahBoolArray.release());
+    m_roaringBitmap.reset(other.m_roaringBitmap.release());
+    m_ewahCount = other.m_ewahCount;
   }
   return *this;
 }
 
 void MamaJenniesBitmap::Add(std::uint64_t x) {
-  if (!m_ewahBoolArray->set(x)) {
-    throw JonoonDBException(
-        "Add to bitmap failed. Most probably the entries were not added in increasing order.",
-        __FILE__,
-        __func__,
-        __LINE__);
+  if (m_roaringBitmap != nullptr) {
+    m_roaringBitmap->Add(x);
+  } else if (m_ewahBoolArray->set(x)) {
+    m_ewahCount++;
+  } else {
+    // EWAH can only append, Roaring takes the bits in any order
+    ConvertToRoaring();
+    m_roaringBitmap->Add(x);
   }
 }
 
-bool MamaJenniesBitmap::IsEmpty() {
-  // Todo: Need to find a faster way to check for empty bitmap
-  bool isEmpty = true;
-  if (m_ewahBoolArray->sizeInBits() > 0) {
-    for (auto iter = m_ewahBoolArray->begin(); iter != m_ewahBoolArray->end();
-         iter++) {
-      isEmpty = false;
-      break;
+void MamaJenniesBitmap::AddWord(std::uint64_t word) {
+  if (m_roaringBitmap != nullptr) {
+    AddWords(&word, 1);
+  } else {
+    m_ewahBoolArray->addWord(word);
+    m_ewahCount += countOnes(word);
+  }
+}
+
+void MamaJenniesBitmap::AddWords(const std::uint64_t* words,
+                                 std::size_t count) {
+  if (m_roaringBitmap != nullptr) {
+    // The words start at the next word boundary
+    auto offset = (m_roaringBitmap->GetSizeInBits() + 63) / 64 * 64;
+    m_roaringBitmap->AddWords(offset, words, count);
+    return;
+  }
+
+  const std::uint64_t allOnes = ~std::uint64_t(0);
+  std::size_t i = 0;
+  while (i < count) {
+    auto start = i;
+    if (words[i] == 0 || words[i] == allOnes) {
+      auto word = words[i];
+      while (i < count && words[i] == word) {
+        i++;
+      }
+      m_ewahBoolArray->addStreamOfEmptyWords(word == allOnes, i - start);
+      if (word == allOnes) {
+        m_ewahCount += (i - start) * 64;
+      }
+    } else {
+      while (i < count && words[i] != 0 && words[i] != allOnes) {
+        m_ewahCount += countOnes(words[i]);
+        i++;
+      }
+      m_ewahBoolArray->addStreamOfDirtyWords(words + start, i - start);
+    }
+  }
+}
+
+void MamaJenniesBitmap::AddEmptyWords(std::size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  if (m_roaringBitmap != nullptr) {
+    // Adding the last zero word moves the end of the bitmap past all of them
+    auto offset = (m_roaringBitmap->GetSizeInBits() + 63) / 64 * 64;
+    const std::uint64_t zero = 0;
+    m_roaringBitmap->AddWords(offset + (count - 1) * 64, &zero, 1);
+  } else {
+    m_ewahBoolArray->addStreamOfEmptyWords(false, count);
+  }
+}
+
+void MamaJenniesBitmap::Optimize() {
+  if (m_roaringBitmap == nullptr) {
+    auto roaringBitmap = std::make_unique<RoaringBitmap>();
+    ToRoaring(*m_ewahBoolArray, *roaringBitmap);
+    roaringBitmap->RunOptimize();
+    if (roaringBitmap->GetSizeInBytes() < m_ewahBoolArray->sizeInBytes()) {
+      m_roaringBitmap = std::move(roaringBitmap);
+      m_ewahBoolArray.reset();
     }
+    return;
   }
 
-  return isEmpty;
+  m_roaringBitmap->RunOptimize();
+  auto ewahBoolArray = std::make_unique<EWAHBoolArray<std::uint64_t>>();
+  for (auto iter = m_roaringBitmap->begin(); iter != m_roaringBitmap->end();
+       ++iter) {
+    ewahBoolArray->set(*iter);
+  }
+  if (ewahBoolArray->sizeInBytes() < m_roaringBitmap->GetSizeInBytes()) {
+    m_ewahCount = m_roaringBitmap->GetCount();
+    m_ewahBoolArray = std::move(ewahBoolArray);
+    m_roaringBitmap.reset();
+  }
+}
+
+void MamaJenniesBitmap::ConvertToRoaring() {
+  m_roaringBitmap = std::make_unique<RoaringBitmap>();
+  ToRoaring(*m_ewahBoolArray, *m_roaringBitmap);
+  m_ewahBoolArray.reset();
+}
+
+void MamaJenniesBitmap::ToRoaring(
+    const EWAHBoolArray<std::uint64_t>& ewahBoolArray,
+    RoaringBitmap& roaringBitmap) {
+  for (auto iter = ewahBoolArray.begin(); iter != ewahBoolArray.end();
+       iter++) {
+    roaringBitmap.Add(*iter);
+  }
+}
+
+bool MamaJenniesBitmap::IsEmpty() {
+  return GetCount() == 0;
+}
+
+std::uint64_t MamaJenniesBitmap::GetCount() {
+  if (m_roaringBitmap != nullptr) {
+    return m_roaringBitmap->GetCount();
+  }
+  return m_ewahCount;
 }
 
 std::uint64_t MamaJenniesBitmap::GetSizeInBits() {
+  if (m_roaringBitmap != nullptr) {
+    return m_roaringBitmap->GetSizeInBits();
+  }
   return m_ewahBoolArray->sizeInBits();
 }
 
+std::size_t MamaJenniesBitmap::GetSizeInBytes() {
+  if (m_roaringBitmap != nullptr) {
+    return m_roaringBitmap->GetSizeInBytes();
+  }
+  return m_ewahBoolArray->sizeInBytes();
+}
+
 void MamaJenniesBitmap::LogicalAND(const MamaJenniesBitmap& other,
                                    MamaJenniesBitmap& output) {
-  m_ewahBoolArray->logicaland(*other.m_ewahBoolArray, *output.m_ewahBoolArray);
+  if (m_roaringBitmap == nullptr && other.m_roaringBitmap == nullptr) {
+    if (output.m_ewahBoolArray == nullptr) {
+      output.m_roaringBitmap.reset();
+      output.m_ewahBoolArray = std::make_unique<EWAHBoolArray<std::uint64_t>>();
+    }
+    m_ewahBoolArray->logicaland(*other.m_ewahBoolArray, *output.m_ewahBoolArray);
+    output.m_ewahCount = output.m_ewahBoolArray->numberOfOnes();
+    return;
+  }
+
+  // Mixed backends are combined in Roaring
+  RoaringBitmap converted;
+  const RoaringBitmap* bitmap1 = m_roaringBitmap.get();
+  const RoaringBitmap* bitmap2 = other.m_roaringBitmap.get();
+  if (bitmap1 == nullptr) {
+    ToRoaring(*m_ewahBoolArray, converted);
+    bitmap1 = &converted;
+  } else if (bitmap2 == nullptr) {
+    ToRoaring(*other.m_ewahBoolArray, converted);
+    bitmap2 = &converted;
+  }
+
+  auto result = std::make_unique<RoaringBitmap>();
+  RoaringBitmap::And(*bitmap1, *bitmap2, *result);
+  output.m_ewahBoolArray.reset();
+  output.m_roaringBitmap = std::move(result);
 }
 
 void MamaJenniesBitmap::LogicalOR(const MamaJenniesBitmap& other,
                                   MamaJenniesBitmap& output) {
-  m_ewahBoolArray->logicalor(*other.m_ewahBoolArray, *output.m_ewahBoolArray);
+  if (m_roaringBitmap == nullptr && other.m_roaringBitmap == nullptr) {
+    if (output.m_ewahBoolArray == nullptr) {
+      output.m_roaringBitmap.reset();
+      output.m_ewahBoolArray = std::make_unique<EWAHBoolArray<std::uint64_t>>();
+    }
+    m_ewahBoolArray->logicalor(*other.m_ewahBoolArray, *output.m_ewahBoolArray);
+    output.m_ewahCount = output.m_ewahBoolArray->numberOfOnes();
+    return;
+  }
+
+  RoaringBitmap converted;
+  const RoaringBitmap* bitmap1 = m_roaringBitmap.get();
+  const RoaringBitmap* bitmap2 = other.m_roaringBitmap.get();
+  if (bitmap1 == nullptr) {
+    ToRoaring(*m_ewahBoolArray, converted);
+    bitmap1 = &converted;
+  } else if (bitmap2 == nullptr) {
+    ToRoaring(*other.m_ewahBoolArray, converted);
+    bitmap2 = &converted;
+  }
+
+  auto result = std::make_unique<RoaringBitmap>();
+  RoaringBitmap::Or(*bitmap1, *bitmap2, *result);
+  output.m_ewahBoolArray.reset();
+  output.m_roaringBitmap = std::move(result);
+}
+
+std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::CreateRange(
+    std::uint64_t count) {
+  auto bitmap = std::make_shared<MamaJenniesBitmap>();
+  auto fullWords = static_cast<std::size_t>(count / 64);
+  auto remainingBits = count % 64;
+  if (fullWords > 0) {
+    bitmap->m_ewahBoolArray->addStreamOfEmptyWords(true, fullWords);
+  }
+  if (remainingBits > 0) {
+    bitmap->m_ewahBoolArray->addWord((std::uint64_t(1) << remainingBits) - 1);
+  }
+  bitmap->m_ewahBoolArray->setSizeInBits(static_cast<std::size_t>(count));
+  bitmap->m_ewahCount = count;
+  return bitmap;
 }
 
 std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::LogicalAND(std::vector<std::shared_ptr<
@@ -121,21 +398,34 @@ std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::LogicalAND(std::vector<std
   } else if (bitmaps.size() == 1) {
     return bitmaps[0];
   }
-  // ok we have more than 1 bitmap
+  // ok we have more than 1 bitmap. Starting with the smallest keeps the
+  // intermediate results small.
+  std::vector<MamaJenniesBitmap*> sortedBitmaps;
+  for (auto& bitmap : bitmaps) {
+    if (bitmap->IsEmpty()) {
+      return std::make_shared<MamaJenniesBitmap>();
+    }
+    sortedBitmaps.push_back(bitmap.get());
+  }
+  std::sort(sortedBitmaps.begin(), sortedBitmaps.end(),
+            [](MamaJenniesBitmap* a, MamaJenniesBitmap* b) {
+              return a->GetCount() < b->GetCount();
+            });
+
   std::shared_ptr<MamaJenniesBitmap> b1 = std::make_shared<MamaJenniesBitmap>();
   std::shared_ptr<MamaJenniesBitmap> b2 = std::make_shared<MamaJenniesBitmap>();
 
-  MamaJenniesBitmap* combinedBitmap = bitmaps[0].get();
+  MamaJenniesBitmap* combinedBitmap = sortedBitmaps[0];
   MamaJenniesBitmap* outputBitmap = b2.get();
   bool flipper = true;
 
-  for (int i = 1; i < bitmaps.size(); i++) {
-    bitmaps[i]->LogicalAND(*combinedBitmap, *outputBitmap);
+  for (std::size_t i = 1; i < sortedBitmaps.size(); i++) {
+    sortedBitmaps[i]->LogicalAND(*combinedBitmap, *outputBitmap);
     flipper = !flipper; // will turn to false on 1st iteration
     combinedBitmap = flipper ? b1.get() : b2.get();
     outputBitmap = flipper ? b2.get() : b1.get();
 
-    if (combinedBitmap->GetSizeInBits() == 0) {
+    if (combinedBitmap->IsEmpty()) {
       // No need to proceed further, the AND result will be an empty bitmap
       break;
     }
@@ -150,45 +440,138 @@ std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::LogicalOR(
     return std::make_unique<MamaJenniesBitmap>();
   } else if (bitmaps.size() == 1) {
     return bitmaps[0];
+  } else if (bitmaps.size() == 2) {
+    auto output = std::make_shared<MamaJenniesBitmap>();
+    bitmaps[0]->LogicalOR(*bitmaps[1], *output);
+    return output;
   }
-  // ok we have more than 1 bitmap
-  std::shared_ptr<MamaJenniesBitmap> b1 = std::make_shared<MamaJenniesBitmap>();
-  std::shared_ptr<MamaJenniesBitmap> b2 = std::make_shared<MamaJenniesBitmap>();
 
-  MamaJenniesBitmap* combinedBitmap = bitmaps[0].get();
-  MamaJenniesBitmap* outputBitmap = b2.get();
-  bool flipper = true;
+  // Folding more bitmaps pairwise would copy the growing result once per
+  // bitmap. Instead all of them are merged in one pass, into a dense buffer
+  // if that is not much larger than the inputs and with a heap otherwise.
+  std::uint64_t sizeInBits = 0;
+  std::size_t compressedWords = 0;
+  for (auto& bitmap : bitmaps) {
+    sizeInBits = std::max(sizeInBits, bitmap->GetSizeInBits());
+    compressedWords += bitmap->GetSizeInBytes() / sizeof(std::uint64_t);
+  }
 
-  for (int i = 1; i < bitmaps.size(); i++) {
-    bitmaps[i]->LogicalOR(*combinedBitmap, *outputBitmap);
-    flipper = !flipper; // will turn to false on 1st iteration
-    combinedBitmap = flipper ? b1.get() : b2.get();
-    outputBitmap = flipper ? b2.get() : b1.get();
+  auto wordCount = static_cast<std::size_t>((sizeInBits + 63) / 64);
+  if (compressedWords * DENSE_OR_RATIO >= wordCount) {
+    return DenseLogicalOR(bitmaps, wordCount);
   }
+  return MergeLogicalOR(bitmaps);
+}
 
-  return flipper ? b1 : b2;
+std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::DenseLogicalOR(
+    std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps,
+    std::size_t wordCount) {
+  std::vector<std::uint64_t> words(wordCount, 0);
+  for (auto& bitmap : bitmaps) {
+    bitmap->OrInto(words.data(), words.size());
+  }
+
+  auto output = std::make_shared<MamaJenniesBitmap>();
+  output->AddWords(words.data(), words.size());
+  return output;
+}
+
+std::shared_ptr<MamaJenniesBitmap> MamaJenniesBitmap::MergeLogicalOR(
+    std::vector<std::shared_ptr<MamaJenniesBitmap>>& bitmaps) {
+  // The heap holds the current position of every bitmap and the index of
+  // the bitmap, the smallest position is on top
+  typedef std::pair<std::uint64_t, std::size_t> HeapEntry;
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                      std::greater<HeapEntry>> heap;
+  std::vector<const_iterator> iters;
+  std::vector<const_iterator> ends;
+  iters.reserve(bitmaps.size());
+  ends.reserve(bitmaps.size());
+  for (std::size_t i = 0; i < bitmaps.size(); i++) {
+    iters.push_back(bitmaps[i]->begin());
+    ends.push_back(bitmaps[i]->end());
+    if (iters[i] != ends[i]) {
+      heap.emplace(*iters[i], i);
+    }
+  }
+
+  auto output = std::make_shared<MamaJenniesBitmap>();
+  while (!heap.empty()) {
+    auto entry = heap.top();
+    heap.pop();
+    // Positions found in several bitmaps are popped once per bitmap
+    if (entry.first >= output->GetSizeInBits()) {
+      output->Add(entry.first);
+    }
+
+    auto& iter = iters[entry.second];
+    ++iter;
+    if (iter != ends[entry.second]) {
+      heap.emplace(*iter, entry.second);
+    }
+  }
+
+  return output;
+}
+
+void MamaJenniesBitmap::OrInto(std::uint64_t* words, std::size_t count) {
+  if (m_roaringBitmap != nullptr) {
+    m_roaringBitmap->OrInto(words, count);
+    return;
+  }
+
+  std::size_t position = 0;
+  auto iter = m_ewahBoolArray->raw_iterator();
+  while (iter.hasNext() && position < count) {
+    auto& rlw = iter.next();
+    std::size_t runLength = rlw.getRunningLength();
+    if (rlw.getRunningBit()) {
+      std::fill(words + position, words + std::min(position + runLength, count),
+                ~std::uint64_t(0));
+    }
+    position += runLength;
+
+    auto literals = iter.dirtyWords();
+    std::size_t literalCount = rlw.getNumberOfLiteralWords();
+    for (std::size_t i = 0; i < literalCount && position < count; i++) {
+      words[position++] |= literals[i];
+    }
+  }
 }
 
 MamaJenniesBitmap::const_iterator MamaJenniesBitmap::begin() {
+  if (m_roaringBitmap != nullptr) {
+    return MamaJenniesBitmapConstIterator(m_roaringBitmap->begin());
+  }
   auto iter = m_ewahBoolArray->begin();
   return MamaJenniesBitmapConstIterator(iter);
 }
 
 MamaJenniesBitmap::const_iterator MamaJenniesBitmap::end() {
+  if (m_roaringBitmap != nullptr) {
+    return MamaJenniesBitmapConstIterator(m_roaringBitmap->end());
+  }
   auto iter = m_ewahBoolArray->end();
   return MamaJenniesBitmapConstIterator(iter);
 }
 
 std::unique_ptr<MamaJenniesBitmap::const_iterator> MamaJenniesBitmap::begin_pointer() {
+  if (m_roaringBitmap != nullptr) {
+    return std::make_unique<const_iterator>(m_roaringBitmap->begin());
+  }
   auto iter = m_ewahBoolArray->begin();
   return std::make_unique<const_iterator>(iter);
 }
 
 std::unique_ptr<MamaJenniesBitmap::const_iterator> MamaJenniesBitmap::end_pointer() {
+  if (m_roaringBitmap != nullptr) {
+    return std::make_unique<const_iterator>(m_roaringBitmap->end());
+  }
   auto iter = m_ewahBoolArray->end();
   return std::make_unique<const_iterator>(iter);
 }
 
 MamaJenniesBitmap::MamaJenniesBitmap(std::unique_ptr<EWAHBoolArray<std::uint64_t>> ewahBoolArray)
-    : m_ewahBoolArray(std::move(ewahBoolArray)) {
-}
\ No newline at end of file
+    : m_ewahBoolArray(std::move(ewahBoolArray)),
+      m_ewahCount(m_ewahBoolArray->numberOfOnes()) {
+}
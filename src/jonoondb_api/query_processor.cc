@@ -182,8 +182,8 @@ void QueryProcessor::AddCollection(const std::shared_ptr<DocumentCollection>& co
 
   // Generate key and insert the collection in a singleton dictionary.
   // vtable will use this key to get the collectionInfo  
-  std::string key("'");
-  key.append(m_dbName).append(">").append(collection->GetName()).append("'");
+  auto key = DocumentCollectionDictionary::GetKey(m_dbName,
+                                                  collection->GetName());
   DocumentCollectionDictionary::Instance()->Insert(key, docColInfo);
 
   std::ostringstream sqlStmt;
@@ -230,8 +230,7 @@ void jonoondb_api::QueryProcessor::RemoveCollection(const std::string& collectio
     throw SQLException(sqlite3_errstr(code), __FILE__, __func__, __LINE__);
   }
 
-  std::string key("'");
-  key.append(m_dbName).append(">").append(collectionName).append("'");
+  auto key = DocumentCollectionDictionary::GetKey(m_dbName, collectionName);
   DocumentCollectionDictionary::Instance()->Remove(key);
 }
 
@@ -247,8 +246,8 @@ void QueryProcessor::AddExistingCollection(const std::shared_ptr<
 
   // Generate key and insert the collection in a singleton dictionary.
   // vtable will use this key to get the collectionInfo  
-  std::string key("'");
-  key.append(m_dbName).append(">").append(collection->GetName()).append("'");
+  auto key = DocumentCollectionDictionary::GetKey(m_dbName,
+                                                  collection->GetName());
   DocumentCollectionDictionary::Instance()->Insert(key, docColInfo);
 }
 
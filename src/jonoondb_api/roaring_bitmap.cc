@@ -0,0 +1,619 @@
+#include <algorithm>
+#include <iterator>
+#include "roaring_bitmap.h"
+#include "ewah_boolarray/ewahutil.h"
+
+using namespace jonoondb_api;
+
+namespace {
+typedef RoaringBitmap::Container Container;
+typedef RoaringBitmap::ContainerType ContainerType;
+
+const std::uint32_t CONTAINER_SIZE_IN_BITS = 1 << 16;
+
+std::uint32_t PopCount(std::uint64_t word) {
+  return countOnes(word);
+}
+
+std::uint32_t TrailingZeros(std::uint64_t word) {
+  return ctz64(word);
+}
+
+// Returns the first set bit at or after from or CONTAINER_SIZE_IN_BITS
+std::uint32_t NextSetBit(const std::vector<std::uint64_t>& words,
+                         std::uint32_t from) {
+  if (from >= CONTAINER_SIZE_IN_BITS) {
+    return CONTAINER_SIZE_IN_BITS;
+  }
+
+  auto index = from / 64;
+  auto word = words[index] >> (from % 64);
+  if (word != 0) {
+    return from + TrailingZeros(word);
+  }
+
+  for (index++; index < words.size(); index++) {
+    if (words[index] != 0) {
+      return index * 64 + TrailingZeros(words[index]);
+    }
+  }
+  return CONTAINER_SIZE_IN_BITS;
+}
+
+void ToBitset(const Container& container, std::vector<std::uint64_t>& words) {
+  if (container.type == ContainerType::BITSET) {
+    words = container.words;
+    return;
+  }
+
+  words.assign(RoaringBitmap::BITSET_WORDS, 0);
+  if (container.type == ContainerType::ARRAY) {
+    for (auto low : container.values) {
+      words[low / 64] |= std::uint64_t(1) << (low % 64);
+    }
+  } else {
+    for (std::size_t i = 0; i < container.values.size(); i += 2) {
+      std::uint32_t last = std::uint32_t(container.values[i]) +
+          container.values[i + 1];
+      for (std::uint32_t low = container.values[i]; low <= last; low++) {
+        words[low / 64] |= std::uint64_t(1) << (low % 64);
+      }
+    }
+  }
+}
+
+// Stores the bits in the smaller of an array and a bitset container
+void FromBitset(std::vector<std::uint64_t>& words, Container& container) {
+  std::uint32_t cardinality = 0;
+  for (auto word : words) {
+    cardinality += PopCount(word);
+  }
+
+  container.cardinality = cardinality;
+  if (cardinality > RoaringBitmap::ARRAY_MAX_SIZE) {
+    container.type = ContainerType::BITSET;
+    container.values.clear();
+    container.words.swap(words);
+    return;
+  }
+
+  container.type = ContainerType::ARRAY;
+  container.words.clear();
+  container.values.clear();
+  container.values.reserve(cardinality);
+  for (std::uint32_t i = 0; i < words.size(); i++) {
+    auto word = words[i];
+    while (word != 0) {
+      container.values.push_back(
+          static_cast<std::uint16_t>(i * 64 + TrailingZeros(word)));
+      word &= word - 1;
+    }
+  }
+}
+
+bool ContainsLow(const Container& container, std::uint16_t low) {
+  switch (container.type) {
+    case ContainerType::ARRAY:
+      return std::binary_search(container.values.begin(),
+                                container.values.end(), low);
+    case ContainerType::BITSET:
+      return ((container.words[low / 64] >> (low % 64)) & 1) != 0;
+    default: {
+      // Find the last run starting at or before low
+      std::size_t first = 0;
+      std::size_t last = container.values.size() / 2;
+      while (first < last) {
+        auto mid = (first + last) / 2;
+        if (container.values[mid * 2] <= low) {
+          first = mid + 1;
+        } else {
+          last = mid;
+        }
+      }
+      if (first == 0) {
+        return false;
+      }
+      auto run = (first - 1) * 2;
+      return std::uint32_t(low) - container.values[run] <=
+          container.values[run + 1];
+    }
+  }
+}
+
+std::uint16_t MaxLow(const Container& container) {
+  switch (container.type) {
+    case ContainerType::ARRAY:
+      return container.values.back();
+    case ContainerType::BITSET: {
+      auto index = container.words.size();
+      while (container.words[index - 1] == 0) {
+        index--;
+      }
+      auto word = container.words[index - 1];
+      std::uint32_t bit = 63;
+      while (((word >> bit) & 1) == 0) {
+        bit--;
+      }
+      return static_cast<std::uint16_t>((index - 1) * 64 + bit);
+    }
+    default:
+      return static_cast<std::uint16_t>(
+          container.values[container.values.size() - 2] +
+              container.values.back());
+  }
+}
+
+void AndContainers(const Container& container1, const Container& container2,
+                   Container& output) {
+  const Container* smaller = &container1;
+  const Container* larger = &container2;
+  if (larger->type == ContainerType::ARRAY &&
+      (smaller->type != ContainerType::ARRAY ||
+          larger->cardinality < smaller->cardinality)) {
+    std::swap(smaller, larger);
+  }
+
+  if (smaller->type == ContainerType::ARRAY) {
+    // Only the values of the sparse side have to be looked up
+    output.type = ContainerType::ARRAY;
+    if (larger->type == ContainerType::ARRAY) {
+      auto pos = larger->values.begin();
+      for (auto low : smaller->values) {
+        pos = std::lower_bound(pos, larger->values.end(), low);
+        if (pos == larger->values.end()) {
+          break;
+        }
+        if (*pos == low) {
+          output.values.push_back(low);
+        }
+      }
+    } else {
+      for (auto low : smaller->values) {
+        if (ContainsLow(*larger, low)) {
+          output.values.push_back(low);
+        }
+      }
+    }
+    output.cardinality = static_cast<std::uint32_t>(output.values.size());
+    return;
+  }
+
+  std::vector<std::uint64_t> words1, words2;
+  ToBitset(container1, words1);
+  ToBitset(container2, words2);
+  for (std::size_t i = 0; i < words1.size(); i++) {
+    words1[i] &= words2[i];
+  }
+  FromBitset(words1, output);
+}
+
+void OrContainers(const Container& container1, const Container& container2,
+                  Container& output) {
+  if (container1.type == ContainerType::ARRAY &&
+      container2.type == ContainerType::ARRAY &&
+      container1.cardinality + container2.cardinality <=
+          RoaringBitmap::ARRAY_MAX_SIZE) {
+    output.type = ContainerType::ARRAY;
+    std::set_union(container1.values.begin(), container1.values.end(),
+                   container2.values.begin(), container2.values.end(),
+                   std::back_inserter(output.values));
+    output.cardinality = static_cast<std::uint32_t>(output.values.size());
+    return;
+  }
+
+  std::vector<std::uint64_t> words1, words2;
+  ToBitset(container1, words1);
+  ToBitset(container2, words2);
+  for (std::size_t i = 0; i < words1.size(); i++) {
+    words1[i] |= words2[i];
+  }
+  FromBitset(words1, output);
+}
+} // namespace
+
+RoaringBitmap::ConstIterator::ConstIterator(const RoaringBitmap* bitmap,
+                                            std::size_t containerIndex)
+    : m_bitmap(bitmap), m_containerIndex(containerIndex), m_index(0),
+      m_runOffset(0), m_current(0) {
+  SeekContainer();
+}
+
+void RoaringBitmap::ConstIterator::SeekContainer() {
+  if (m_containerIndex >= m_bitmap->m_containers.size()) {
+    m_current = 0;
+    return;
+  }
+
+  auto& container = m_bitmap->m_containers[m_containerIndex];
+  auto base = m_bitmap->m_keys[m_containerIndex] << 16;
+  switch (container.type) {
+    case ContainerType::ARRAY:
+      m_current = base + container.values[m_index];
+      break;
+    case ContainerType::BITSET:
+      m_index = NextSetBit(container.words, m_index);
+      m_current = base + m_index;
+      break;
+    default:
+      m_current = base + container.values[m_index * 2] + m_runOffset;
+      break;
+  }
+}
+
+RoaringBitmap::ConstIterator& RoaringBitmap::ConstIterator::operator++() {
+  auto& container = m_bitmap->m_containers[m_containerIndex];
+  bool containerDone;
+  switch (container.type) {
+    case ContainerType::ARRAY:
+      m_index++;
+      containerDone = m_index >= container.values.size();
+      break;
+    case ContainerType::BITSET:
+      m_index = NextSetBit(container.words, m_index + 1);
+      containerDone = m_index >= CONTAINER_SIZE_IN_BITS;
+      break;
+    default:
+      m_runOffset++;
+      if (m_runOffset > container.values[m_index * 2 + 1]) {
+        m_index++;
+        m_runOffset = 0;
+      }
+      containerDone = m_index * 2 >= container.values.size();
+      break;
+  }
+
+  if (containerDone) {
+    m_containerIndex++;
+    m_index = 0;
+    m_runOffset = 0;
+  }
+  SeekContainer();
+  return *this;
+}
+
+std::size_t RoaringBitmap::ConstIterator::Decode(std::uint64_t* positions,
+                                                std::size_t capacity) {
+  std::size_t count = 0;
+  while (count < capacity &&
+      m_containerIndex < m_bitmap->m_containers.size()) {
+    auto& container = m_bitmap->m_containers[m_containerIndex];
+    auto base = m_bitmap->m_keys[m_containerIndex] << 16;
+    bool containerDone;
+    switch (container.type) {
+      case ContainerType::ARRAY: {
+        auto n = std::min<std::size_t>(capacity - count,
+                                       container.values.size() - m_index);
+        auto values = container.values.data() + m_index;
+        for (std::size_t i = 0; i < n; i++) {
+          positions[count + i] = base + values[i];
+        }
+        count += n;
+        m_index += static_cast<std::uint32_t>(n);
+        containerDone = m_index >= container.values.size();
+        break;
+      }
+      case ContainerType::BITSET: {
+        // m_index is a set bit, clear the bits before it
+        std::size_t wordIndex = m_index / 64;
+        auto word = container.words[wordIndex] &
+            (~std::uint64_t(0) << (m_index % 64));
+        while (count < capacity) {
+          while (word == 0 && ++wordIndex < container.words.size()) {
+            word = container.words[wordIndex];
+          }
+          if (word == 0) {
+            break;
+          }
+          positions[count++] = base + wordIndex * 64 + TrailingZeros(word);
+          word &= word - 1;
+        }
+
+        if (word != 0) {
+          m_index = static_cast<std::uint32_t>(wordIndex * 64 +
+              TrailingZeros(word));
+        } else {
+          m_index = NextSetBit(container.words,
+                               static_cast<std::uint32_t>(
+                                   std::min<std::size_t>(
+                                       (wordIndex + 1) * 64,
+                                       CONTAINER_SIZE_IN_BITS)));
+        }
+        containerDone = m_index >= CONTAINER_SIZE_IN_BITS;
+        break;
+      }
+      default: {
+        while (count < capacity && m_index * 2 < container.values.size()) {
+          auto start = base + container.values[m_index * 2];
+          std::uint32_t runLength =
+              std::uint32_t(container.values[m_index * 2 + 1]) + 1;
+          auto n = std::min<std::size_t>(capacity - count,
+                                         runLength - m_runOffset);
+          for (std::size_t i = 0; i < n; i++) {
+            positions[count + i] = start + m_runOffset + i;
+          }
+          count += n;
+          m_runOffset += static_cast<std::uint32_t>(n);
+          if (m_runOffset == runLength) {
+            m_index++;
+            m_runOffset = 0;
+          }
+        }
+        containerDone = m_index * 2 >= container.values.size();
+        break;
+      }
+    }
+
+    if (containerDone) {
+      m_containerIndex++;
+      m_index = 0;
+      m_runOffset = 0;
+    }
+    SeekContainer();
+  }
+
+  return count;
+}
+
+RoaringBitmap::Container& RoaringBitmap::GetContainer(std::uint64_t key) {
+  // Positions mostly arrive in increasing order
+  if (m_keys.empty() || m_keys.back() < key) {
+    m_keys.push_back(key);
+    m_containers.emplace_back();
+    return m_containers.back();
+  }
+
+  auto iter = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+  auto index = iter - m_keys.begin();
+  if (*iter != key) {
+    m_keys.insert(iter, key);
+    m_containers.emplace(m_containers.begin() + index);
+  }
+  return m_containers[index];
+}
+
+void RoaringBitmap::Add(std::uint64_t x) {
+  auto& container = GetContainer(x >> 16);
+  auto low = static_cast<std::uint16_t>(x & 0xFFFF);
+  m_sizeInBits = std::max(m_sizeInBits, x + 1);
+
+  if (container.type == ContainerType::RUN) {
+    if (ContainsLow(container, low)) {
+      return;
+    }
+    std::vector<std::uint64_t> words;
+    ToBitset(container, words);
+    container.type = ContainerType::BITSET;
+    container.values.clear();
+    container.words.swap(words);
+  }
+
+  if (container.type == ContainerType::BITSET) {
+    auto& word = container.words[low / 64];
+    auto mask = std::uint64_t(1) << (low % 64);
+    if ((word & mask) == 0) {
+      word |= mask;
+      container.cardinality++;
+      m_count++;
+    }
+    return;
+  }
+
+  auto& values = container.values;
+  if (values.empty() || values.back() < low) {
+    values.push_back(low);
+  } else {
+    auto iter = std::lower_bound(values.begin(), values.end(), low);
+    if (*iter == low) {
+      return;
+    }
+    values.insert(iter, low);
+  }
+
+  container.cardinality++;
+  m_count++;
+  if (container.cardinality > ARRAY_MAX_SIZE) {
+    std::vector<std::uint64_t> words;
+    ToBitset(container, words);
+    container.type = ContainerType::BITSET;
+    container.values.clear();
+    container.words.swap(words);
+  }
+}
+
+void RoaringBitmap::AddWords(std::uint64_t offset, const std::uint64_t* words,
+                             std::size_t count) {
+  for (std::size_t i = 0; i < count; i++) {
+    auto word = words[i];
+    auto position = offset + i * 64;
+    if (word == 0) {
+      continue;
+    }
+
+    auto& container = GetContainer(position >> 16);
+    if (container.type == ContainerType::BITSET) {
+      auto& target = container.words[(position & 0xFFFF) / 64];
+      auto added = PopCount(word & ~target);
+      container.cardinality += added;
+      m_count += added;
+      target |= word;
+      continue;
+    }
+
+    while (word != 0) {
+      Add(position + TrailingZeros(word));
+      word &= word - 1;
+    }
+  }
+
+  m_sizeInBits = std::max(m_sizeInBits, offset + count * 64);
+}
+
+bool RoaringBitmap::Contains(std::uint64_t x) const {
+  auto iter = std::lower_bound(m_keys.begin(), m_keys.end(), x >> 16);
+  if (iter == m_keys.end() || *iter != (x >> 16)) {
+    return false;
+  }
+  return ContainsLow(m_containers[iter - m_keys.begin()],
+                     static_cast<std::uint16_t>(x & 0xFFFF));
+}
+
+std::size_t RoaringBitmap::GetSizeInBytes() const {
+  std::size_t size = m_keys.size() * sizeof(std::uint64_t);
+  for (auto& container : m_containers) {
+    size += container.values.size() * sizeof(std::uint16_t) +
+        container.words.size() * sizeof(std::uint64_t);
+  }
+  return size;
+}
+
+void RoaringBitmap::RunOptimize() {
+  std::vector<std::uint16_t> runs;
+  for (auto& container : m_containers) {
+    if (container.type == ContainerType::RUN) {
+      continue;
+    }
+
+    runs.clear();
+    std::uint32_t previous = 0;
+    auto addValue = [&](std::uint32_t low) {
+      if (!runs.empty() && low == previous + 1) {
+        runs.back()++;
+      } else {
+        runs.push_back(static_cast<std::uint16_t>(low));
+        runs.push_back(0);
+      }
+      previous = low;
+    };
+
+    if (container.type == ContainerType::ARRAY) {
+      for (auto low : container.values) {
+        addValue(low);
+      }
+    } else {
+      for (auto low = NextSetBit(container.words, 0);
+           low < CONTAINER_SIZE_IN_BITS;
+           low = NextSetBit(container.words, low + 1)) {
+        addValue(low);
+      }
+    }
+
+    auto currentSize = container.values.size() * sizeof(std::uint16_t) +
+        container.words.size() * sizeof(std::uint64_t);
+    if (runs.size() * sizeof(std::uint16_t) < currentSize) {
+      container.type = ContainerType::RUN;
+      container.values = runs;
+      container.words.clear();
+      container.words.shrink_to_fit();
+    }
+  }
+}
+
+void RoaringBitmap::OrInto(std::uint64_t* words, std::size_t count) const {
+  for (std::size_t i = 0; i < m_containers.size(); i++) {
+    auto& container = m_containers[i];
+    auto base = m_keys[i] * BITSET_WORDS;
+    if (base >= count) {
+      break;
+    }
+
+    auto target = words + base;
+    auto available = std::min<std::uint64_t>(std::uint64_t(BITSET_WORDS), count - base);
+    switch (container.type) {
+      case ContainerType::ARRAY:
+        for (auto low : container.values) {
+          if (low / 64 < available) {
+            target[low / 64] |= std::uint64_t(1) << (low % 64);
+          }
+        }
+        break;
+      case ContainerType::BITSET:
+        for (std::size_t j = 0; j < available; j++) {
+          target[j] |= container.words[j];
+        }
+        break;
+      default:
+        for (std::size_t j = 0; j < container.values.size(); j += 2) {
+          std::uint32_t last = std::uint32_t(container.values[j]) +
+              container.values[j + 1];
+          for (std::uint32_t low = container.values[j];
+               low <= last && low / 64 < available; low++) {
+            target[low / 64] |= std::uint64_t(1) << (low % 64);
+          }
+        }
+        break;
+    }
+  }
+}
+
+void RoaringBitmap::And(const RoaringBitmap& bitmap1,
+                        const RoaringBitmap& bitmap2,
+                        RoaringBitmap& output) {
+  RoaringBitmap result;
+  std::size_t i = 0, j = 0;
+  while (i < bitmap1.m_keys.size() && j < bitmap2.m_keys.size()) {
+    if (bitmap1.m_keys[i] < bitmap2.m_keys[j]) {
+      i++;
+    } else if (bitmap2.m_keys[j] < bitmap1.m_keys[i]) {
+      j++;
+    } else {
+      Container container;
+      AndContainers(bitmap1.m_containers[i], bitmap2.m_containers[j],
+                    container);
+      if (container.cardinality > 0) {
+        result.m_count += container.cardinality;
+        result.m_keys.push_back(bitmap1.m_keys[i]);
+        result.m_containers.push_back(std::move(container));
+      }
+      i++;
+      j++;
+    }
+  }
+
+  if (!result.m_keys.empty()) {
+    result.m_sizeInBits = (result.m_keys.back() << 16) +
+        MaxLow(result.m_containers.back()) + 1;
+  }
+  output = std::move(result);
+}
+
+void RoaringBitmap::Or(const RoaringBitmap& bitmap1,
+                       const RoaringBitmap& bitmap2,
+                       RoaringBitmap& output) {
+  RoaringBitmap result;
+  std::size_t i = 0, j = 0;
+  while (i < bitmap1.m_keys.size() || j < bitmap2.m_keys.size()) {
+    if (j == bitmap2.m_keys.size() ||
+        (i < bitmap1.m_keys.size() && bitmap1.m_keys[i] < bitmap2.m_keys[j])) {
+      result.m_count += bitmap1.m_containers[i].cardinality;
+      result.m_keys.push_back(bitmap1.m_keys[i]);
+      result.m_containers.push_back(bitmap1.m_containers[i]);
+      i++;
+    } else if (i == bitmap1.m_keys.size() ||
+        bitmap2.m_keys[j] < bitmap1.m_keys[i]) {
+      result.m_count += bitmap2.m_containers[j].cardinality;
+      result.m_keys.push_back(bitmap2.m_keys[j]);
+      result.m_containers.push_back(bitmap2.m_containers[j]);
+      j++;
+    } else {
+      Container container;
+      OrContainers(bitmap1.m_containers[i], bitmap2.m_containers[j],
+                   container);
+      result.m_count += container.cardinality;
+      result.m_keys.push_back(bitmap1.m_keys[i]);
+      result.m_containers.push_back(std::move(container));
+      i++;
+      j++;
+    }
+  }
+
+  result.m_sizeInBits = std::max(bitmap1.m_sizeInBits, bitmap2.m_sizeInBits);
+  output = std::move(result);
+}
+
+RoaringBitmap::ConstIterator RoaringBitmap::begin() const {
+  return ConstIterator(this, 0);
+}
+
+RoaringBitmap::ConstIterator RoaringBitmap::end() const {
+  return ConstIterator(this, m_containers.size());
+}
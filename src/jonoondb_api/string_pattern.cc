@@ -0,0 +1,253 @@
+#include <cstdio>
+#include <algorithm>
+#include "string_pattern.h"
+#include "constraint.h"
+#include "enums.h"
+
+using namespace jonoondb_api;
+
+namespace {
+// Reads one UTF-8 character, invalid sequences are read byte by byte
+std::uint32_t ReadChar(const std::string& str, std::size_t& pos,
+                       std::size_t end) {
+  auto c = static_cast<unsigned char>(str[pos++]);
+  if (c < 0xC0) {
+    return c;
+  }
+
+  int extra = c >= 0xF0 ? 3 : (c >= 0xE0 ? 2 : 1);
+  std::uint32_t val = c & (0x3F >> extra);
+  while (extra-- > 0 && pos < end &&
+      (static_cast<unsigned char>(str[pos]) & 0xC0) == 0x80) {
+    val = (val << 6) | (static_cast<unsigned char>(str[pos++]) & 0x3F);
+  }
+
+  return val;
+}
+
+// LIKE only folds the case of ASCII characters
+std::uint32_t FoldCase(std::uint32_t c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+bool IsAsciiLetter(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// Converts the operand the same way SQLite converts numbers to text
+std::string GetPatternString(const Constraint& constraint) {
+  if (constraint.operandType == OperandType::INTEGER) {
+    return std::to_string(constraint.operand.int64Val);
+  } else if (constraint.operandType == OperandType::DOUBLE) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.15g",
+                  constraint.operand.doubleVal);
+    std::string str = buffer;
+    if (str.find_first_of(".ni") == std::string::npos) {
+      auto exponentPos = str.find('e');
+      str.insert(exponentPos == std::string::npos ? str.size() : exponentPos,
+                 ".0");
+    }
+    return str;
+  } else if (constraint.operandType == OperandType::STRING) {
+    return constraint.strVal;
+  }
+
+  return std::string(constraint.blobVal.GetData(),
+                     constraint.blobVal.GetLength());
+}
+}  // namespace
+
+StringPattern::StringPattern(const Constraint& constraint)
+    : m_pattern(GetPatternString(constraint)),
+      m_isLike(constraint.op == IndexConstraintOperator::LIKE) {
+  // SQLite reads the pattern as a C string
+  m_pattern.resize(std::min(m_pattern.find('\0'), m_pattern.size()));
+  auto wildcards = m_isLike ? "%_" : "*?[";
+  auto prefixSize = std::min(m_pattern.find_first_of(wildcards),
+                             m_pattern.size());
+  auto prefix = m_pattern.substr(0, prefixSize);
+  auto rest = m_pattern.substr(prefixSize);
+
+  // Upper case letters sort before lower case letters so for LIKE the
+  // range goes from the all upper case to the all lower case prefix
+  m_lowerBound = prefix;
+  auto upperPrefix = prefix;
+  bool hasLetters = false;
+  if (m_isLike) {
+    for (std::size_t i = 0; i < prefix.size(); i++) {
+      if (IsAsciiLetter(prefix[i])) {
+        hasLetters = true;
+        m_lowerBound[i] = static_cast<char>(prefix[i] & ~0x20);
+        upperPrefix[i] = static_cast<char>(prefix[i] | 0x20);
+      }
+    }
+  }
+
+  if (rest.empty()) {
+    // The smallest string greater than the prefix
+    m_upperBound = upperPrefix + std::string(1, '\0');
+    m_hasUpperBound = true;
+  } else {
+    // The smallest string greater than all strings starting with the prefix
+    m_upperBound = upperPrefix;
+    while (!m_upperBound.empty() &&
+        static_cast<unsigned char>(m_upperBound.back()) == 0xFF) {
+      m_upperBound.pop_back();
+    }
+    m_hasUpperBound = !m_upperBound.empty();
+    if (m_hasUpperBound) {
+      m_upperBound.back() = static_cast<char>(m_upperBound.back() + 1);
+    }
+  }
+
+  auto matchAll = m_isLike ? '%' : '*';
+  m_isExact = !hasLetters &&
+      std::all_of(rest.begin(), rest.end(),
+                  [matchAll](char c) { return c == matchAll; });
+}
+
+bool StringPattern::Matches(const std::string& str) const {
+  auto matchAll = m_isLike ? '%' : '*';
+  // SQLite compares the values as C strings
+  auto strEnd = std::min(str.find('\0'), str.size());
+  std::size_t patternPos = 0, strPos = 0;
+  std::size_t starPatternPos = std::string::npos, starStrPos = 0;
+
+  while (true) {
+    if (patternPos < m_pattern.size() && m_pattern[patternPos] == matchAll) {
+      while (patternPos < m_pattern.size() &&
+          m_pattern[patternPos] == matchAll) {
+        patternPos++;
+      }
+      if (patternPos == m_pattern.size()) {
+        return true;
+      }
+      starPatternPos = patternPos;
+      starStrPos = strPos;
+      continue;
+    }
+
+    if (strPos == strEnd) {
+      return patternPos == m_pattern.size();
+    }
+
+    if (patternPos < m_pattern.size()) {
+      auto nextPatternPos = patternPos;
+      auto nextStrPos = strPos;
+      if (MatchOne(nextPatternPos, str, nextStrPos, strEnd)) {
+        patternPos = nextPatternPos;
+        strPos = nextStrPos;
+        continue;
+      }
+    }
+
+    if (starPatternPos == std::string::npos) {
+      return false;
+    }
+
+    // Let the last wildcard consume one more character
+    ReadChar(str, starStrPos, strEnd);
+    patternPos = starPatternPos;
+    strPos = starStrPos;
+  }
+}
+
+std::vector<std::string> StringPattern::GetLiterals() const {
+  std::vector<std::string> literals;
+  std::string literal;
+  std::size_t pos = 0;
+  while (pos < m_pattern.size()) {
+    auto c = m_pattern[pos++];
+    bool isWildcard = m_isLike ? (c == '%' || c == '_') :
+        (c == '*' || c == '?' || c == '[');
+    if (!isWildcard) {
+      literal.push_back(c);
+      continue;
+    }
+
+    if (!literal.empty()) {
+      literals.push_back(std::move(literal));
+      literal.clear();
+    }
+
+    if (c == '[') {
+      // Skip the set, a ] right after [ or [^ is part of it
+      if (pos < m_pattern.size() && m_pattern[pos] == '^') {
+        pos++;
+      }
+      if (pos < m_pattern.size() && m_pattern[pos] == ']') {
+        pos++;
+      }
+      pos = std::min(m_pattern.find(']', pos), m_pattern.size());
+      pos++;
+    }
+  }
+
+  if (!literal.empty()) {
+    literals.push_back(std::move(literal));
+  }
+
+  return literals;
+}
+
+bool StringPattern::MatchOne(std::size_t& patternPos, const std::string& str,
+                             std::size_t& strPos, std::size_t strEnd) const {
+  auto patternChar = ReadChar(m_pattern, patternPos, m_pattern.size());
+  auto c = ReadChar(str, strPos, strEnd);
+  if (patternChar == (m_isLike ? '_' : '?')) {
+    return true;
+  }
+
+  if (m_isLike) {
+    return FoldCase(patternChar) == FoldCase(c);
+  }
+
+  if (patternChar == '[') {
+    return MatchSet(patternPos, c);
+  }
+
+  return patternChar == c;
+}
+
+// Matches c against the set that starts at patternPos, right after the [.
+// Follows the rules of SQLite: ^ inverts the set, a ] right after [ or [^
+// is part of the set and a-z is a range.
+bool StringPattern::MatchSet(std::size_t& patternPos, std::uint32_t c) const {
+  auto end = m_pattern.size();
+  if (patternPos == end) {
+    return false;
+  }
+
+  bool seen = false, invert = false;
+  std::uint32_t prior = 0;
+  auto setChar = ReadChar(m_pattern, patternPos, end);
+  if (setChar == '^') {
+    invert = true;
+    setChar = patternPos < end ? ReadChar(m_pattern, patternPos, end) : 0;
+  }
+  if (setChar == ']') {
+    seen = c == ']';
+    setChar = patternPos < end ? ReadChar(m_pattern, patternPos, end) : 0;
+  }
+
+  while (setChar != 0 && setChar != ']') {
+    if (setChar == '-' && patternPos < end && m_pattern[patternPos] != ']' &&
+        prior > 0) {
+      setChar = ReadChar(m_pattern, patternPos, end);
+      if (c >= prior && c <= setChar) {
+        seen = true;
+      }
+      prior = 0;
+    } else {
+      if (c == setChar) {
+        seen = true;
+      }
+      prior = setChar;
+    }
+    setChar = patternPos < end ? ReadChar(m_pattern, patternPos, end) : 0;
+  }
+
+  // An unterminated set never matches
+  return setChar == ']' && seen != invert;
+}
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <map>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/cmdline.hpp>
@@ -29,6 +30,17 @@ using namespace jonoondb_api;
 using namespace jonoondb_utils;
 using namespace boost::filesystem;
 
+// Index types that can be specified in an INDEX_FILE
+const std::map<std::string, IndexType> g_indexTypes = {
+    {"EWAH_COMPRESSED_BITMAP", IndexType::EWAH_COMPRESSED_BITMAP},
+    {"VECTOR", IndexType::VECTOR},
+    {"BIT_SLICED", IndexType::BIT_SLICED},
+    {"SORTED", IndexType::SORTED},
+    {"HASH", IndexType::HASH},
+    {"UNIQUE_HASH", IndexType::UNIQUE_HASH},
+    {"TRIGRAM", IndexType::TRIGRAM},
+    {"FULL_TEXT", IndexType::FULL_TEXT}};
+
 void PrintResultSet(ResultSetImpl& rs) {
   std::int32_t colCount = rs.GetColumnCount();
   vector<size_t> columnWidths(colCount, 0);
@@ -228,22 +240,12 @@ int StartJonoonDBCLI(string dbName, string dbPath) {
                 boost::trim(tok);
               }
 
-              if (idxTokens[1] == "EWAH_COMPRESSED_BITMAP") {
-                bool isAscending = false;
-                if (boost::iequals("ASC", idxTokens[3])) {
-                  isAscending = true;
-                }
+              auto indexType = g_indexTypes.find(idxTokens[1]);
+              if (indexType != g_indexTypes.end()) {
+                bool isAscending = boost::iequals("ASC", idxTokens[3]);
                 indexes.push_back(IndexInfoImpl(idxTokens[0],
-                                            IndexType::EWAH_COMPRESSED_BITMAP,
-                                            idxTokens[2],
-                                            isAscending));
-              } else if (idxTokens[1] == "VECTOR") {
-                bool isAscending = false;
-                if (boost::iequals("ASC", idxTokens[3])) {
-                  isAscending = true;
-                }
-                indexes.push_back(IndexInfoImpl(idxTokens[0], IndexType::VECTOR,
-                                            idxTokens[2], isAscending));
+                                                indexType->second,
+                                                idxTokens[2], isAscending));
               } else {
                 ostringstream ss;
                 ss << "Unknown index type \"" << idxTokens[1]
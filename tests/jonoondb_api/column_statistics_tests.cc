@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "flatbuffers/flatbuffers.h"
+#include "test_utils.h"
+#include "tweet_generated.h"
+#include "column_statistics.h"
+#include "constraint.h"
+#include "document.h"
+#include "document_factory.h"
+#include "document_schema.h"
+#include "document_schema_factory.h"
+#include "buffer_impl.h"
+#include "index_info_impl.h"
+#include "index_stat.h"
+#include "indexer.h"
+#include "indexer_factory.h"
+#include "enums.h"
+#include "file.h"
+#include "null_helpers.h"
+
+using namespace std;
+using namespace flatbuffers;
+using namespace jonoondb_api;
+using namespace jonoondb_test;
+
+namespace {
+// Every third tweet has no user so its user.id is null, the others have
+// 50 distinct user ids, half of them negative
+std::vector<std::unique_ptr<Document>> GetTweets(
+    const DocumentSchema& schema, std::vector<BufferImpl>& buffers) {
+  for (int i = 0; i < 300; i++) {
+    FlatBufferBuilder fbb;
+    if (i % 3 == 0) {
+      fbb.Finish(CreateTweet(fbb, i, 0, 0, i));
+    } else {
+      fbb.Finish(CreateTweet(fbb, i, 0, CreateUser(fbb, 0, i % 50 - 25), i));
+    }
+    buffers.push_back(BufferImpl((char*)fbb.GetBufferPointer(),
+                                 fbb.GetSize(), fbb.GetSize()));
+  }
+
+  std::vector<std::unique_ptr<Document>> documents;
+  for (auto& buffer : buffers) {
+    documents.push_back(DocumentFactory::CreateDocument(schema, buffer));
+  }
+  return documents;
+}
+}
+
+TEST(ColumnStatistics, AddValue_NullSentinels) {
+  ColumnStatistics statistics;
+  statistics.AddValue(JONOONDB_NULL_INT64);
+  statistics.AddValue(JONOONDB_NULL_DOUBLE);
+  statistics.AddValue(JONOONDB_NULL_STR);
+  statistics.AddValue(std::int64_t(5));
+  ASSERT_EQ(statistics.GetDocumentCount(), 4);
+  ASSERT_EQ(statistics.GetNullCount(), 3);
+  ASSERT_EQ(statistics.GetDistinctCount(), 1);
+}
+
+TEST(ColumnStatistics, EWAHIndexer_MissingSubDocument) {
+  string schema = File::Read(GetSchemaFilePath("tweet.bfbs"));
+  shared_ptr<DocumentSchema> documentSchema(
+      DocumentSchemaFactory::CreateDocumentSchema(schema,
+                                                  SchemaType::FLAT_BUFFERS));
+  std::vector<BufferImpl> buffers;
+  auto documents = GetTweets(*documentSchema, buffers);
+
+  // The first half goes through Insert and the rest through BulkInsert
+  IndexInfoImpl indexInfo("IndexName1", IndexType::EWAH_COMPRESSED_BITMAP,
+                          "user.id", true);
+  std::unique_ptr<Indexer> indexer(
+      IndexerFactory::CreateIndexer(indexInfo, FieldType::BASE_TYPE_INT64));
+  for (std::size_t i = 0; i < 150; i++) {
+    indexer->Insert(i, *documents[i]);
+  }
+  std::vector<std::unique_ptr<Document>> bulkDocuments;
+  for (std::size_t i = 150; i < documents.size(); i++) {
+    bulkDocuments.push_back(std::move(documents[i]));
+  }
+  indexer->BulkInsert(150, bulkDocuments);
+  indexer->FinalizeBulkInsert();
+
+  auto& statistics = indexer->GetIndexStats().GetStatistics();
+  ASSERT_EQ(statistics.GetDocumentCount(), 300);
+  ASSERT_EQ(statistics.GetNullCount(), 100);
+  ASSERT_NEAR(statistics.GetDistinctCount(), 50, 5);
+
+  // A third of the documents have a negative user.id, nulls never match
+  Constraint constraint("user.id", IndexConstraintOperator::LESS_THAN);
+  constraint.operandType = OperandType::INTEGER;
+  constraint.operand.int64Val = 0;
+  ASSERT_NEAR(statistics.EstimateSelectivity(constraint), 1.0 / 3, 0.1);
+}
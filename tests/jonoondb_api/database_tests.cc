@@ -1,6 +1,8 @@
 #include <string>
 #include <fstream>
 #include <cstdio>
+#include <algorithm>
+#include <functional>
 #include "gtest/gtest.h"
 #include "flatbuffers/flatbuffers.h"
 #include "test_utils.h"
@@ -224,6 +226,21 @@ vector<IndexInfo> CreateAllTypeIndexes(IndexType indexType) {
   return indexes;
 }
 
+vector<IndexInfo> CreateAllNumericTypeIndexes(IndexType indexType) {
+  auto indexes = CreateAllTypeIndexes(indexType);
+  // field11, field12 and field13 are string and blob fields
+  indexes.erase(std::remove_if(indexes.begin(), indexes.end(),
+                               [](const IndexInfo& index) {
+                                 std::string name = index.GetColumnName();
+                                 return name.size() > 2 &&
+                                     (name.compare(name.size() - 2, 2, "11") == 0 ||
+                                      name.compare(name.size() - 2, 2, "12") == 0 ||
+                                      name.compare(name.size() - 2, 2, "13") == 0);
+                               }),
+                indexes.end());
+  return indexes;
+}
+
 void Execute_Insert_AllIndexTypes_Test(const std::string& dbName,
                                        IndexType indexType, bool nullifyNestedField) {
   string collectionName = "CollectionName";
@@ -870,6 +887,64 @@ TEST(Database, ExecuteSelect_LT_LTE_VECTORIndexed) {
   Execute_ExecuteSelect_LT_LTE_Test(db, indexes);
 }
 
+TEST(Database, ExecuteSelect_VECTORIndexed_Float32Bounds) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_VECTORIndexed_Float32Bounds",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("all_field_type.bfbs");
+  string schema = File::Read(filePath);
+  // float32 values are indexed as float, the double operands have to be
+  // rounded the right way. Compare with a collection that has no index.
+  std::vector<IndexInfo> indexes{IndexInfo("IndexName1", IndexType::VECTOR,
+                                           "field8", true)};
+  db.CreateCollection("indexed", SchemaType::FLAT_BUFFERS, schema, indexes);
+  db.CreateCollection("not_indexed", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  std::vector<Buffer> documents;
+  for (size_t i = 0; i < 100; i++) {
+    std::string str = std::to_string(i);
+    documents.push_back(TestUtils::GetAllFieldTypeObjectBuffer(0, 0, true, 0, 0, 0, 0,
+                                                               i * 0.1f,
+                                                               0, 0.0, str, str, str));
+  }
+  db.MultiInsert("indexed", documents);
+  db.MultiInsert("not_indexed", documents);
+
+  auto count = [&db](const std::string& collection, const std::string& where) {
+    auto rs = db.ExecuteSelect("SELECT field8 FROM " + collection + " WHERE " +
+        where + ";");
+    int rowCount = 0;
+    while (rs.Next()) {
+      rowCount++;
+    }
+    return rowCount;
+  };
+
+  std::vector<std::string> predicates{
+      "field8 = 0.1", "field8 <= 0.1", "field8 < 0.1", "field8 > 0.1",
+      "field8 >= 0.1", "field8 >= 0.5", "field8 > 0.5", "field8 < 2",
+      "field8 > 1e300", "field8 < -1e300", "field8 > 0.3 AND field8 <= 0.7",
+      "field8 = 3.4000000953674316"};
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(count("not_indexed", predicate), count("indexed", predicate))
+        << predicate;
+  }
+}
+
+TEST(Database, ExecuteSelect_LT_LTE_BitSlicedIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_LT_LTE_BitSlicedIndexed",
+              TestUtils::GetDefaultDBOptions());
+  auto indexes = CreateAllNumericTypeIndexes(IndexType::BIT_SLICED);
+  Execute_ExecuteSelect_LT_LTE_Test(db, indexes);
+}
+
+TEST(Database, ExecuteSelect_LT_LTE_SortedIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_LT_LTE_SortedIndexed",
+              TestUtils::GetDefaultDBOptions());
+  auto indexes = CreateAllNumericTypeIndexes(IndexType::SORTED);
+  Execute_ExecuteSelect_LT_LTE_Test(db, indexes);
+}
+
 void Execute_ExecuteSelect_GT_GTE_Test(Database& db,
                                        const vector<IndexInfo>& indexes) {
   string filePath = GetSchemaFilePath("all_field_type.bfbs");
@@ -1013,6 +1088,20 @@ TEST(Database, ExecuteSelect_GT_GTE_VECTORIndexed) {
   Execute_ExecuteSelect_GT_GTE_Test(db, indexes);
 }
 
+TEST(Database, ExecuteSelect_GT_GTE_BitSlicedIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_GT_GTE_BitSlicedIndexed",
+              TestUtils::GetDefaultDBOptions());
+  auto indexes = CreateAllNumericTypeIndexes(IndexType::BIT_SLICED);
+  Execute_ExecuteSelect_GT_GTE_Test(db, indexes);
+}
+
+TEST(Database, ExecuteSelect_GT_GTE_SortedIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_GT_GTE_SortedIndexed",
+              TestUtils::GetDefaultDBOptions());
+  auto indexes = CreateAllNumericTypeIndexes(IndexType::SORTED);
+  Execute_ExecuteSelect_GT_GTE_Test(db, indexes);
+}
+
 TEST(Database, ExecuteSelect_VECTORIndexed_DoubleExpression) {
   Database db(g_TestRootDirectory,
               "ExecuteSelect_VECTORIndexed_DoubleExpression",
@@ -1247,6 +1336,452 @@ TEST(Database, ExecuteSelect_VECTORIndexed_Range) {
   ValidateTweetResultSet(db, 4, 7, "rating", ">", "3.0", "rating", "<", "7.0");
 }
 
+TEST(Database, ExecuteSelect_VECTORIndexed_WordBoundaries) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_VECTORIndexed_WordBoundaries",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo>
+      indexes{IndexInfo("IndexName1", IndexType::VECTOR, "id", true),
+              IndexInfo("IndexName2", IndexType::VECTOR, "rating", true),
+              IndexInfo("IndexName3", IndexType::VECTOR, "user.id", true)};
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  // The vector indexers scan 64 documents at a time, use a document count
+  // that does not fill the last word
+  const int docCount = 5000;
+  std::vector<Buffer> documents;
+  for (int i = 0; i < docCount; i++) {
+    std::string name = "zarian_" + std::to_string(i);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(i,
+                                        i,
+                                        &name,
+                                        &text,
+                                        static_cast<double>(i),
+                                        &binData));
+  }
+  db.MultiInsert("tweet", documents);
+
+  ValidateTweetResultSet(db, 63, 129, "id", ">=", "63", "id", "<=", "128");
+  ValidateTweetResultSet(db, 64, 4999, "id", ">", "63", "id", "<", "4999");
+  ValidateTweetResultSet(db, 0, 5000, "id", ">", "-100", "id", "<", "100000");
+  ValidateTweetResultSet(db, 1000, 4001, "id", ">=", "1000.0", "id", "<=", "4000.0");
+  ValidateTweetResultSet(db, 1000, 1001, "id", ">=", "999.5", "id", "<", "1000.5");
+  ValidateTweetResultSet(db, 4990, 4991, "id", "=", "4990", "id", "=", "4990.0");
+  ValidateTweetResultSet(db, 0, 0, "id", ">", "2", "id", "<", "1");
+
+  ValidateTweetResultSet(db, 3, 4999, "[user.id]", ">", "2", "[user.id]", "<", "4999");
+  ValidateTweetResultSet(db, 127, 4097, "[user.id]", ">=", "127.0", "[user.id]", "<=", "4096.0");
+
+  ValidateTweetResultSet(db, 10, 4990, "rating", ">=", "9.5", "rating", "<=", "4989.0");
+  ValidateTweetResultSet(db, 4990, 4991, "rating", "=", "4990", "rating", "=", "4990.0");
+  ValidateTweetResultSet(db, 4095, 4097, "rating", ">", "4094", "rating", "<", "4097");
+
+  // The first zone of 4096 documents can be skipped and the last one fully
+  // matches
+  ValidateTweetResultSet(db, 4096, 5000, "id", ">=", "4096", "id", "<", "5000");
+  ValidateTweetResultSet(db, 4096, 5000, "rating", ">", "4095.5", "rating", "<=", "5000");
+}
+
+TEST(Database, ExecuteSelect_VECTORIndexed_StringDictionary) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_VECTORIndexed_StringDictionary",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo>
+      indexes{IndexInfo("IndexName1", IndexType::VECTOR, "user.name", true)};
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  // Insert names out of order and in batches so that new strings keep
+  // arriving after the dictionary has been sorted. Every name appears twice.
+  const int nameCount = 3000;
+  std::vector<std::string> names;
+  std::vector<Buffer> documents;
+  for (int i = 0; i < nameCount * 2; i++) {
+    std::string name = "zarian_" + std::to_string((i * 7919) % nameCount);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    names.push_back(name);
+    documents.push_back(TestUtils::GetTweetObject(i,
+                                        i,
+                                        &name,
+                                        &text,
+                                        static_cast<double>(i),
+                                        &binData));
+    if (documents.size() == 500) {
+      db.MultiInsert("tweet", documents);
+      documents.clear();
+    }
+  }
+  db.MultiInsert("tweet", documents);
+
+  auto validate = [&](const std::string& lowerOp, const std::string& lower,
+                      const std::string& upperOp, const std::string& upper) {
+    auto matches = [](const std::string& val, const std::string& op,
+                      const std::string& operand) {
+      if (op == "=") return val == operand;
+      if (op == "<") return val < operand;
+      if (op == "<=") return val <= operand;
+      if (op == ">") return val > operand;
+      return val >= operand;
+    };
+    int expectedCount = 0;
+    for (auto& name : names) {
+      if (matches(name, lowerOp, lower) && matches(name, upperOp, upper)) {
+        expectedCount++;
+      }
+    }
+
+    auto rs = db.ExecuteSelect("SELECT id, [user.name] FROM tweet WHERE [user.name] " +
+        lowerOp + " '" + lower + "' AND [user.name] " + upperOp + " '" + upper + "';");
+    int count = 0;
+    while (rs.Next()) {
+      std::string name = rs.GetString(rs.GetColumnIndex("user.name")).str();
+      ASSERT_EQ(names[rs.GetInteger(rs.GetColumnIndex("id"))], name);
+      ASSERT_TRUE(matches(name, lowerOp, lower) && matches(name, upperOp, upper));
+      count++;
+    }
+    ASSERT_EQ(expectedCount, count);
+  };
+
+  validate(">=", "zarian_1000", "<", "zarian_2");
+  validate(">", "zarian_1000", "<=", "zarian_2");
+  validate("=", "zarian_2999", "=", "zarian_2999");
+  validate("=", "zarian_0", ">=", "zarian_");
+  validate(">", "a", "<", "zarian_10");
+  validate(">", "zarian_5", "<", "zz");
+  validate("=", "zarian_3000", "=", "zarian_3000");
+  validate(">", "zarian_2", "<", "zarian_1");
+}
+
+TEST(Database, ExecuteSelect_StringIndexed_LikeGlob) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_StringIndexed_LikeGlob",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<std::string> collections{"tweet_ewah", "tweet_vector",
+                                       "tweet_sorted", "tweet_noindex"};
+  db.CreateCollection("tweet_ewah", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1",
+                                 IndexType::EWAH_COMPRESSED_BITMAP,
+                                 "user.name", true)});
+  db.CreateCollection("tweet_vector", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName2", IndexType::VECTOR,
+                                 "user.name", true)});
+  db.CreateCollection("tweet_sorted", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName3", IndexType::SORTED,
+                                 "user.name", true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  // Mixed case names, some documents without a user name. The last
+  // documents are inserted one by one so that the vector index also has
+  // unsorted dictionary entries.
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 3000; i++) {
+    std::string name = (i % 5 == 0 ? "Zarian_" : "zarian_") +
+        std::to_string((i * 7919) % 1000);
+    std::string text = "hello_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i, i % 97 == 0 ? nullptr : &name, &text, static_cast<double>(i),
+        nullptr));
+  }
+  for (auto& collection : collections) {
+    db.MultiInsert(collection, std::vector<Buffer>(documents.begin(),
+                                                   documents.begin() + 2900));
+    for (std::size_t i = 2900; i < documents.size(); i++) {
+      db.Insert(collection, documents[i]);
+    }
+  }
+
+  auto getIDs = [&](const std::string& collection, const std::string& op,
+                    const std::string& pattern) {
+    auto rs = db.ExecuteSelect("SELECT id FROM " + collection +
+        " WHERE [user.name] " + op + " '" + pattern + "';");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(rs.GetColumnIndex("id")));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  std::vector<std::pair<std::string, std::string>> predicates{
+      {"LIKE", "zarian_1%"}, {"LIKE", "ZARIAN_1%"}, {"LIKE", "zarian_1_"},
+      {"LIKE", "%_5"}, {"LIKE", "zarian_999"}, {"LIKE", "%"},
+      {"LIKE", "_arian\\_%"}, {"GLOB", "zarian_[12]*"}, {"GLOB", "zarian_1*"},
+      {"GLOB", "Zarian_?5"}, {"GLOB", "[^z]*"}, {"GLOB", "zarian_999"},
+      {"GLOB", "zarian_[1"}, {"GLOB", "a*"}};
+  for (auto& predicate : predicates) {
+    auto expected = getIDs("tweet_noindex", predicate.first,
+                           predicate.second);
+    for (std::size_t i = 0; i < 3; i++) {
+      ASSERT_EQ(expected,
+                getIDs(collections[i], predicate.first, predicate.second))
+          << collections[i] << " " << predicate.first << " "
+          << predicate.second;
+    }
+  }
+
+  ASSERT_FALSE(getIDs("tweet_noindex", "LIKE", "zarian_1%").empty());
+  ASSERT_FALSE(getIDs("tweet_noindex", "GLOB", "zarian_[12]*").empty());
+}
+
+TEST(Database, ExecuteSelect_TrigramIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_TrigramIndexed",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::TRIGRAM, "text",
+                                 true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  std::vector<std::string> words{"power", "Outage", "network", "outage",
+                                 "restored", "OUTAGES", "ab", "x"};
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 2000; i++) {
+    std::string name = "user_" + std::to_string(i);
+    std::string text = words[i % words.size()] + " " +
+        words[(i / 3) % words.size()] + " " + std::to_string(i % 50);
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i, &name, i % 101 == 0 ? nullptr : &text, static_cast<double>(i),
+        nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getIDs = [&](const std::string& collection, const std::string& op,
+                    const std::string& pattern) {
+    auto rs = db.ExecuteSelect("SELECT id FROM " + collection +
+        " WHERE text " + op + " '" + pattern + "';");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(rs.GetColumnIndex("id")));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  std::vector<std::pair<std::string, std::string>> predicates{
+      {"LIKE", "%outage%"}, {"LIKE", "%OUTAGE %"}, {"LIKE", "%ge_ %"},
+      {"LIKE", "power%"}, {"LIKE", "%work 1_"}, {"LIKE", "%ab%"},
+      {"LIKE", "%missing%"}, {"GLOB", "*outage*"}, {"GLOB", "*Outage*"},
+      {"GLOB", "*[rs]tore?*"}, {"GLOB", "x *"}, {"GLOB", "*"},
+      {"=", "power power 0"}, {">", "power"}};
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(getIDs("tweet_noindex", predicate.first, predicate.second),
+              getIDs("tweet", predicate.first, predicate.second))
+        << predicate.first << " " << predicate.second;
+  }
+
+  ASSERT_FALSE(getIDs("tweet", "LIKE", "%outage%").empty());
+  ASSERT_TRUE(getIDs("tweet", "LIKE", "%missing%").empty());
+}
+
+TEST(Database, ExecuteSelect_FullTextIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_FullTextIndexed",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::FULL_TEXT, "text",
+                                 true),
+                       IndexInfo("IndexName2", IndexType::SORTED, "id",
+                                 true)});
+
+  std::vector<std::string> words{"power", "Outage", "in", "the", "network",
+                                 "was", "restored"};
+  std::vector<std::vector<std::string>> terms;
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 1000; i++) {
+    std::string name = "user_" + std::to_string(i);
+    std::vector<std::string> docTerms;
+    std::string text;
+    for (int j = 0; j < 4; j++) {
+      auto& word = words[(i * (j + 3) + j) % words.size()];
+      std::string term = word;
+      std::transform(term.begin(), term.end(), term.begin(), ::tolower);
+      docTerms.push_back(term);
+      text += word + (j % 2 == 0 ? ", " : " ");
+    }
+    terms.push_back(i % 61 == 0 ? std::vector<std::string>() : docTerms);
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i, &name, i % 61 == 0 ? nullptr : &text, static_cast<double>(i),
+        nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+
+  auto contains = [](const std::vector<std::string>& docTerms,
+                     const std::vector<std::string>& phrase) {
+    return std::search(docTerms.begin(), docTerms.end(), phrase.begin(),
+                       phrase.end()) != docTerms.end();
+  };
+  auto validate = [&](const std::string& where,
+                      const std::function<bool(std::int64_t)>& matches) {
+    auto rs = db.ExecuteSelect("SELECT id FROM tweet WHERE " + where + ";");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(rs.GetColumnIndex("id")));
+    }
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::int64_t> expectedIDs;
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(terms.size());
+         i++) {
+      if (matches(i)) {
+        expectedIDs.push_back(i);
+      }
+    }
+    ASSERT_EQ(expectedIDs, ids) << where;
+  };
+
+  validate("text MATCH 'outage'", [&](std::int64_t i) {
+    return contains(terms[i], {"outage"});
+  });
+  validate("text MATCH 'OUTAGE network'", [&](std::int64_t i) {
+    return contains(terms[i], {"outage"}) && contains(terms[i], {"network"});
+  });
+  validate("text MATCH 'outage AND network'", [&](std::int64_t i) {
+    return contains(terms[i], {"outage"}) && contains(terms[i], {"network"});
+  });
+  validate("text MATCH 'outage OR restored'", [&](std::int64_t i) {
+    return contains(terms[i], {"outage"}) || contains(terms[i], {"restored"});
+  });
+  validate("text MATCH '\"power outage\"'", [&](std::int64_t i) {
+    return contains(terms[i], {"power", "outage"});
+  });
+  validate("text MATCH '(in OR was) \"the network\"'", [&](std::int64_t i) {
+    return (contains(terms[i], {"in"}) || contains(terms[i], {"was"})) &&
+        contains(terms[i], {"the", "network"});
+  });
+  validate("text MATCH 'outage' AND id < 500", [&](std::int64_t i) {
+    return contains(terms[i], {"outage"}) && i < 500;
+  });
+  validate("text MATCH 'missing OR power'", [&](std::int64_t i) {
+    return contains(terms[i], {"power"});
+  });
+  validate("text MATCH 'missing'", [&](std::int64_t i) {
+    return false;
+  });
+
+  // The query is evaluated when the first row is fetched
+  ASSERT_ANY_THROW({
+    ResultSet rs = db.ExecuteSelect(
+        "SELECT id FROM tweet WHERE text MATCH '(outage';");
+    rs.Next();
+  });
+}
+
+TEST(Database, ExecuteSelect_BitSlicedIndexed_Range) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_BitSlicedIndexed_Range",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  // id also has a EWAH index, range filters should pick the bit-sliced one
+  std::vector<IndexInfo> indexes{ IndexInfo("IndexName1", IndexType::EWAH_COMPRESSED_BITMAP, "id", true),
+    IndexInfo("IndexName2", IndexType::BIT_SLICED, "id", true),
+    IndexInfo("IndexName3", IndexType::BIT_SLICED, "rating", true),
+    IndexInfo("IndexName4", IndexType::BIT_SLICED, "user.id", true) };
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  std::vector<Buffer> documents;
+  for (int i = -5; i < 5; i++) {
+    std::string name = "zarian_" + std::to_string(i);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(i,
+                                        i,
+                                        &name,
+                                        &text,
+                                        static_cast<double>(i),
+                                        &binData));
+  }
+  db.MultiInsert("tweet", documents);
+
+  ValidateTweetResultSet(db, -3, 3, "id", ">=", "-3", "id", "<=", "2");
+  ValidateTweetResultSet(db, -3, 2, "id", ">=", "-3", "id", "<", "2");
+  ValidateTweetResultSet(db, -2, 3, "id", ">", "-3", "id", "<=", "2");
+  ValidateTweetResultSet(db, -3, 3, "id", ">", "-3.5", "id", "<", "2.5");
+  ValidateTweetResultSet(db, -5, 5, "id", ">", "-100", "id", "<", "100");
+  ValidateTweetResultSet(db, 0, 0, "id", ">", "2", "id", "<", "1");
+
+  ValidateTweetResultSet(db, -3, 3, "[user.id]", ">=", "-3", "[user.id]", "<=", "2");
+  ValidateTweetResultSet(db, -2, 2, "[user.id]", ">", "-3", "[user.id]", "<", "2");
+
+  ValidateTweetResultSet(db, -3, 3, "rating", ">=", "-3.0", "rating", "<=", "2.0");
+  ValidateTweetResultSet(db, -2, 2, "rating", ">", "-3", "rating", "<", "2");
+  ValidateTweetResultSet(db, -3, 3, "rating", ">", "-3.5", "rating", "<", "2.5");
+  ValidateTweetResultSet(db, 0, 1, "rating", ">=", "0.0", "rating", "<=", "-0.0");
+}
+
+TEST(Database, ExecuteSelect_SortedIndexed_Range) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_SortedIndexed_Range",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo> indexes{ IndexInfo("IndexName1", IndexType::SORTED, "id", true),
+    IndexInfo("IndexName2", IndexType::SORTED, "rating", true),
+    IndexInfo("IndexName3", IndexType::SORTED, "user.id", true),
+    IndexInfo("IndexName4", IndexType::SORTED, "user.name", true) };
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  // Insert enough documents in small batches so that the index has to
+  // flush and merge several sorted segments
+  const int docCount = 5000;
+  std::vector<std::string> names;
+  std::vector<Buffer> documents;
+  for (int i = 0; i < docCount; i++) {
+    std::string name = "zarian_" + std::to_string(i);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    names.push_back(name);
+    documents.push_back(TestUtils::GetTweetObject(i,
+                                        i,
+                                        &name,
+                                        &text,
+                                        static_cast<double>(i),
+                                        &binData));
+    if (documents.size() == 700) {
+      db.MultiInsert("tweet", documents);
+      documents.clear();
+    }
+  }
+  db.MultiInsert("tweet", documents);
+
+  ValidateTweetResultSet(db, 1000, 4001, "id", ">=", "1000", "id", "<=", "4000");
+  ValidateTweetResultSet(db, 1001, 4000, "id", ">", "1000", "id", "<", "4000");
+  ValidateTweetResultSet(db, 1000, 1001, "id", ">=", "999.5", "id", "<", "1000.5");
+  ValidateTweetResultSet(db, 3, 4999, "[user.id]", ">", "2", "[user.id]", "<", "4999");
+  ValidateTweetResultSet(db, 10, 4990, "rating", ">=", "9.5", "rating", "<=", "4989.0");
+  ValidateTweetResultSet(db, 4990, 4991, "rating", "=", "4990", "rating", "=", "4990.0");
+
+  // Strings sort lexicographically so compute the expected count
+  std::string lower = "zarian_1000", upper = "zarian_2";
+  int expectedCount = 0;
+  for (auto& name : names) {
+    if (name >= lower && name < upper) {
+      expectedCount++;
+    }
+  }
+  auto rs = db.ExecuteSelect("SELECT [user.name] FROM tweet WHERE [user.name] >= '" +
+      lower + "' AND [user.name] < '" + upper + "';");
+  int count = 0;
+  while (rs.Next()) {
+    std::string name = rs.GetString(rs.GetColumnIndex("user.name")).str();
+    ASSERT_TRUE(name >= lower && name < upper);
+    count++;
+  }
+  ASSERT_EQ(expectedCount, count);
+}
+
 TEST(Database, ExecuteSelect_ScanForIDSeq) {
   // This test checks the boundary conditions for IDSeq
   std::vector<int> idCounts = {0, 1, 50, 100, 101, 200, 201};
@@ -1794,3 +2329,846 @@ TEST(Database, Insert_Invalid) {
   ASSERT_THROW(db.Insert(collectionName, documentData),
                JonoonDBException);
 }
+
+TEST(Database, BulkLoad) {
+  Database db(g_TestRootDirectory,
+              "BulkLoad",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo> indexes{ IndexInfo("IndexName1", IndexType::EWAH_COMPRESSED_BITMAP, "id", true),
+    IndexInfo("IndexName2", IndexType::EWAH_COMPRESSED_BITMAP, "rating", true),
+    IndexInfo("IndexName3", IndexType::VECTOR, "user.id", true),
+    IndexInfo("IndexName4", IndexType::EWAH_COMPRESSED_BITMAP, "user.name", true) };
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  ASSERT_THROW(db.EndBulkLoad("tweet"), JonoonDBException);
+  ASSERT_THROW(db.BeginBulkLoad("missing"), CollectionNotFoundException);
+
+  auto getCount = [&](const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT COUNT(*) FROM tweet" + predicate + ";");
+    rs.Next();
+    return rs.GetInteger(0);
+  };
+
+  // First 3 documents are inserted normally and the rest in a bulk load
+  std::vector<Buffer> documents;
+  for (size_t i = 0; i < 10; i++) {
+    std::string name = "zarian_" + std::to_string(i);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(i,
+                                        i,
+                                        &name,
+                                        &text,
+                                        static_cast<double>(i),
+                                        &binData));
+    if (i == 2) {
+      db.MultiInsert("tweet", documents);
+      documents.clear();
+      db.BeginBulkLoad("tweet");
+      ASSERT_THROW(db.BeginBulkLoad("tweet"), JonoonDBException);
+    } else if (i == 5) {
+      db.MultiInsert("tweet", documents);
+      documents.clear();
+      // The bulk loaded documents are not visible until EndBulkLoad
+      ASSERT_EQ(getCount(""), 3);
+      ASSERT_EQ(getCount(" WHERE id >= 0"), 3);
+    }
+  }
+  db.MultiInsert("tweet", documents);
+  db.EndBulkLoad("tweet");
+  ASSERT_EQ(getCount(""), 10);
+
+  ValidateTweetResultSet(db, 1, 8, "[user.name]", ">=", "'zarian_1'", "[user.name]", "<=", "'zarian_7'");
+  ValidateTweetResultSet(db, 2, 9, "id", ">", "1", "id", "<", "9");
+  ValidateTweetResultSet(db, 0, 10, "[user.id]", ">=", "0", "[user.id]", "<=", "9");
+  ValidateTweetResultSet(db, 3, 7, "rating", ">=", "3.0", "rating", "<", "7.0");
+
+  // Documents inserted after the bulk load are indexed right away
+  std::string name = "zarian_10";
+  std::string text = "hello_10";
+  std::string binData = "some_data_10";
+  db.Insert("tweet", TestUtils::GetTweetObject(10, 10, &name, &text, 10.0,
+                                               &binData));
+  ValidateTweetResultSet(db, 8, 11, "id", ">=", "8", "rating", "<=", "10.0");
+}
+
+TEST(Database, BulkLoad_ReadFailure) {
+  std::string dbName = "BulkLoad_ReadFailure";
+  Options opt = TestUtils::GetDefaultDBOptions();
+  opt.SetMaxDataFileSize(16 * 1024 * 1024);
+  Database db(g_TestRootDirectory, dbName, opt);
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo> indexes{ IndexInfo("IndexName1", IndexType::EWAH_COMPRESSED_BITMAP, "id", true),
+    IndexInfo("IndexName2", IndexType::VECTOR, "user.id", true) };
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  auto getCount = [&](const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT COUNT(*) FROM tweet" + predicate + ";");
+    rs.Next();
+    return rs.GetInteger(0);
+  };
+
+  // EndBulkLoad indexes 10000 documents per batch, reading the first
+  // document of the second batch will fail
+  const std::size_t docCount = 10005;
+  std::size_t offset = 0, brokenOffset = 0;
+  std::vector<Buffer> documents;
+  std::string name = "zarian";
+  for (size_t i = 0; i < docCount; i++) {
+    documents.push_back(TestUtils::GetTweetObject(i, i % 10, &name, nullptr,
+                                                  0, nullptr));
+    if (i == 10000) {
+      brokenOffset = offset;
+    }
+    // Blobs are stored one after the other with a 3 byte header and the
+    // blob size as a varint
+    auto size = documents.back().GetLength();
+    offset += 3 + (size < 128 ? 1 : 2) + size;
+  }
+  db.BeginBulkLoad("tweet");
+  db.MultiInsert("tweet", documents);
+
+  // A varint that is longer than 10 bytes cannot be read
+  std::fstream file(g_TestRootDirectory + "/" + dbName + "_tweet.0",
+                    ios::in | ios::out | ios::binary);
+  std::string original(11, '\0');
+  file.seekg(brokenOffset + 3);
+  file.read(&original[0], original.size());
+  file.seekp(brokenOffset + 3);
+  file.write(std::string(original.size(), '\xFF').data(), original.size());
+  file.flush();
+  ASSERT_THROW(db.EndBulkLoad("tweet"), JonoonDBException);
+  ASSERT_EQ(getCount(""), 0);
+
+  // Calling EndBulkLoad again resumes with the batch that failed
+  file.seekp(brokenOffset + 3);
+  file.write(original.data(), original.size());
+  file.close();
+  db.EndBulkLoad("tweet");
+  ASSERT_EQ(getCount(""), docCount);
+  ASSERT_EQ(getCount(" WHERE [user.id] = 3"), 1001);
+  ASSERT_EQ(getCount(" WHERE id >= 9995"), 10);
+}
+
+TEST(Database, HashIndex) {
+  Database db(g_TestRootDirectory, "HashIndex",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  std::vector<IndexInfo> indexes{ IndexInfo("IndexName1", IndexType::UNIQUE_HASH, "id", true),
+    IndexInfo("IndexName2", IndexType::HASH, "user.name", true),
+    IndexInfo("IndexName3", IndexType::HASH, "rating", true) };
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema, indexes);
+
+  // Insert enough documents to make the hash table grow, every 10 documents
+  // share the same user.name
+  const int docCount = 2000;
+  std::vector<Buffer> documents;
+  for (int i = 0; i < docCount; i++) {
+    std::string name = "zarian_" + std::to_string(i / 10);
+    std::string text = "hello_" + std::to_string(i);
+    std::string binData = "some_data_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(i, i, &name, &text,
+                                                  static_cast<double>(i),
+                                                  &binData));
+  }
+  db.MultiInsert("tweet", documents);
+
+  // Duplicate key against the index and inside the batch
+  std::string name = "duplicate";
+  std::string text = "hello";
+  std::string binData = "some_data";
+  ASSERT_THROW(db.Insert("tweet", TestUtils::GetTweetObject(5, 5, &name, &text,
+                                                            5.0, &binData)),
+               DuplicateKeyException);
+  std::vector<Buffer> duplicates{
+      TestUtils::GetTweetObject(docCount, 0, &name, &text, 0.0, &binData),
+      TestUtils::GetTweetObject(docCount, 0, &name, &text, 0.0, &binData)};
+  ASSERT_THROW(db.MultiInsert("tweet", duplicates), DuplicateKeyException);
+  ASSERT_THROW(db.BeginBulkLoad("tweet"), JonoonDBException);
+
+  // Failed inserts should not have added any document
+  auto rs = db.ExecuteSelect("SELECT id FROM tweet;");
+  int count = 0;
+  while (rs.Next()) {
+    ASSERT_EQ(count, rs.GetInteger(rs.GetColumnIndex("id")));
+    count++;
+  }
+  ASSERT_EQ(docCount, count);
+
+  rs = db.ExecuteSelect("SELECT id FROM tweet WHERE id = 1234;");
+  ASSERT_TRUE(rs.Next());
+  ASSERT_EQ(1234, rs.GetInteger(rs.GetColumnIndex("id")));
+  ASSERT_FALSE(rs.Next());
+
+  rs = db.ExecuteSelect("SELECT id FROM tweet WHERE [user.name] = 'zarian_42';");
+  count = 0;
+  while (rs.Next()) {
+    ASSERT_EQ(420 + count, rs.GetInteger(rs.GetColumnIndex("id")));
+    count++;
+  }
+  ASSERT_EQ(10, count);
+
+  rs = db.ExecuteSelect("SELECT id FROM tweet WHERE rating = 17.0 OR rating = 18;");
+  count = 0;
+  while (rs.Next()) {
+    ASSERT_EQ(17 + count, rs.GetInteger(rs.GetColumnIndex("id")));
+    count++;
+  }
+  ASSERT_EQ(2, count);
+
+  // Range predicates cannot use the hash index and fall back to a scan
+  rs = db.ExecuteSelect("SELECT id FROM tweet WHERE id >= 100 AND id < 105;");
+  count = 0;
+  while (rs.Next()) {
+    ASSERT_EQ(100 + count, rs.GetInteger(rs.GetColumnIndex("id")));
+    count++;
+  }
+  ASSERT_EQ(5, count);
+
+  Buffer document;
+  ASSERT_TRUE(db.TryGetByKey("tweet", "id", 777, document));
+  ASSERT_EQ(777, GetTweet(document.GetData())->id());
+  ASSERT_FALSE(db.TryGetByKey("tweet", "id", docCount, document));
+  ASSERT_TRUE(db.TryGetByKey("tweet", "user.name", "zarian_3", document));
+  ASSERT_EQ(30, GetTweet(document.GetData())->id());
+  ASSERT_FALSE(db.TryGetByKey("tweet", "user.name", "missing", document));
+  ASSERT_THROW(db.TryGetByKey("tweet", "text", "hello_1", document),
+               JonoonDBException);
+}
+
+TEST(Database, ExecuteSelect_CostBasedIndexSelection) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_CostBasedIndexSelection",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  // Several indexes on the same columns, the cheapest one is used
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1",
+                                 IndexType::EWAH_COMPRESSED_BITMAP, "id", true),
+                       IndexInfo("IndexName2", IndexType::VECTOR, "id", true),
+                       IndexInfo("IndexName3", IndexType::SORTED, "id", true),
+                       IndexInfo("IndexName4", IndexType::HASH, "rating", true),
+                       IndexInfo("IndexName5", IndexType::VECTOR, "rating",
+                                 true),
+                       IndexInfo("IndexName6", IndexType::SORTED, "user.name",
+                                 true),
+                       IndexInfo("IndexName7", IndexType::TRIGRAM, "user.name",
+                                 true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 3000; i++) {
+    std::string name = "user_" + std::to_string(i % 700);
+    std::string text = "hello_" + std::to_string(i);
+    documents.push_back(TestUtils::GetTweetObject(
+        i % 1000, i, &name, &text, static_cast<double>(i % 7), nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getIDs = [&](const std::string& collection,
+                    const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT id, [user.name] FROM " + collection +
+        " WHERE " + predicate + ";");
+    std::vector<std::pair<std::int64_t, std::string>> rows;
+    while (rs.Next()) {
+      rows.emplace_back(rs.GetInteger(rs.GetColumnIndex("id")),
+                        rs.GetString(rs.GetColumnIndex("user.name")).str());
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  };
+
+  std::vector<std::string> predicates{
+      "id = 10", "id > 990", "id >= 100 AND id < 105", "id < 0",
+      "rating = 3", "rating = 3 AND id < 50", "rating > 5 AND id = 6",
+      "[user.name] = 'user_5'", "[user.name] LIKE 'user_1%'",
+      "[user.name] LIKE '%_69%' AND rating >= 4",
+      "[user.name] >= 'user_69' AND id > 500"};
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(getIDs("tweet_noindex", predicate), getIDs("tweet", predicate))
+        << predicate;
+  }
+}
+
+TEST(Database, ExecuteSelect_CompositeIndexed) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_CompositeIndexed",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::SORTED,
+                                 "user.id,rating", true),
+                       IndexInfo("IndexName2", IndexType::SORTED,
+                                 "user.name,rating", true),
+                       IndexInfo("IndexName3", IndexType::HASH,
+                                 "text,id", true),
+                       IndexInfo("IndexName4", IndexType::VECTOR, "id",
+                                 true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 3000; i++) {
+    std::string name = "user_" + std::to_string(i % 30);
+    std::string text = "hello_" + std::to_string(i % 10);
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i % 100, i % 37 == 0 ? nullptr : &name, &text,
+        static_cast<double>(i % 7) - 3, nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getIDs = [&](const std::string& collection,
+                    const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT id FROM " + collection + " WHERE " +
+        predicate + ";");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(rs.GetColumnIndex("id")));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  std::vector<std::string> predicates{
+      "[user.id] = 5", "[user.id] = 5 AND rating = 1",
+      "[user.id] = 5 AND rating > 1", "[user.id] = 5 AND rating >= -1.5",
+      "[user.id] = 5 AND rating > -2 AND rating <= 2",
+      "rating < 0 AND [user.id] = 7", "[user.id] > 97",
+      "[user.id] >= 10.5 AND [user.id] < 12", "[user.id] < -5",
+      "[user.id] = 5.5 AND rating = 1", "[user.id] = 5 AND rating = 1.5",
+      "[user.name] = 'user_5' AND rating < 0", "[user.name] >= 'user_8'",
+      "[user.name] > 'user_2' AND [user.name] < 'user_3'",
+      "text = 'hello_3' AND id = 13", "text = 'hello_3' AND id = 14",
+      "text = 'hello_3' AND id > 2900", "text = 'hello_3'",
+      "[user.id] = 5 AND rating = 1 AND id > 1000"};
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(getIDs("tweet_noindex", predicate), getIDs("tweet", predicate))
+        << predicate;
+  }
+
+  ASSERT_FALSE(getIDs("tweet", "[user.id] = 5 AND rating > 1").empty());
+  ASSERT_FALSE(getIDs("tweet", "text = 'hello_3' AND id = 13").empty());
+}
+
+TEST(Database, CreateIndex_PopulatedCollection) {
+  string dbName = "CreateIndex_PopulatedCollection";
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  auto getDocuments = [](int start, int count) {
+    std::vector<Buffer> documents;
+    for (int i = start; i < start + count; i++) {
+      std::string name = "user_" + std::to_string(i % 30);
+      std::string text = "hello_" + std::to_string(i % 10);
+      documents.push_back(TestUtils::GetTweetObject(
+          i, i % 100, &name, &text, static_cast<double>(i % 7) - 3,
+          nullptr));
+    }
+    return documents;
+  };
+
+  auto getIDs = [](Database& db, const std::string& collection,
+                   const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT id FROM " + collection + " WHERE " +
+        predicate + ";");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(rs.GetColumnIndex("id")));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  std::vector<std::string> predicates{
+      "id = 10", "id > 20990", "id >= 100 AND id < 105",
+      "[user.id] = 5 AND rating = 1", "[user.id] = 5 AND rating > 1",
+      "[user.id] > 97 AND id < 3000"};
+  {
+    Database db(g_TestRootDirectory, dbName,
+                TestUtils::GetDefaultDBOptions());
+    db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                        std::vector<IndexInfo>());
+    db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                        std::vector<IndexInfo>());
+    for (int i = 0; i < 20000; i += 5000) {
+      auto documents = getDocuments(i, 5000);
+      db.MultiInsert("tweet", documents);
+      db.MultiInsert("tweet_noindex", documents);
+    }
+
+    db.CreateIndex("tweet", IndexInfo("IndexName1", IndexType::VECTOR, "id",
+                                      true));
+    db.CreateIndex("tweet", IndexInfo("IndexName2", IndexType::SORTED,
+                                      "user.id,rating", true));
+    // Inserts are not blocked by the index builds
+    for (int i = 20000; i < 21000; i += 100) {
+      auto documents = getDocuments(i, 100);
+      db.MultiInsert("tweet", documents);
+      db.MultiInsert("tweet_noindex", documents);
+    }
+
+    for (auto& predicate : predicates) {
+      ASSERT_EQ(getIDs(db, "tweet_noindex", predicate),
+                getIDs(db, "tweet", predicate)) << predicate;
+    }
+
+    ASSERT_THROW(db.CreateIndex("tweet", IndexInfo("IndexName1",
+                                                   IndexType::SORTED, "rating",
+                                                   true)),
+                 IndexAlreadyExistException);
+    ASSERT_THROW(db.CreateIndex("tweet", IndexInfo("IndexName3",
+                                                   IndexType::UNIQUE_HASH,
+                                                   "id", true)),
+                 InvalidArgumentException);
+    ASSERT_THROW(db.CreateIndex("missing", IndexInfo("IndexName3",
+                                                     IndexType::VECTOR, "id",
+                                                     true)),
+                 CollectionNotFoundException);
+    ASSERT_THROW(db.DropIndex("tweet", "IndexName3"), JonoonDBException);
+
+    db.DropIndex("tweet", "IndexName1");
+    for (auto& predicate : predicates) {
+      ASSERT_EQ(getIDs(db, "tweet_noindex", predicate),
+                getIDs(db, "tweet", predicate)) << predicate;
+    }
+  }
+
+  // The created index is persisted and the dropped one is not
+  Options opt = TestUtils::GetDefaultDBOptions();
+  opt.SetCreateDBIfMissing(false);
+  Database db(g_TestRootDirectory, dbName, opt);
+  ASSERT_THROW(db.CreateIndex("tweet", IndexInfo("IndexName2",
+                                                 IndexType::SORTED, "rating",
+                                                 true)),
+               IndexAlreadyExistException);
+  db.CreateIndex("tweet", IndexInfo("IndexName1", IndexType::VECTOR, "id",
+                                    true));
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(getIDs(db, "tweet_noindex", predicate),
+              getIDs(db, "tweet", predicate)) << predicate;
+  }
+}
+
+TEST(Database, ExecuteSelect_MissingSubDocument_VectorIndexed) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_MissingSubDocument_VectorIndexed",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::VECTOR, "user.id",
+                                 true),
+                       IndexInfo("IndexName2", IndexType::VECTOR,
+                                 "user.name", true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  // Every third tweet has no user so its user fields are null
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 10000; i++) {
+    if (i % 3 == 0) {
+      FlatBufferBuilder fbb;
+      fbb.Finish(CreateTweet(fbb, i, 0, 0, i));
+      documents.push_back(Buffer((char*)fbb.GetBufferPointer(),
+                                 fbb.GetSize(), fbb.GetSize()));
+    } else {
+      std::string name = "user_" + std::to_string(i % 50);
+      documents.push_back(TestUtils::GetTweetObject(i, i % 50 - 25, &name,
+                                                    nullptr, i, nullptr));
+    }
+  }
+  db.MultiInsert("tweet", documents);
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getRows = [&](const std::string& collection,
+                     const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT id, [user.id], [user.name] FROM " +
+        collection + " WHERE " + predicate + ";");
+    std::vector<std::string> rows;
+    while (rs.Next()) {
+      auto userID = rs.GetColumnIndex("user.id");
+      auto userName = rs.GetColumnIndex("user.name");
+      rows.push_back(std::to_string(rs.GetInteger(rs.GetColumnIndex("id"))) +
+          (rs.IsNull(userID) ? " null" :
+              " " + std::to_string(rs.GetInteger(userID))) +
+          (rs.IsNull(userName) ? " null" :
+              " " + std::string(rs.GetString(userName).str())));
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  };
+
+  std::vector<std::string> predicates{
+      "[user.id] = 0", "[user.id] < 0", "[user.id] >= -25",
+      "[user.id] > -100 AND [user.id] < 100", "[user.name] = 'user_3'",
+      "[user.name] >= 'user_'", "[user.name] LIKE 'user%'",
+      "[user.name] < 'user_2'", "id < 20"};
+  for (auto& predicate : predicates) {
+    ASSERT_EQ(getRows("tweet_noindex", predicate),
+              getRows("tweet", predicate)) << predicate;
+  }
+
+  ASSERT_EQ(getRows("tweet", "[user.id] >= -25").size(), 6666);
+  auto rows = getRows("tweet", "id < 20");
+  auto nullCount = std::count_if(
+      rows.begin(), rows.end(), [](const std::string& row) {
+        return row.find(" null null") != string::npos;
+      });
+  ASSERT_EQ(nullCount, 7);
+}
+
+TEST(Database, ExecuteSelect_MissingSubDocument_AllIndexTypes) {
+  Database db(g_TestRootDirectory,
+              "ExecuteSelect_MissingSubDocument_AllIndexTypes",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+
+  // Every third tweet has no user so its user fields are null
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 3000; i++) {
+    if (i % 3 == 0) {
+      FlatBufferBuilder fbb;
+      fbb.Finish(CreateTweet(fbb, i, 0, 0, i));
+      documents.push_back(Buffer((char*)fbb.GetBufferPointer(),
+                                 fbb.GetSize(), fbb.GetSize()));
+    } else {
+      std::string name = "user_" + std::to_string(i % 50);
+      documents.push_back(TestUtils::GetTweetObject(i, i % 50 - 25, &name,
+                                                    nullptr, i, nullptr));
+    }
+  }
+
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getIDs = [&](const std::string& collection,
+                    const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT id FROM " + collection + " WHERE " +
+        predicate + ";");
+    std::vector<std::int64_t> ids;
+    while (rs.Next()) {
+      ids.push_back(rs.GetInteger(0));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  auto checkIndexTypes = [&](const std::string& columnName,
+                             const std::vector<IndexType>& indexTypes,
+                             const std::vector<std::string>& predicates) {
+    for (auto indexType : indexTypes) {
+      auto collection = "tweet_" + std::to_string(
+          static_cast<std::int32_t>(indexType)) + "_" +
+          std::to_string(columnName.size());
+      db.CreateCollection(collection, SchemaType::FLAT_BUFFERS, schema,
+                          {IndexInfo("IndexName1", indexType, columnName,
+                                     true)});
+      db.MultiInsert(collection, documents);
+      for (auto& predicate : predicates) {
+        ASSERT_EQ(getIDs("tweet_noindex", predicate),
+                  getIDs(collection, predicate))
+            << predicate << " on index type "
+            << static_cast<std::int32_t>(indexType);
+      }
+    }
+  };
+
+  checkIndexTypes("user.id",
+                  {IndexType::EWAH_COMPRESSED_BITMAP, IndexType::VECTOR,
+                   IndexType::BIT_SLICED, IndexType::SORTED, IndexType::HASH},
+                  {"[user.id] < 5", "[user.id] <= -25", "[user.id] > -100",
+                   "[user.id] >= -9223372036854775808",
+                   "[user.id] = -9223372036854775808",
+                   "[user.id] > -100 AND [user.id] < 5"});
+  checkIndexTypes("user.name",
+                  {IndexType::EWAH_COMPRESSED_BITMAP, IndexType::VECTOR,
+                   IndexType::SORTED, IndexType::HASH},
+                  {"[user.name] < 'user_2'", "[user.name] > ''",
+                   "[user.name] >= ''", "[user.name] <= 'user_5'",
+                   "[user.name] > '' AND [user.name] < 'user_3'"});
+  ASSERT_EQ(getIDs("tweet_noindex", "[user.id] < 5").size(), 1200);
+}
+
+TEST(Database, ExecuteSelect_ValueCounts) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_ValueCounts",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1",
+                                 IndexType::EWAH_COMPRESSED_BITMAP,
+                                 "user.name", true),
+                       IndexInfo("IndexName2",
+                                 IndexType::EWAH_COMPRESSED_BITMAP,
+                                 "user.id", true),
+                       IndexInfo("IndexName3",
+                                 IndexType::EWAH_COMPRESSED_BITMAP, "rating",
+                                 true),
+                       IndexInfo("IndexName4", IndexType::VECTOR, "id",
+                                 true)});
+
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 1000; i++) {
+    std::string name = "user_" + std::to_string(i % 7);
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i % 13, i % 10 == 0 ? nullptr : &name, nullptr,
+        static_cast<double>(i % 4) / 2, nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+
+  auto getRows = [&](const std::string& sqlStmt) {
+    auto rs = db.ExecuteSelect(sqlStmt);
+    std::vector<std::pair<std::string, std::int64_t>> rows;
+    while (rs.Next()) {
+      // jonoondb_value_counts does not count nulls
+      if (!rs.IsNull(0)) {
+        rows.emplace_back(rs.GetString(0).str(), rs.GetInteger(1));
+      }
+    }
+    return rows;
+  };
+
+  std::vector<std::string> columns{"user.name", "user.id", "rating"};
+  for (auto& column : columns) {
+    ASSERT_EQ(getRows("SELECT [" + column + "], COUNT(*) FROM tweet "
+                  "GROUP BY [" + column + "];"),
+              getRows("SELECT value, count FROM jonoondb_value_counts("
+                          "'tweet', '" + column + "');")) << column;
+  }
+
+  auto rows = getRows("SELECT value, count FROM jonoondb_value_counts("
+                          "'tweet', 'user.name') WHERE value = 'user_3';");
+  ASSERT_EQ(rows.size(), 1);
+  ASSERT_EQ(rows[0].second,
+            getRows("SELECT 'user_3', COUNT(*) FROM tweet "
+                        "WHERE [user.name] = 'user_3';")[0].second);
+
+  rows = getRows("SELECT value, count FROM jonoondb_value_counts("
+                     "'tweet', 'user.name') WHERE count > 1000;");
+  ASSERT_TRUE(rows.empty());
+
+  auto rs = db.ExecuteSelect("SELECT value, count FROM jonoondb_value_counts("
+                                 "'tweet', 'id');");
+  ASSERT_THROW(rs.Next(), JonoonDBException);
+  rs = db.ExecuteSelect("SELECT value, count FROM jonoondb_value_counts("
+                            "'missing', 'id');");
+  ASSERT_THROW(rs.Next(), JonoonDBException);
+}
+
+TEST(Database, ExecuteSelect_CachedFilterAfterInsert) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_CachedFilterAfterInsert",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::VECTOR, "user.name",
+                                 true),
+                       IndexInfo("IndexName2", IndexType::VECTOR, "user.id",
+                                 true),
+                       IndexInfo("IndexName3",
+                                 IndexType::EWAH_COMPRESSED_BITMAP, "rating",
+                                 true)});
+
+  std::int64_t id = 0;
+  auto insert = [&](int count) {
+    std::vector<Buffer> documents;
+    for (int i = 0; i < count; i++, id++) {
+      std::string name = "user_" + std::to_string(id % 7);
+      documents.push_back(TestUtils::GetTweetObject(
+          id, id % 13, &name, nullptr, static_cast<double>(id % 4) / 2,
+          nullptr));
+    }
+    db.MultiInsert("tweet", documents);
+  };
+  auto getCount = [&](const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT COUNT(*) FROM tweet WHERE " +
+        predicate + ";");
+    rs.Next();
+    return rs.GetInteger(0);
+  };
+  auto expectedCount = [&](int modulo, int value) {
+    return (id - value + modulo - 1) / modulo;
+  };
+
+  // The constraint order does not matter for the cache, the results have to
+  // include the documents inserted after the first query
+  insert(1000);
+  for (int round = 0; round < 3; round++) {
+    ASSERT_EQ(getCount("[user.name] = 'user_3'"), expectedCount(7, 3));
+    ASSERT_EQ(getCount("[user.id] = 5"), expectedCount(13, 5));
+    ASSERT_EQ(getCount("[user.id] = 5"), expectedCount(13, 5));
+    ASSERT_EQ(getCount("[user.id] > 10 AND [user.id] <= 11"),
+              expectedCount(13, 11));
+    ASSERT_EQ(getCount("[user.id] <= 11 AND [user.id] > 10"),
+              expectedCount(13, 11));
+    ASSERT_EQ(getCount("rating = 1.5"), expectedCount(4, 3));
+    insert(500 + round * 77);
+  }
+
+  db.DropIndex("tweet", "IndexName1");
+  ASSERT_EQ(getCount("[user.name] = 'user_3'"), expectedCount(7, 3));
+}
+
+TEST(Database, ExecuteSelect_JoinUsesIndexOfLargeCollection) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_JoinUsesIndexOfLargeCollection",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("big", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::HASH, "user.id",
+                                 true),
+                       IndexInfo("IndexName2", IndexType::VECTOR, "rating",
+                                 true)});
+  db.CreateCollection("small", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::VECTOR, "id",
+                                 true)});
+
+  std::vector<Buffer> documents;
+  std::string name = "user";
+  for (int i = 0; i < 20000; i++) {
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i % 5000, &name, nullptr, static_cast<double>(i % 4) / 2,
+        nullptr));
+  }
+  db.MultiInsert("big", documents);
+  documents.clear();
+  for (int i = 0; i < 10; i++) {
+    documents.push_back(TestUtils::GetTweetObject(
+        i, i * 3, &name, nullptr, 0, nullptr));
+  }
+  db.MultiInsert("small", documents);
+
+  std::string query = "SELECT COUNT(*) FROM big, small "
+      "WHERE big.[user.id] = small.[user.id] AND big.rating > 0.6;";
+  auto rs = db.ExecuteSelect(query);
+  ASSERT_TRUE(rs.Next());
+  // Every user.id of small matches 4 documents of big, 2 of them with a
+  // rating of 1 or 1.5
+  ASSERT_EQ(rs.GetInteger(0), 20);
+
+  // The small collection drives the join and big is probed by its index
+  rs = db.ExecuteSelect("EXPLAIN QUERY PLAN " + query);
+  ASSERT_TRUE(rs.Next());
+  std::string detail = rs.GetString(3).str();
+  ASSERT_NE(detail.find("small"), string::npos) << detail;
+}
+
+TEST(Database, ExecuteSelect_OrderByIndexedColumn) {
+  Database db(g_TestRootDirectory, "ExecuteSelect_OrderByIndexedColumn",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1",
+                                 IndexType::EWAH_COMPRESSED_BITMAP,
+                                 "user.name", true),
+                       IndexInfo("IndexName2",
+                                 IndexType::EWAH_COMPRESSED_BITMAP, "rating",
+                                 true),
+                       IndexInfo("IndexName3",
+                                 IndexType::EWAH_COMPRESSED_BITMAP, "id",
+                                 true),
+                       IndexInfo("IndexName4", IndexType::VECTOR, "user.id",
+                                 true)});
+  db.CreateCollection("tweet_noindex", SchemaType::FLAT_BUFFERS, schema,
+                      std::vector<IndexInfo>());
+
+  // Some documents without a user name and an empty name that sorts
+  // before the other names
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 2000; i++) {
+    std::string name = i % 50 == 0 ? "" : "user_" + std::to_string(
+        (i * 7919) % 300);
+    documents.push_back(TestUtils::GetTweetObject(
+        (i * 31) % 2000, i % 13, i % 9 == 0 ? nullptr : &name, nullptr,
+        static_cast<double>(i % 40) / 4, nullptr));
+  }
+  db.MultiInsert("tweet", documents);
+  db.MultiInsert("tweet_noindex", documents);
+
+  auto getValues = [&](const std::string& collection,
+                       const std::string& column, const std::string& rest) {
+    auto rs = db.ExecuteSelect("SELECT [" + column + "] FROM " + collection +
+        " " + rest + ";");
+    std::vector<std::string> values;
+    while (rs.Next()) {
+      values.push_back(rs.IsNull(0) ? "null" : rs.GetString(0).str());
+    }
+    return values;
+  };
+
+  std::vector<std::pair<std::string, std::string>> queries{
+      {"user.name", "ORDER BY [user.name]"},
+      {"user.name", "ORDER BY [user.name] DESC"},
+      {"rating", "ORDER BY rating DESC"},
+      {"rating", "WHERE [user.id] = 3 ORDER BY rating"},
+      {"id", "WHERE [user.id] < 4 AND rating > 2 ORDER BY id DESC"},
+      {"user.name", "WHERE rating = 1.5 ORDER BY [user.name] DESC"}};
+  for (auto& query : queries) {
+    ASSERT_EQ(getValues("tweet_noindex", query.first, query.second),
+              getValues("tweet", query.first, query.second)) << query.second;
+  }
+
+  // The index returns the documents in order, SQLite does not sort them
+  auto rs = db.ExecuteSelect("EXPLAIN QUERY PLAN SELECT rating FROM tweet "
+                                 "ORDER BY rating DESC;");
+  while (rs.Next()) {
+    std::string detail = rs.GetString(3).str();
+    ASSERT_EQ(detail.find("TEMP B-TREE"), string::npos) << detail;
+  }
+
+  rs = db.ExecuteSelect("SELECT rating FROM tweet ORDER BY rating DESC;");
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(rs.Next());
+    ASSERT_EQ(rs.GetDouble(0), 9.75);
+  }
+}
+
+TEST(Database, Insert_UniqueHashIndex_MissingSubDocument) {
+  Database db(g_TestRootDirectory,
+              "Insert_UniqueHashIndex_MissingSubDocument",
+              TestUtils::GetDefaultDBOptions());
+  string filePath = GetSchemaFilePath("tweet.bfbs");
+  string schema = File::Read(filePath);
+  db.CreateCollection("tweet", SchemaType::FLAT_BUFFERS, schema,
+                      {IndexInfo("IndexName1", IndexType::UNIQUE_HASH,
+                                 "user.id", true)});
+
+  // Tweets without a user have a null user.id, nulls are not keys
+  std::vector<Buffer> documents;
+  for (int i = 0; i < 10; i++) {
+    FlatBufferBuilder fbb;
+    fbb.Finish(CreateTweet(fbb, i, 0, 0, i));
+    documents.push_back(Buffer((char*)fbb.GetBufferPointer(), fbb.GetSize(),
+                               fbb.GetSize()));
+  }
+  std::string name = "user";
+  documents.push_back(TestUtils::GetTweetObject(10, 7, &name, nullptr, 0,
+                                                nullptr));
+  db.MultiInsert("tweet", documents);
+  for (int i = 11; i < 13; i++) {
+    FlatBufferBuilder fbb;
+    fbb.Finish(CreateTweet(fbb, i, 0, 0, i));
+    db.Insert("tweet", Buffer((char*)fbb.GetBufferPointer(), fbb.GetSize(),
+                              fbb.GetSize()));
+  }
+
+  auto getCount = [&](const std::string& predicate) {
+    auto rs = db.ExecuteSelect("SELECT COUNT(*) FROM tweet WHERE " +
+        predicate + ";");
+    rs.Next();
+    return rs.GetInteger(0);
+  };
+  ASSERT_EQ(getCount("[user.id] = 7"), 1);
+  ASSERT_EQ(getCount("[user.id] = -9223372036854775808"), 0);
+  ASSERT_THROW(db.Insert("tweet", TestUtils::GetTweetObject(
+      13, 7, &name, nullptr, 0, nullptr)), JonoonDBException);
+}
@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+#include "mama_jennies_bitmap.h"
+
+using namespace jonoondb_api;
+
+namespace {
+std::vector<std::uint64_t> GetValues(MamaJenniesBitmap& bitmap) {
+  std::vector<std::uint64_t> values;
+  for (auto iter = bitmap.begin(); iter != bitmap.end(); ++iter) {
+    values.push_back(*iter);
+  }
+  return values;
+}
+
+std::shared_ptr<MamaJenniesBitmap> CreateBitmap(
+    const std::set<std::uint64_t>& values) {
+  auto bitmap = std::make_shared<MamaJenniesBitmap>();
+  for (auto value : values) {
+    bitmap->Add(value);
+  }
+  return bitmap;
+}
+}
+
+TEST(MamaJenniesBitmap, Add_OutOfOrder) {
+  MamaJenniesBitmap bitmap;
+  bitmap.Add(100);
+  bitmap.Add(5);
+  bitmap.Add(70000);
+  bitmap.Add(5);
+  ASSERT_TRUE(bitmap.IsRoaring());
+  std::vector<std::uint64_t> expected = {5, 100, 70000};
+  ASSERT_EQ(expected, GetValues(bitmap));
+  ASSERT_EQ(3, bitmap.GetCount());
+}
+
+TEST(MamaJenniesBitmap, Optimize_KeepsValues) {
+  // Sparse, dense and clustered chunks
+  std::set<std::uint64_t> values;
+  for (std::uint64_t i = 0; i < 100; i++) {
+    values.insert(i * 1000);
+  }
+  for (std::uint64_t i = 0; i < 10000; i++) {
+    values.insert(200000 + i * 3);
+  }
+  for (std::uint64_t i = 0; i < 20000; i++) {
+    values.insert(500000 + i);
+  }
+
+  auto bitmap = CreateBitmap(values);
+  bitmap->Optimize();
+  std::vector<std::uint64_t> expected(values.begin(), values.end());
+  ASSERT_EQ(expected, GetValues(*bitmap));
+  ASSERT_EQ(values.size(), bitmap->GetCount());
+
+  auto copy = *bitmap;
+  copy.Add(7);
+  ASSERT_EQ(values.size() + 1, copy.GetCount());
+  ASSERT_EQ(values.size(), bitmap->GetCount());
+}
+
+TEST(MamaJenniesBitmap, LogicalANDOR_MixedBackends) {
+  std::set<std::uint64_t> values1, values2;
+  for (std::uint64_t i = 0; i < 300000; i += 7) {
+    values1.insert(i);
+  }
+  for (std::uint64_t i = 0; i < 300000; i += 5) {
+    values2.insert(i);
+  }
+  values2.insert(300001);
+
+  auto ewah = CreateBitmap(values1);
+  auto roaring = CreateBitmap(values2);
+  // Force the second bitmap to Roaring with an out of order bit
+  roaring->Add(3);
+  values2.insert(3);
+  ASSERT_FALSE(ewah->IsRoaring());
+  ASSERT_TRUE(roaring->IsRoaring());
+
+  std::vector<std::uint64_t> expectedAnd, expectedOr;
+  for (auto value : values1) {
+    if (values2.count(value) > 0) {
+      expectedAnd.push_back(value);
+    }
+  }
+  std::set<std::uint64_t> unionValues(values1);
+  unionValues.insert(values2.begin(), values2.end());
+  expectedOr.assign(unionValues.begin(), unionValues.end());
+
+  std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps = {ewah, roaring};
+  ASSERT_EQ(expectedAnd, GetValues(*MamaJenniesBitmap::LogicalAND(bitmaps)));
+  ASSERT_EQ(expectedOr, GetValues(*MamaJenniesBitmap::LogicalOR(bitmaps)));
+
+  bitmaps = {roaring, ewah};
+  ASSERT_EQ(expectedAnd, GetValues(*MamaJenniesBitmap::LogicalAND(bitmaps)));
+  ASSERT_EQ(expectedOr, GetValues(*MamaJenniesBitmap::LogicalOR(bitmaps)));
+}
+
+TEST(MamaJenniesBitmap, AddWords_Roaring) {
+  MamaJenniesBitmap bitmap;
+  bitmap.Add(10);
+  bitmap.Add(1);
+  std::uint64_t words[] = {0x5, 0, ~std::uint64_t(0)};
+  // The words start after the 64 bits holding 1 and 10
+  bitmap.AddWords(words, 3);
+  auto values = GetValues(bitmap);
+  ASSERT_EQ(2 + 2 + 64, values.size());
+  ASSERT_EQ(64, values[2]);
+  ASSERT_EQ(66, values[3]);
+  ASSERT_EQ(192, values[4]);
+  ASSERT_EQ(255, values.back());
+}
+
+TEST(MamaJenniesBitmap, GetCount_TrackedThroughOperations) {
+  MamaJenniesBitmap bitmap;
+  ASSERT_TRUE(bitmap.IsEmpty());
+  std::uint64_t words[] = {0x3, ~std::uint64_t(0), 0, 0x10};
+  bitmap.AddWords(words, 4);
+  ASSERT_EQ(2 + 64 + 1, bitmap.GetCount());
+  ASSERT_FALSE(bitmap.IsEmpty());
+
+  auto evens = std::make_shared<MamaJenniesBitmap>();
+  auto odds = std::make_shared<MamaJenniesBitmap>();
+  for (std::uint64_t i = 0; i < 1000; i++) {
+    (i % 2 == 0 ? evens : odds)->Add(i);
+  }
+  auto empty = std::make_shared<MamaJenniesBitmap>();
+  std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps = {evens, odds};
+  ASSERT_TRUE(MamaJenniesBitmap::LogicalAND(bitmaps)->IsEmpty());
+  ASSERT_EQ(1000, MamaJenniesBitmap::LogicalOR(bitmaps)->GetCount());
+
+  bitmaps = {evens, empty, odds};
+  ASSERT_TRUE(MamaJenniesBitmap::LogicalAND(bitmaps)->IsEmpty());
+
+  // Out of order adds move the bitmap to Roaring, duplicates do not count
+  evens->Add(4);
+  evens->Add(3);
+  ASSERT_EQ(501, evens->GetCount());
+  bitmaps = {evens, odds};
+  ASSERT_EQ(1, MamaJenniesBitmap::LogicalAND(bitmaps)->GetCount());
+}
+
+TEST(MamaJenniesBitmap, LogicalOR_ManyBitmaps) {
+  // Dense inputs are accumulated word by word, sparse ones merged by heap
+  for (std::uint64_t stride : {1, 100000}) {
+    std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps;
+    std::set<std::uint64_t> expected;
+    for (std::uint64_t i = 0; i < 50; i++) {
+      std::set<std::uint64_t> values;
+      for (std::uint64_t j = 0; j < 40; j++) {
+        values.insert((i * 7 + j * 13) * stride);
+      }
+      // A run of ones and a value shared by every bitmap
+      for (std::uint64_t j = 0; j < 200; j++) {
+        values.insert(10000 * stride + j);
+      }
+      expected.insert(values.begin(), values.end());
+      bitmaps.push_back(CreateBitmap(values));
+    }
+    bitmaps[3]->Add(5);
+    expected.insert(5);
+
+    auto result = MamaJenniesBitmap::LogicalOR(bitmaps);
+    std::vector<std::uint64_t> expectedValues(expected.begin(), expected.end());
+    ASSERT_EQ(expectedValues, GetValues(*result));
+    ASSERT_EQ(expected.size(), result->GetCount());
+  }
+}
+
+TEST(MamaJenniesBitmap, Decoder_MatchesIterator) {
+  MamaJenniesBitmap ewah;
+  std::uint64_t words[] = {0x8001, ~std::uint64_t(0), ~std::uint64_t(0), 0, 0,
+                           0x5, 1ULL << 63};
+  ewah.AddWords(words, 7);
+
+  // A bitset, array and run container
+  std::set<std::uint64_t> values;
+  for (std::uint64_t i = 0; i < 65536; i += 3) {
+    values.insert(i);
+  }
+  for (std::uint64_t i = 0; i < 2000; i++) {
+    values.insert(100000 + i * 1000);
+  }
+  for (std::uint64_t i = 0; i < 20000; i++) {
+    values.insert(5000000 + i);
+  }
+  auto roaring = CreateBitmap(values);
+  roaring->Add(1);
+  roaring->Optimize();
+  ASSERT_TRUE(roaring->IsRoaring());
+
+  for (auto bitmap : {&ewah, roaring.get()}) {
+    auto expected = GetValues(*bitmap);
+    // Capacities that end the batches inside words, runs and containers
+    for (std::size_t capacity : {1, 7, 64, 5000}) {
+      MamaJenniesBitmapDecoder decoder(*bitmap);
+      std::vector<std::uint64_t> positions(capacity);
+      std::vector<std::uint64_t> decoded;
+      std::size_t count;
+      while ((count = decoder.Decode(positions.data(), capacity)) > 0) {
+        decoded.insert(decoded.end(), positions.begin(),
+                       positions.begin() + count);
+      }
+      ASSERT_EQ(expected, decoded);
+    }
+  }
+}
+
+TEST(MamaJenniesBitmap, CreateRange) {
+  for (std::uint64_t count : {0, 1, 64, 100, 1000}) {
+    auto range = MamaJenniesBitmap::CreateRange(count);
+    ASSERT_EQ(count, range->GetCount());
+    auto values = GetValues(*range);
+    ASSERT_EQ(count, values.size());
+    for (std::uint64_t i = 0; i < values.size(); i++) {
+      ASSERT_EQ(i, values[i]);
+    }
+  }
+
+  // A billion ids take a few words
+  auto range = MamaJenniesBitmap::CreateRange(1000000000);
+  MamaJenniesBitmapDecoder decoder(*range);
+  std::uint64_t positions[4];
+  ASSERT_EQ(4, decoder.Decode(positions, 4));
+  ASSERT_EQ(3, positions[3]);
+
+  auto sparse = CreateBitmap({5, 70, 999999999, 1000000005});
+  std::vector<std::shared_ptr<MamaJenniesBitmap>> bitmaps = {range, sparse};
+  std::vector<std::uint64_t> expected = {5, 70, 999999999};
+  ASSERT_EQ(expected, GetValues(*MamaJenniesBitmap::LogicalAND(bitmaps)));
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "scan_kernels.h"
+
+using namespace jonoondb_api;
+
+// Between runs the AVX2 kernels on CPUs that support AVX2, Matching always
+// runs the scalar kernel. The counts cover empty input, partial words and
+// full words.
+namespace {
+const std::vector<std::size_t> g_counts = {0, 1, 31, 63, 64, 65, 200, 4097};
+
+std::vector<std::uint64_t> GetWords(std::size_t count) {
+  return std::vector<std::uint64_t>(count / 64 + 1, 0);
+}
+
+template<typename T>
+std::vector<T> GetIntegers(std::size_t count) {
+  std::mt19937_64 generator(count);
+  std::vector<T> candidates = {std::numeric_limits<T>::min(),
+                               std::numeric_limits<T>::max(), -1, 0, 1, 5};
+  std::vector<T> values;
+  for (std::size_t i = 0; i < count; i++) {
+    if (generator() % 4 == 0) {
+      values.push_back(candidates[generator() % candidates.size()]);
+    } else {
+      values.push_back(static_cast<T>(generator() % 21) - 10);
+    }
+  }
+  return values;
+}
+
+template<typename T>
+void CheckIntegerKernel() {
+  std::vector<std::pair<T, T>> ranges = {
+      {-5, 5}, {0, 0}, {std::numeric_limits<T>::min(), 0},
+      {0, std::numeric_limits<T>::max()},
+      {std::numeric_limits<T>::min(), std::numeric_limits<T>::max()}};
+  for (auto count : g_counts) {
+    auto values = GetIntegers<T>(count);
+    for (auto& range : ranges) {
+      auto lower = range.first;
+      auto upper = range.second;
+      auto words = GetWords(count);
+      auto expected = GetWords(count);
+      ScanKernels::Between(values.data(), count, lower, upper, words.data());
+      ScanKernels::Matching(values.data(), count, [lower, upper](T val) {
+        return val >= lower && val <= upper;
+      }, expected.data());
+      ASSERT_EQ(expected, words) << "count " << count << " range ["
+          << std::int64_t(lower) << ", " << std::int64_t(upper) << "]";
+    }
+  }
+}
+
+template<typename T>
+void CheckFloatingPointKernel() {
+  std::vector<T> candidates = {
+      -1.5, 0, 1, 2.5, 3, std::numeric_limits<T>::quiet_NaN(),
+      std::numeric_limits<T>::infinity(), -std::numeric_limits<T>::infinity(),
+      std::numeric_limits<T>::min()};
+  for (auto count : g_counts) {
+    std::mt19937_64 generator(count);
+    std::vector<T> values;
+    for (std::size_t i = 0; i < count; i++) {
+      values.push_back(candidates[generator() % candidates.size()]);
+    }
+
+    for (int bounds = 0; bounds < 4; bounds++) {
+      bool lowerInclusive = (bounds & 1) != 0;
+      bool upperInclusive = (bounds & 2) != 0;
+      T lower = 0, upper = 3;
+      auto words = GetWords(count);
+      auto expected = GetWords(count);
+      ScanKernels::Between(values.data(), count, lower, lowerInclusive,
+                           upper, upperInclusive, words.data());
+      ScanKernels::Matching(values.data(), count, [&](T val) {
+        return (lowerInclusive ? val >= lower : val > lower) &&
+            (upperInclusive ? val <= upper : val < upper);
+      }, expected.data());
+      ASSERT_EQ(expected, words) << "count " << count << " bounds " << bounds;
+    }
+  }
+}
+}
+
+TEST(ScanKernels, Between_Int8) {
+  CheckIntegerKernel<std::int8_t>();
+}
+
+TEST(ScanKernels, Between_Int16) {
+  CheckIntegerKernel<std::int16_t>();
+}
+
+TEST(ScanKernels, Between_Int32) {
+  CheckIntegerKernel<std::int32_t>();
+}
+
+TEST(ScanKernels, Between_Int64) {
+  CheckIntegerKernel<std::int64_t>();
+}
+
+TEST(ScanKernels, Between_Float) {
+  CheckFloatingPointKernel<float>();
+}
+
+TEST(ScanKernels, Between_Double) {
+  CheckFloatingPointKernel<double>();
+}